@@ -0,0 +1,30 @@
+#pragma once
+
+#include <qopengl.h>
+
+// Stands in for the QOpenGLWidget based OpenGLContext so that world
+// generation and chunk meshing can run without a window or a GPU.
+// Buffer calls hand out fake handles and drop their data.
+class OpenGLContext
+{
+private:
+    GLuint m_nextHandle;
+
+public:
+    OpenGLContext() : m_nextHandle(1) {}
+
+    void glGenBuffers(GLsizei n, GLuint *buffers) {
+        for (GLsizei i = 0; i < n; ++i) {
+            buffers[i] = m_nextHandle++;
+        }
+    }
+    void glBindBuffer(GLenum, GLuint) {}
+    void glBufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+    void glBufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+    void glDeleteBuffers(GLsizei, const GLuint*) {}
+    // Referenced by ShaderProgram's inline helpers
+    GLint glGetAttribLocation(GLuint, const char*) { return -1; }
+    GLint glGetUniformLocation(GLuint, const char*) { return -1; }
+
+    void printGLErrorLog() {}
+};
@@ -0,0 +1,155 @@
+#include "scene/terrain.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Generates and meshes an N x N block of chunks from a fixed seed on one
+// thread and prints the timings as JSON, so the numbers can be compared
+// between commits. Usage: worldgenbench [N = 8] [seed = 277]
+
+// Every heap allocation is counted so that changes to the garbage
+// produced by generation and meshing show up in the report
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> allocatedBytes(0);
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    allocatedBytes += size;
+    if (void *p = std::malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Peak resident set size of the process in kilobytes, -1 if unknown
+static long peakRSSKilobytes() {
+#if defined(__APPLE__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+#elif defined(__unix__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return -1;
+#endif
+}
+
+struct Phase {
+    double seconds;
+    size_t allocations;
+    size_t bytes;
+};
+
+// Times fn and counts the allocations it makes
+template <typename F>
+static Phase measure(F fn) {
+    size_t allocations = allocationCount, bytes = allocatedBytes;
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return Phase{std::chrono::duration<double>(end - start).count(),
+                 allocationCount - allocations, allocatedBytes - bytes};
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? std::atoi(argv[1]) : 8;
+    unsigned int seed = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 277;
+    if (n <= 0) {
+        std::fprintf(stderr, "usage: %s [N] [seed]\n", argv[0]);
+        return 1;
+    }
+    // Trees, ores and grass patches are placed with rand()
+    std::srand(seed);
+
+    OpenGLContext context;
+    Terrain terrain(&context);
+    std::vector<Chunk*> chunks;
+    for (int x = 0; x < n; ++x) {
+        for (int z = 0; z < n; ++z) {
+            chunks.push_back(terrain.instantiateChunkAt(16 * x, 16 * z));
+        }
+    }
+
+    Phase generation = measure([&]() {
+        for (Chunk *c : chunks) {
+            glm::ivec2 min = c->getMin();
+            terrain.fillChunk(c, min.x, min.y);
+        }
+    });
+
+    // Sky and block light flood fill, the same as BlockWorker does after
+    // filling, then joining it up across the borders as the main thread does
+    std::unordered_set<Chunk*> relit;
+    Phase lighting = measure([&]() {
+        for (Chunk *c : chunks) {
+            c->computeLight();
+        }
+        for (Chunk *c : chunks) {
+            terrain.chunkLit(c, relit);
+        }
+    });
+
+    // Includes the LOD meshes, which are built with the full detail mesh
+    Phase meshing = measure([&]() {
+        for (Chunk *c : chunks) {
+            c->generateVBOdata(MESH_ALL);
+        }
+    });
+
+    // Uploading to the stub context only fills in the index counts
+    long faces = 0, lodFaces = 0;
+    for (Chunk *c : chunks) {
+        c->createVBOdata();
+        faces += (c->elemCount(INDEX) + c->elemCount(TRANSPARENT_INDEX) + c->elemCount(FLUID_INDEX)) / 6;
+        lodFaces += c->elemCount(LOD_INDEX) / 6;
+    }
+
+    double chunkCount = static_cast<double>(chunks.size());
+    std::printf("{\n");
+    std::printf("  \"benchmark\": \"worldgen\",\n");
+    std::printf("  \"grid\": %d,\n", n);
+    std::printf("  \"chunks\": %zu,\n", chunks.size());
+    std::printf("  \"seed\": %u,\n", seed);
+    std::printf("  \"generation\": {\n");
+    std::printf("    \"seconds\": %.6f,\n", generation.seconds);
+    std::printf("    \"chunks_per_sec\": %.3f,\n", chunkCount / generation.seconds);
+    std::printf("    \"ns_per_column\": %.1f,\n", generation.seconds * 1e9 / (chunkCount * 256));
+    std::printf("    \"allocations\": %zu,\n", generation.allocations);
+    std::printf("    \"allocated_bytes\": %zu\n", generation.bytes);
+    std::printf("  },\n");
+    std::printf("  \"lighting\": {\n");
+    std::printf("    \"seconds\": %.6f,\n", lighting.seconds);
+    std::printf("    \"chunks_per_sec\": %.3f,\n", chunkCount / lighting.seconds);
+    std::printf("    \"allocations\": %zu,\n", lighting.allocations);
+    std::printf("    \"allocated_bytes\": %zu\n", lighting.bytes);
+    std::printf("  },\n");
+    std::printf("  \"meshing\": {\n");
+    std::printf("    \"seconds\": %.6f,\n", meshing.seconds);
+    std::printf("    \"chunks_per_sec\": %.3f,\n", chunkCount / meshing.seconds);
+    std::printf("    \"faces\": %ld,\n", faces);
+    std::printf("    \"lod_faces\": %ld,\n", lodFaces);
+    std::printf("    \"ns_per_face\": %.1f,\n", faces > 0 ? meshing.seconds * 1e9 / faces : 0.0);
+    std::printf("    \"allocations\": %zu,\n", meshing.allocations);
+    std::printf("    \"allocated_bytes\": %zu\n", meshing.bytes);
+    std::printf("  },\n");
+    std::printf("  \"peak_rss_kb\": %ld\n", peakRSSKilobytes());
+    std::printf("}\n");
+    return 0;
+}
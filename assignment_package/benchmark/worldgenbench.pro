@@ -0,0 +1,28 @@
+# Headless world generation benchmark. Builds the terrain, noise, asset and
+# chunk meshing code against a stub OpenGLContext, so no window or GPU is needed.
+QT += core gui opengl multimedia
+TARGET = worldgenbench
+TEMPLATE = app
+CONFIG += console
+CONFIG += c++1z
+CONFIG += release
+CONFIG -= app_bundle
+
+# The stub OpenGLContext has to be found before the real one in ../src
+INCLUDEPATH += $$PWD/stub $$PWD/../src $$PWD/../src/scene $$PWD/../include
+
+SOURCES += \
+    $$PWD/worldgenbench.cpp \
+    $$PWD/stub/shaderprogram_stub.cpp \
+    $$PWD/../src/drawable.cpp \
+    $$PWD/../src/noise.cpp \
+    $$PWD/../src/profiler.cpp \
+    $$PWD/../src/scene/asset.cpp \
+    $$PWD/../src/scene/blockedits.cpp \
+    $$PWD/../src/scene/chunk.cpp \
+    $$PWD/../src/scene/cube.cpp \
+    $$PWD/../src/scene/lightengine.cpp \
+    $$PWD/../src/scene/terrain.cpp
+
+HEADERS += \
+    $$PWD/stub/openglcontext.h
@@ -0,0 +1,27 @@
+#version 330 core
+
+// Cuts the same holes as lambert.frag.glsl so leaves and cactus edges don't
+// hide what is behind them, and writes nothing but depth
+
+uniform sampler2DArray u_Texture;
+uniform int u_Time;
+
+in vec4 fs_UV;
+flat in float fs_Layer;
+
+void main()
+{
+    vec2 uv = vec2(fs_UV);
+
+    // Animate Water and Lava
+    if (fs_UV.z == 1) {
+        float range = 2.0;
+        float speed = 0.005;
+        float offset = mod(u_Time * speed, 1.0) * range;
+        uv.x += offset;
+    }
+
+    if (texture(u_Texture, vec3(uv, fs_Layer + floor(uv.x))).a < 0.5) {
+        discard;
+    }
+}
@@ -0,0 +1,46 @@
+#version 330 core
+
+// Depth pre-pass of the solid Chunk meshes. The position has to come out
+// exactly the same as in lambert.vert.glsl for the color pass to pass its
+// GL_EQUAL depth test, so it is worked out the same way and declared invariant
+// in both.
+
+uniform mat4 u_Model;
+uniform mat4 u_ViewProj;
+
+in vec4 vs_Pos;
+in vec4 vs_Nor;
+in vec4 vs_UV;
+
+out vec4 fs_UV;
+flat out float fs_Layer;
+
+invariant gl_Position;
+
+void main()
+{
+    fs_UV = vs_UV;
+    fs_Layer = vs_Nor.w;
+
+    vec4 modelposition = vec4(vs_Pos.xyz, 1);
+
+    //Cactus
+    if (vs_UV.w == 2) {
+        modelposition.y -= 0.04f;
+    }
+
+    if (vs_UV.w == 3) {
+        modelposition.x -= 0.08f;
+    } else if (vs_UV.w == -3) {
+        modelposition.x += 0.08f;
+    }
+
+    if (vs_UV.w == 4) {
+        modelposition.z -= 0.08f;
+    } else if (vs_UV.w == -4) {
+        modelposition.z += 0.08f;
+    }
+
+    modelposition = u_Model * modelposition;
+    gl_Position = u_ViewProj * modelposition;
+}
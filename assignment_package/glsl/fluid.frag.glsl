@@ -8,9 +8,13 @@ uniform int inLava;
 in vec4 fs_UV;
 uniform int u_Time;
 uniform sampler2D u_Texture;
+uniform sampler2D u_NoiseTexture; // Baked fbm in red and Worley distance in green, see NoiseTextures
+uniform int u_BakedNoise; // 1 to sample u_NoiseTexture, 0 to work the noise out here
 
 out vec4 out_Col;
 
+const float noiseCells = 8.0; // NoiseTextures::NOISE_CELLS, Worley cells across u_NoiseTexture
+
 
 float random1( vec2 p ) {
     return fract(sin((dot(vec3(p, 0.5), vec3(127.1,
@@ -93,6 +97,25 @@ float fbm(float x, float y) {
     return total;
 }
 
+// The baked or the analytic WorleyNoise
+float worley(vec2 uv) {
+    if (u_BakedNoise == 1) {
+        // The baked points can't wobble on their own, so the pattern circles instead
+        float animatedTime = u_Time * 0.05;
+        vec2 wobble = vec2(sin(animatedTime), cos(animatedTime)) * 0.25;
+        return smoothstep(0.0, 1.0, texture(u_NoiseTexture, (uv * 7.0 + wobble) / noiseCells).g);
+    }
+    return WorleyNoise(uv);
+}
+
+// How far the lava warps the screen at uv
+vec2 lavaDistortion(vec2 uv) {
+    if (u_BakedNoise == 1) {
+        // The baked fbm repeats every 1, so the second lookup is moved by a fraction instead of by 12
+        return vec2(texture(u_NoiseTexture, uv).r, texture(u_NoiseTexture, uv + vec2(0.37, 0.61)).r);
+    }
+    return vec2(fbm(uv.x, uv.y), fbm(uv.x + 12, uv.y + 12));
+}
 
 void main()
 {
@@ -100,26 +123,22 @@ void main()
 
     vec2 uv = vec2(fs_UV);
     vec4 diffuseColor = texture(u_Texture, uv);
+    vec3 col = diffuseColor.rgb;
+    // The effects are chained, so both apply in this one pass if both are on.
+    // With neither on this pass only upscales the scene.
     if (inWater == 1) {
         vec3 waterTint = vec3(0.0, 0.5, 1.0);  // Light blue color for the water tint
 
-
-        float noise = WorleyNoise(uv);
-        vec3 col = vec3((noise) * diffuseColor.r,(noise) * diffuseColor.g, (noise) * diffuseColor.b);
-
-        out_Col = vec4(mix(col, waterTint, 0.35), diffuseColor.a);
-
-
-    } else if (inLava == 1) {
-        vec3 lavaTint = vec3(1.0, 0.25, 0.0);  // Light orange color for the lava tint
-        vec2 distortedUV = uv + (vec2(fbm(uv.x, uv.y), fbm(uv.x + 12, uv.y + 12)));
-
-        float noise = WorleyNoise(distortedUV);
-        vec3 col = vec3(diffuseColor.r,  diffuseColor.g,  diffuseColor.b);
-          // Blend the water tint with the base diffuseColor
-        out_Col = vec4(mix(col, lavaTint, noise), diffuseColor.a);
-    } else {
-        out_Col = vec4(diffuseColor.r,  diffuseColor.g, diffuseColor.b , diffuseColor.a);
+        float noise = worley(uv);
+        col = mix(noise * col, waterTint, 0.35);
     }
+    if (inLava == 1) {
+        vec3 lavaTint = vec3(1.0, 0.25, 0.0);  // Light orange color for the lava tint
+        vec2 distortedUV = uv + lavaDistortion(uv);
 
+        float noise = worley(distortedUV);
+        // Blend the lava tint with the color so far
+        col = mix(col, lavaTint, noise);
+    }
+    out_Col = vec4(col, diffuseColor.a);
 }
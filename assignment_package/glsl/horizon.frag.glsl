@@ -0,0 +1,36 @@
+#version 330 core
+
+uniform vec3 u_CamPos;
+uniform float u_FogStart;
+uniform float u_FogEnd;
+uniform sampler2D u_SkyLUT; // See skylut.frag.glsl
+
+in vec4 fs_Pos;
+in vec4 fs_Nor;
+in vec4 fs_Col;
+in vec4 fs_LightVec;
+
+out vec4 out_Col;
+
+const float PI = 3.14159265359;
+const float TWO_PI = 6.28318530718;
+
+// Where a direction is stored in the sky LUT, the same as in sky.frag.glsl
+vec2 skyLUTCoord(vec3 dir) {
+    return vec2(atan(dir.z, dir.x) / TWO_PI + 0.5,
+                asin(clamp(dir.y, -1.0, 1.0)) / PI + 0.5);
+}
+
+void main()
+{
+    float diffuseTerm = clamp(dot(normalize(fs_Nor), normalize(fs_LightVec)), 0, 1);
+    float ambientTerm = 0.2;
+    vec3 shadedColor = fs_Col.rgb * (diffuseTerm + ambientTerm);
+
+    // Fade into the sky behind it so the far edge of the world disappears
+    vec3 toFragment = fs_Pos.xyz - u_CamPos;
+    vec3 fogColor = texture(u_SkyLUT, skyLUTCoord(normalize(toFragment))).rgb;
+    float blockDistance = length(toFragment);
+    float fogFactor = clamp((blockDistance - u_FogStart) / (u_FogEnd - u_FogStart), 0.0, 1.0);
+    out_Col = vec4(mix(shadedColor, fogColor, fogFactor), 1);
+}
@@ -0,0 +1,36 @@
+#version 330 core
+
+// Draws the coarse heightfield beyond the loaded Chunks.
+// Refer to lambert.vert.glsl for an explanation of the day cycle.
+
+uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+uniform int u_Time;
+
+in vec4 vs_Pos;
+in vec4 vs_Nor;
+in vec4 vs_Col;             // The biome color of each height sample
+
+out vec4 fs_Pos;
+out vec4 fs_Nor;
+out vec4 fs_Col;
+out vec4 fs_LightVec;
+
+const float PI = 3.14159265359;
+const float TWO_PI = 6.28318530718;
+
+const float dayCycleSpeed = (TWO_PI / (60 * 60 * 24));
+
+vec3 computeSunDirection() {
+    float start = PI / 2.f;
+    float angle = mod(u_Time * dayCycleSpeed + start, TWO_PI);
+    return vec3(cos(angle), sin(angle), 0);
+}
+
+void main()
+{
+    fs_Pos = vs_Pos;
+    fs_Nor = vs_Nor;
+    fs_Col = vs_Col;
+    fs_LightVec = vec4(computeSunDirection(), 0);
+    gl_Position = u_ViewProj * vs_Pos;
+}
@@ -13,23 +13,39 @@ uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformati
 
 in vec4 vs_Pos;             // The array of vertex positions passed to the shader
 in vec4 vs_Nor;             // The array of vertex normals passed to the shader
+in vec4 vs_UV;              // Where the vertex lies on its instance's tile
 
 in vec3 vs_ColInstanced;    // The array of vertex colors passed to the shader.
 in vec3 vs_OffsetInstanced; // Used to position each instance of the cube
+in vec4 vs_ShapeInstanced;  // Size of each instance's box in xyz, texture array layer in w
 
 out vec4 fs_Pos;
 out vec4 fs_Nor;            // The array of normals that has been transformed by u_ModelInvTr. This is implicitly passed to the fragment shader.
 out vec4 fs_LightVec;       // The direction in which our virtual light lies, relative to each vertex. This is implicitly passed to the fragment shader.
 out vec4 fs_Col;            // The color of each vertex. This is implicitly passed to the fragment shader.
 out vec4 fs_UV;
+flat out float fs_Layer;
+out float fs_SkyLight;
+out float fs_BlockLight;
+out vec3 fs_ShadowCoord0;
+out vec3 fs_ShadowCoord1;
+out vec3 fs_ShadowCoord2;
 
 const vec4 lightDir = normalize(vec4(0.5, 1, 0.75, 0));  // The direction of our virtual light, which is used to compute the shading of
                                         // the geometry in the fragment shader.
 
 void main()
 {
-    fs_UV = vec4(0.);
-    vec4 offsetPos = vs_Pos + vec4(vs_OffsetInstanced, 0.);
+    // Kept below 1 so sampleTile doesn't step into the next layer
+    fs_UV = vec4(min(vs_UV.xy, vec2(0.999)), 0., 0.);
+    fs_Layer = vs_ShapeInstanced.w;
+    // Fully lit, and outside every shadow map cascade
+    fs_SkyLight = 1.;
+    fs_BlockLight = 0.;
+    fs_ShadowCoord0 = vec3(-1.);
+    fs_ShadowCoord1 = vec3(-1.);
+    fs_ShadowCoord2 = vec3(-1.);
+    vec4 offsetPos = vec4(vs_Pos.xyz * vs_ShapeInstanced.xyz + vs_OffsetInstanced, 1.);
     fs_Pos = offsetPos;
     fs_Col = vec4(vs_ColInstanced, 1.);                         // Pass the vertex colors to the fragment shader for interpolation
 
@@ -12,10 +12,15 @@
 // can compute what color to apply to its pixel based on things like vertex
 // position, light position, and vertex color.
 
-uniform sampler2D u_Texture;
+uniform sampler2DArray u_Texture; // One layer per tile of the block atlas
 uniform int u_Time;
 uniform vec4 u_Color; // The color with which to render this instance of geometry.
 uniform vec3 u_CamPos;
+uniform float u_FogStart; // Distance from the camera at which fog begins
+uniform float u_FogEnd; // Distance from the camera at which fog is opaque
+uniform sampler2DArrayShadow u_ShadowMap; // One layer per cascade, nearest first
+uniform int u_ShadowsOn; // 0 at night, when the shadow maps hold nothing
+uniform sampler2D u_SkyLUT; // The sky's color by direction, see skylut.frag.glsl
 
 uniform int switchBiome;
 uniform int inLava;
@@ -27,21 +32,46 @@ in vec4 fs_Nor;
 in vec4 fs_LightVec;
 // in vec4 fs_Col;
 in vec4 fs_UV;
+flat in float fs_Layer; // The texture array layer of this face's tile
+in float fs_SkyLight; // Baked sky and block light, see lambert.vert.glsl
+in float fs_BlockLight;
+in vec3 fs_ShadowCoord0; // This fragment's position in each shadow map cascade
+in vec3 fs_ShadowCoord1;
+in vec3 fs_ShadowCoord2;
 
 in float fs_dayCycleSpeed;
 
 out vec4 out_Col; // This is the final output color that you will see on your
 // screen for the pixel that is currently being processed.
 
-// Compute sky color for the fog
-// values used for ray casting
-uniform vec3 eye; // camera's position vector
-uniform vec3 R; // camera's right vector
-uniform vec3 U; // camera's up vector
-uniform vec3 F; // camera's forward vector
-uniform float aspect;
-const float fovy = 45;
+// Samples a tile of the texture array. UVs past the right edge of the tile
+// carry on into the next layer, the same as the next tile over in the atlas.
+vec4 sampleTile(vec2 uv, float layer) {
+    return texture(u_Texture, vec3(uv, layer + floor(uv.x)));
+}
+
+// Whether coord lies inside a cascade, leaving room for the filter at the edges
+bool inCascade(vec3 coord) {
+    return all(greaterThan(coord, vec3(0.002))) && all(lessThan(coord, vec3(0.998)));
+}
 
+// How much of the sun reaches this fragment, 0 to 1. The finest cascade
+// covering it is used; the hardware compares four texels and blends them.
+float sunVisibility() {
+    if (u_ShadowsOn == 0) {
+        return 1.0;
+    }
+    if (inCascade(fs_ShadowCoord0)) {
+        return texture(u_ShadowMap, vec4(fs_ShadowCoord0.xy, 0, fs_ShadowCoord0.z));
+    }
+    if (inCascade(fs_ShadowCoord1)) {
+        return texture(u_ShadowMap, vec4(fs_ShadowCoord1.xy, 1, fs_ShadowCoord1.z));
+    }
+    if (inCascade(fs_ShadowCoord2)) {
+        return texture(u_ShadowMap, vec4(fs_ShadowCoord2.xy, 2, fs_ShadowCoord2.z));
+    }
+    return 1.0;
+}
 
 float random1( vec2 p ) {
     return fract(sin((dot(vec3(p, 0.5), vec3(127.1,
@@ -126,143 +156,15 @@ float fbm(float x, float y) {
 }
 
 
-// Sunset palette
-const vec3 sunset[5] = vec3[](vec3(255, 229, 119) / 255.0,
-                                vec3(254, 192, 81) / 255.0,
-                                vec3(255, 137, 103) / 255.0,
-                                vec3(253, 96, 81) / 255.0,
-                                vec3(57, 32, 51) / 255.0);
-
-// Dusk palette
-const vec3 dusk[5] = vec3[](vec3(144, 96, 144) / 255.0,
-                                vec3(96, 72, 120) / 255.0,
-                                vec3(72, 48, 120) / 255.0,
-                                vec3(48, 24, 96) / 255.0,
-                                vec3(0, 24, 72) / 255.0);
-
-const vec3 daySkyCol = vec3(0.3686, 0.741, 1);
-const vec3 nightSkyCol = vec3(0.05, 0.05, 0.1);
-
-// Noise function that returns a random 3D point given a 3D point
-vec3 random3(vec3 p) {
-    return fract(sin(vec3(dot(p,vec3(127.1, 311.7, 191.999)),
-                          dot(p,vec3(269.5, 183.3, 765.54)),
-                          dot(p, vec3(420.69, 631.2,109.21))))
-                 *43758.5453);
-}
+const vec3 lavaLightColor = vec3(1.0, 0.8, 0.55);
 
-// Generate worley noise given a 3D point
-float WorleyNoise3D(vec3 p)
-{
-    // Tile the space
-    vec3 pointInt = floor(p);
-    vec3 pointFract = fract(p);
-
-    float minDist = 1.0; // Minimum distance initialized to max.
-
-    // Search all neighboring cells and this cell for their point
-    for(int z = -1; z <= 1; z++)
-    {
-        for(int y = -1; y <= 1; y++)
-        {
-            for(int x = -1; x <= 1; x++)
-            {
-                vec3 neighbor = vec3(float(x), float(y), float(z));
-
-                // Random point inside current neighboring cell
-                vec3 point = random3(pointInt + neighbor);
-
-                // Animate the point
-                point = 0.5 + 0.5 * sin(u_Time * 0.01 + 6.2831 * point); // 0 to 1 range
-
-                // Compute the distance b/t the point and the fragment
-                // Store the min dist thus far
-                vec3 diff = neighbor + point - pointFract;
-                float dist = length(diff);
-                minDist = min(minDist, dist);
-            }
-        }
-    }
-    return minDist;
-}
+const float PI = 3.14159265359;
+const float TWO_PI = 6.28318530718;
 
-float fractalWorley(vec3 rayDir) {
-    float amp = 0.5;
-    float freq = 1.0;
-    float sum = 0;
-    for (int i = 0; i < 4; ++i) {
-        sum += WorleyNoise3D(rayDir * freq) * amp;
-        amp *= 0.5;
-        freq *= 2;
-    }
-    return sum;
-}
-
-struct Ray {
-    vec3 origin;
-    vec3 direction;
-};
-
-// formula for ray casting
-Ray raycast() {
-    vec3 ref = eye + F;
-    float len = 1;
-    vec3 V = U * len * tan(radians(fovy / 2.f));
-    vec3 H = R * len * tan(radians(fovy / 2.f)) * aspect;
-
-    float sx = fs_UV.x * 2 - 1;
-    float sy = fs_UV.y * 2 - 1;
-
-    vec3 p = ref + sx * H + sy * V;
-    Ray ray;
-    ray.origin = eye;
-    ray.direction = normalize(p - eye);
-
-    return ray;
-}
-
-vec3 sunsetLerp(float t) {
-    t *= 4;
-    float tFract = fract(t);
-    int tLow = int(floor(t));
-    int tHigh = tLow + 1;
-    return mix(sunset[tLow], sunset[tHigh], tFract);
-}
-
-vec3 duskLerp(float t) {
-    t *= 4;
-    float tFract = fract(t);
-    int tLow = int(floor(t));
-    int tHigh = tLow + 1;
-    return mix(dusk[tLow], dusk[tHigh], tFract);
-}
-
-vec3 skyColor(vec3 rayDir, vec3 sunDir) {
-    // compute the sun's elevation
-    float sunElevation = clamp(dot(sunDir, vec3(0, 1, 0)), -1.0, 1.0);
-
-    // Transition between day and night colors based on sun elevation
-    vec3 skyBaseCol = mix(nightSkyCol, daySkyCol, max(sunElevation, 0.0));
-
-    // Use Worley Noise to create clouds
-    float t = clamp(dot(rayDir, vec3(0, 1, 0)), 0, 1);
-    float worley = fractalWorley(rayDir * 10);
-    worley = fract(worley) * 0.2;
-    t = clamp(t + worley, 0, 1);
-
-    // Compute the sunset and dusk colors
-    float t2 = clamp(dot(rayDir, sunDir), 0, 1);
-    vec3 settingCol = mix(duskLerp(t), sunsetLerp(t), t2);
-
-    // Transition between skyBaseCol and settingCol based on the sun's elevation
-    float transitionFactor = smoothstep(-1, 1, sunElevation);
-    vec3 finalSkyCol;
-    if (sunElevation > 0) {
-        finalSkyCol = mix(settingCol, skyBaseCol, transitionFactor);
-    } else {
-        finalSkyCol = mix(settingCol, skyBaseCol, 1 - transitionFactor);
-    }
-    return finalSkyCol;
+// Where a direction is stored in the sky LUT, the same as in sky.frag.glsl
+vec2 skyLUTCoord(vec3 dir) {
+    return vec2(atan(dir.z, dir.x) / TWO_PI + 0.5,
+                asin(clamp(dir.y, -1.0, 1.0)) / PI + 0.5);
 }
 
 
@@ -272,7 +174,7 @@ void main()
 
     // Animate Water and Lava
     if (fs_UV.z == 1) {
-        float range = 2.0 / 16.0;
+        float range = 2.0;
         float speed = 0.005;
         float offset = mod(u_Time * speed, 1.0) * range;
         float startX = uv.x;
@@ -280,7 +182,7 @@ void main()
     }
 
     // Material base color (before shading)
-    vec4 diffuseColor = texture(u_Texture, uv); // fs_Col;
+    vec4 diffuseColor = sampleTile(uv, fs_Layer); // fs_Col;
 
     if (diffuseColor.a < 0.5f ) {
         discard; // Skip rendering this fragment
@@ -288,8 +190,7 @@ void main()
 
     //SNOW GRASS PATCH
     if (fs_UV.w == -7) {
-            vec2 snow = vec2(uv.x + 1.f/16.f, uv.y + 5.f/16.f);
-            vec4 snowColor = texture(u_Texture, snow);
+            vec4 snowColor = sampleTile(uv, fs_Layer + 1 + 16 * 5);
 
               vec2 pos2D = fs_Pos.xy;
               float radius = 8;
@@ -305,8 +206,7 @@ void main()
              diffuseColor = finalColor;
     } else if (fs_UV.w == -8) {
         //DIRT GRASS PATCH
-         vec2 grass = vec2(uv.x + 6.f/16.f, uv.y + 8.f/16.f);
-         vec4 grassColor = texture(u_Texture, grass);
+         vec4 grassColor = sampleTile(uv, fs_Layer + 6 + 16 * 8);
 
 
           vec2 pos2D = fs_Pos.xy;
@@ -323,8 +223,7 @@ void main()
           diffuseColor = finalColor;
     }  else if (fs_UV.w == -9) {
         //DIRT GRASS PATCH
-         vec2 sand = vec2(uv.x, uv.y + 2.f/16.f);
-         vec4 sandColor = texture(u_Texture, sand);
+         vec4 sandColor = sampleTile(uv, fs_Layer + 16 * 2);
 
           vec2 pos2D = fs_Pos.xy;
           float radius = 5;
@@ -359,21 +258,29 @@ void main()
     // Avoid negative lighting values
     diffuseTerm = clamp(diffuseTerm, 0, 1);
 
+    // Faces turned away from the sun are dark already, only look up the shadows of the rest
+    if (diffuseTerm > 0 || specularTerm > 0) {
+        float visibility = sunVisibility();
+        diffuseTerm *= visibility;
+        specularTerm *= visibility;
+    }
+
     float ambientTerm = 0.2;
     float lightIntensity = diffuseTerm + ambientTerm + specularTerm;   //Add a small float value to the color multiplier
     //to simulate ambient lighting. This ensures that faces that are not
     //lit by our point light are not completely black.
 
+    // The sun only reaches as far as the sky light does, caves are lit by lava instead
+    vec3 lightColor = max(vec3(lightIntensity * fs_SkyLight), fs_BlockLight * lavaLightColor);
+
     // Compute shaded color
-    vec4 shadedColor = vec4(diffuseColor.rgb * lightIntensity, diffuseColor.a);
-
-    // Add fog
-    Ray ray = raycast();
-    vec4 fogColor = vec4(skyColor(ray.direction, vec3(fs_LightVec)), 1); //vec4(0.3686, 0.741, 1, 1);
-    float blockDistance = length(fs_Pos.xyz - u_CamPos);
-    float fogStart = 128.f;
-    float fogEnd = 144.f;
-    float fogFactor = clamp((blockDistance - fogStart) / (fogEnd - fogStart), 0.0, 1.0);
+    vec4 shadedColor = vec4(diffuseColor.rgb * lightColor, diffuseColor.a);
+
+    // Add fog, the color of the sky right behind this fragment
+    vec3 toFragment = fs_Pos.xyz - u_CamPos;
+    vec4 fogColor = vec4(texture(u_SkyLUT, skyLUTCoord(normalize(toFragment))).rgb, 1);
+    float blockDistance = length(toFragment);
+    float fogFactor = clamp((blockDistance - u_FogStart) / (u_FogEnd - u_FogStart), 0.0, 1.0);
     shadedColor = mix(shadedColor, fogColor, fogFactor);
     out_Col = shadedColor;
 
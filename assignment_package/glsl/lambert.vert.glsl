@@ -25,7 +25,11 @@ uniform vec4 u_Color;       // When drawing the cube instance, we'll set our uni
 
 uniform int u_Time;
 
-in vec4 vs_Pos;             // The array of vertex positions passed to the shader
+uniform mat4 u_ShadowViewProj[3]; // The sun's view of each shadow map cascade
+
+in vec4 vs_Pos;             // The array of vertex positions passed to the shader.
+                            // Chunk meshes keep the baked light of the face in the low
+                            // byte of w and the corner's ambient occlusion (0-3) above it.
 
 in vec4 vs_Nor;             // The array of vertex normals passed to the shader
 
@@ -38,8 +42,17 @@ out vec4 fs_Nor;            // The array of normals that has been transformed by
 out vec4 fs_LightVec;       // The direction in which our virtual light lies, relative to each vertex. This is implicitly passed to the fragment shader.
 // out vec4 fs_Col;            // The color of each vertex. This is implicitly passed to the fragment shader.
 out vec4 fs_UV;
+flat out float fs_Layer;    // The texture array layer, stored in the normal's w
+out float fs_SkyLight;      // How much of the sun and sky reaches the face, 0 to 1
+out float fs_BlockLight;    // How brightly nearby lava lights the face, 0 to 1
+out vec3 fs_ShadowCoord0;   // Where the vertex lands in each shadow map cascade, from 0 to 1
+out vec3 fs_ShadowCoord1;
+out vec3 fs_ShadowCoord2;
 
 out float fs_dayCycleSpeed;
+
+// The depth pre-pass in depth.vert.glsl has to land on exactly the same depth
+invariant gl_Position;
 // const vec4 lightDir = normalize(vec4(1, 0.1, 0, 0));  // The direction of our virtual light, which is used to compute the shading of
 //                                         // the geometry in the fragment shader.
 
@@ -50,6 +63,11 @@ const float TWO_PI = 6.28318530718;
 const float dayCycleSpeed = (TWO_PI / (60 * 60 * 24));
 
 
+// Each light level is 80% as bright as the one above it
+float lightBrightness(float level) {
+    return pow(0.8, 15.0 - level);
+}
+
 // Function to compute the sun's direction based on u_Time
 vec3 computeSunDirection() {
     // Sun starting position
@@ -64,12 +82,19 @@ vec3 computeSunDirection() {
 void main()
 {
     fs_dayCycleSpeed = dayCycleSpeed;
-    fs_Pos = vs_Pos;
+    fs_Pos = vec4(vs_Pos.xyz, 1);
     // fs_Col = vs_Col;                         // Pass the vertex colors to the fragment shader for interpolation
     fs_UV = vs_UV;
+    fs_Layer = vs_Nor.w;
     vec3 normal = vec3(vs_Nor);
 
-    vec4 modelposition = vs_Pos;
+    // Unpack the sky light from the high four bits and the block light from the low four
+    float light = mod(vs_Pos.w, 256.0);
+    float occlusion = 0.55 + 0.15 * floor(vs_Pos.w / 256.0);
+    fs_SkyLight = lightBrightness(floor(light / 16.0)) * occlusion;
+    fs_BlockLight = lightBrightness(mod(light, 16.0)) * occlusion;
+
+    vec4 modelposition = vec4(vs_Pos.xyz, 1);
 
     //Cactus
     if (vs_UV.w == 2) {
@@ -136,6 +161,12 @@ void main()
 
     modelposition = u_Model * modelposition;   // Temporarily store the transformed vertex positions for use below
 
+    // Look up the shadow maps a little off the surface so it doesn't shadow itself
+    vec4 shadowPos = modelposition + vec4(vec3(fs_Nor) * 0.05, 0);
+    fs_ShadowCoord0 = (u_ShadowViewProj[0] * shadowPos).xyz * 0.5 + 0.5;
+    fs_ShadowCoord1 = (u_ShadowViewProj[1] * shadowPos).xyz * 0.5 + 0.5;
+    fs_ShadowCoord2 = (u_ShadowViewProj[2] * shadowPos).xyz * 0.5 + 0.5;
+
     fs_LightVec = normalize(vec4(computeSunDirection(), 0));  // Compute the direction in which the light source lies
 
     gl_Position = u_ViewProj * modelposition;// gl_Position is a built-in variable of OpenGL which is
@@ -0,0 +1,7 @@
+#version 330 core
+
+// Only the depth of the shadow casters is kept
+
+void main()
+{
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+// Draws Chunk meshes into a shadow map cascade, as seen from the sun
+
+uniform mat4 u_ViewProj;    // The cascade's view and orthographic projection
+
+in vec4 vs_Pos;             // Chunk meshes keep their baked light in w, see lambert.vert.glsl
+
+void main()
+{
+    gl_Position = u_ViewProj * vec4(vs_Pos.xyz, 1);
+}
@@ -1,12 +1,51 @@
 #version 150
 
+// Draws a fullscreen quad, either over the screen for the sky pass or over
+// the sky LUT when it is baked
+
+// values used for ray casting
+uniform vec3 R; // camera's right vector
+uniform vec3 U; // camera's up vector
+uniform vec3 F; // camera's forward vector
+uniform float aspect;
+
+uniform int u_Time;
+
 in vec4 vs_Pos;
 in vec2 vs_UV;
 
 out vec2 fs_UV;
+out vec3 fs_Ray; // Unnormalized view ray, linear across the screen so it can be interpolated
+flat out vec3 fs_SunDir;
+
+const float fovy = 45;
+
+const float PI = 3.14159265359;
+const float TWO_PI = 6.28318530718;
+
+// 24 minute Day-Night Cycles
+const float dayCycleSpeed = (TWO_PI / (60 * 60 * 24));
+
+// Function to compute the sun's direction based on u_Time
+vec3 computeSunDirection() {
+    // Sun starting position
+    float start = PI / 2.f;
+    // Do a full rotation
+    float angle = mod(u_Time * dayCycleSpeed + start, TWO_PI);
+    float y = sin(angle);
+    float x = cos(angle);
+    return normalize(vec3(x, y, 0));
+}
 
 void main(void)
 {
     gl_Position = vs_Pos;
     fs_UV = vs_UV;
+
+    // formula for ray casting, done at the corners instead of for every pixel
+    vec3 V = U * tan(radians(fovy / 2.f));
+    vec3 H = R * tan(radians(fovy / 2.f)) * aspect;
+    fs_Ray = F + (vs_UV.x * 2 - 1) * H + (vs_UV.y * 2 - 1) * V;
+
+    fs_SunDir = computeSunDirection();
 }
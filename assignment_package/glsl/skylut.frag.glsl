@@ -0,0 +1,158 @@
+#version 150
+
+// Bakes the sky LUT read by sky.frag.glsl, lambert.frag.glsl and
+// horizon.frag.glsl. Every texel is the sky's color looking in the direction
+// its coordinates stand for, without the sun and moon, which sky.frag.glsl
+// draws on top.
+
+uniform int u_Time;
+uniform sampler3D u_WorleyVolume; // WorleyNoise3D baked by NoiseTextures
+uniform int u_BakedNoise; // 1 to sample u_WorleyVolume, 0 to work the noise out here
+
+in vec2 fs_UV;
+flat in vec3 fs_SunDir;
+
+out vec4 out_Col;
+
+const float PI = 3.14159265359;
+const float TWO_PI = 6.28318530718;
+
+const float worleyCells = 8.0; // NoiseTextures::WORLEY_CELLS, the volume wraps around after this many
+
+// Sunset palette
+const vec3 sunset[5] = vec3[](vec3(255, 229, 119) / 255.0,
+                                vec3(254, 192, 81) / 255.0,
+                                vec3(255, 137, 103) / 255.0,
+                                vec3(253, 96, 81) / 255.0,
+                                vec3(57, 32, 51) / 255.0);
+
+// Dusk palette
+const vec3 dusk[5] = vec3[](vec3(144, 96, 144) / 255.0,
+                                vec3(96, 72, 120) / 255.0,
+                                vec3(72, 48, 120) / 255.0,
+                                vec3(48, 24, 96) / 255.0,
+                                vec3(0, 24, 72) / 255.0);
+
+const vec3 daySkyCol = vec3(0.3686, 0.741, 1);
+const vec3 nightSkyCol = vec3(0.05, 0.05, 0.1);
+
+// Noise function that returns a random 3D point given a 3D point
+vec3 random3(vec3 p) {
+    return fract(sin(vec3(dot(p,vec3(127.1, 311.7, 191.999)),
+                          dot(p,vec3(269.5, 183.3, 765.54)),
+                          dot(p, vec3(420.69, 631.2,109.21))))
+                 *43758.5453);
+}
+
+// Generate worley noise given a 3D point
+float WorleyNoise3D(vec3 p)
+{
+    // Tile the space
+    vec3 pointInt = floor(p);
+    vec3 pointFract = fract(p);
+
+    float minDist = 1.0; // Minimum distance initialized to max.
+
+    // Search all neighboring cells and this cell for their point
+    for(int z = -1; z <= 1; z++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            for(int x = -1; x <= 1; x++)
+            {
+                vec3 neighbor = vec3(float(x), float(y), float(z));
+
+                // Random point inside current neighboring cell
+                vec3 point = random3(pointInt + neighbor);
+
+                // Animate the point
+                point = 0.5 + 0.5 * sin(u_Time * 0.01 + 6.2831 * point); // 0 to 1 range
+
+                // Compute the distance b/t the point and the fragment
+                // Store the min dist thus far
+                vec3 diff = neighbor + point - pointFract;
+                float dist = length(diff);
+                minDist = min(minDist, dist);
+            }
+        }
+    }
+    return minDist;
+}
+
+// The baked or the analytic Worley noise
+float worley(vec3 p) {
+    if (u_BakedNoise == 1) {
+        // The baked points can't move on their own, so the whole volume drifts instead
+        vec3 drift = vec3(0.002, 0, 0.001) * u_Time;
+        return texture(u_WorleyVolume, (p + drift) / worleyCells).r;
+    }
+    return WorleyNoise3D(p);
+}
+
+float fractalWorley(vec3 rayDir) {
+    float amp = 0.5;
+    float freq = 1.0;
+    float sum = 0;
+    for (int i = 0; i < 4; ++i) {
+        sum += worley(rayDir * freq) * amp;
+        amp *= 0.5;
+        freq *= 2;
+    }
+    return sum;
+}
+
+vec3 sunsetLerp(float t) {
+    t *= 4;
+    float tFract = fract(t);
+    int tLow = int(floor(t));
+    int tHigh = tLow + 1;
+    return mix(sunset[tLow], sunset[tHigh], tFract);
+}
+
+vec3 duskLerp(float t) {
+    t *= 4;
+    float tFract = fract(t);
+    int tLow = int(floor(t));
+    int tHigh = tLow + 1;
+    return mix(dusk[tLow], dusk[tHigh], tFract);
+}
+
+vec3 skyColor(vec3 rayDir, vec3 sunDir) {
+    // compute the sun's elevation
+    float sunElevation = clamp(dot(sunDir, vec3(0, 1, 0)), -1.0, 1.0);
+
+    // Transition between day and night colors based on sun elevation
+    vec3 skyBaseCol = mix(nightSkyCol, daySkyCol, max(sunElevation, 0.0));
+
+    // Use Worley Noise to create clouds
+    float t = clamp(dot(rayDir, vec3(0, 1, 0)), 0, 1);
+    float worley = fractalWorley(rayDir * 10);
+    worley = fract(worley) * 0.2;
+    t = clamp(t + worley, 0, 1);
+
+    // Compute the sunset and dusk colors
+    float t2 = clamp(dot(rayDir, sunDir), 0, 1);
+    vec3 settingCol = mix(duskLerp(t), sunsetLerp(t), t2);
+
+    // Transition between skyBaseCol and settingCol based on the sun's elevation
+    float transitionFactor = smoothstep(-1, 1, sunElevation);
+    vec3 finalSkyCol;
+    if (sunElevation > 0) {
+        finalSkyCol = mix(settingCol, skyBaseCol, transitionFactor);
+    } else {
+        finalSkyCol = mix(settingCol, skyBaseCol, 1 - transitionFactor);
+    }
+
+    return finalSkyCol;
+}
+
+// The direction whose sky is stored at uv, the inverse of skyLUTCoord in sky.frag.glsl
+vec3 skyLUTDirection(vec2 uv) {
+    float azimuth = (uv.x - 0.5) * TWO_PI;
+    float elevation = (uv.y - 0.5) * PI;
+    return vec3(cos(elevation) * cos(azimuth), sin(elevation), cos(elevation) * sin(azimuth));
+}
+
+void main(void) {
+    out_Col = vec4(skyColor(skyLUTDirection(fs_UV), fs_SunDir), 1);
+}
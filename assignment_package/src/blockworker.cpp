@@ -1,4 +1,5 @@
 #include "blockworker.h"
+#include "profiler.h"
 #include <iostream>
 
 BlockWorker::BlockWorker(Terrain* t, QMutex *mutex, int x, int z, std::unordered_set<Chunk*> *needVBO)
@@ -6,10 +7,13 @@ BlockWorker::BlockWorker(Terrain* t, QMutex *mutex, int x, int z, std::unordered
 {}
 
 void BlockWorker::run() {
+    PROFILE_SCOPE("generate chunk");
     try {
         if (terrain->hasChunkAt(x, z)) {
             Chunk* cPtr = terrain->getChunkAt(x, z).get();
             terrain->fillChunk(cPtr, x, z);
+            // Only this Chunk's own light, the main thread joins it up with the neighbors
+            cPtr->computeLight();
             blockMutex->lock();
             needVBO->insert(cPtr);
             blockMutex->unlock();
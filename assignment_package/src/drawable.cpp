@@ -12,6 +12,8 @@ Drawable::Drawable(OpenGLContext* context)
     // been fully initialized.
     indexCounts[INDEX] = -1;
     indexCounts[TRANSPARENT_INDEX] = -1;
+    indexCounts[LOD_INDEX] = -1;
+    indexCounts[FLUID_INDEX] = -1;
 }
 
 Drawable::~Drawable() {
@@ -26,6 +28,8 @@ void Drawable::destroyVBOdata() {
     bufHandles.clear();
     indexCounts[INDEX] = -1;
     indexCounts[TRANSPARENT_INDEX] = -1;
+    indexCounts[LOD_INDEX] = -1;
+    indexCounts[FLUID_INDEX] = -1;
 }
 
 GLenum Drawable::drawMode() {
@@ -43,6 +47,10 @@ int Drawable::elemCount(BufferType t) {
 }
 
 void Drawable::generateBuffer(BufferType buf) {
+    // Refilling a buffer reuses its handle rather than leaking it
+    if (bufGenerated[buf]) {
+        return;
+    }
     bufGenerated[buf] = true;
     mp_context->glGenBuffers(1, &bufHandles[buf]);
 }
@@ -51,7 +59,7 @@ bool Drawable::bindBuffer(BufferType buf) {
     if(bufGenerated[buf]) {
         // Should you have more than one kind of index buffer,
         // make sure to update this conditional to include them.
-        buf == INDEX || buf == TRANSPARENT_INDEX?
+        buf == INDEX || buf == TRANSPARENT_INDEX || buf == LOD_INDEX || buf == FLUID_INDEX ?
         mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufHandles[buf]) :
         mp_context->glBindBuffer(GL_ARRAY_BUFFER, bufHandles[buf]);
     }
@@ -74,6 +82,24 @@ void InstancedDrawable::clearOffsetBuf() {
         bufGenerated[INSTANCED_OFFSET] = false;
     }
 }
+void InstancedDrawable::setInstanceShapes(std::vector<glm::vec4> &shapes) {
+    generateBuffer(INSTANCED_SHAPE);
+    bindBuffer(INSTANCED_SHAPE);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, shapes.size() * sizeof(glm::vec4), shapes.data(), GL_STATIC_DRAW);
+}
+
+void InstancedDrawable::updateInstanceRange(int first, int count, const glm::vec3 *offsets, const glm::vec3 *colors, const glm::vec4 *shapes) {
+    if (bindBuffer(INSTANCED_OFFSET)) {
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), count * sizeof(glm::vec3), offsets);
+    }
+    if (bindBuffer(COLOR)) {
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), count * sizeof(glm::vec3), colors);
+    }
+    if (bindBuffer(INSTANCED_SHAPE)) {
+        mp_context->glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec4), count * sizeof(glm::vec4), shapes);
+    }
+}
+
 void InstancedDrawable::clearColorBuf() {
     if(bufGenerated[COLOR]) {
         mp_context->glDeleteBuffers(1, &bufHandles[COLOR]);
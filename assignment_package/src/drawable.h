@@ -9,7 +9,9 @@ enum BufferType : unsigned char {
     INDEX, TRANSPARENT_INDEX,
     POSITION, NORMAL, COLOR, UV,
     INTERLEAVED, TRANSPARENT_INTERLEAVED,
-    INSTANCED_OFFSET
+    INSTANCED_OFFSET, INSTANCED_SHAPE,
+    LOD_INTERLEAVED, LOD_INDEX,
+    FLUID_INTERLEAVED, FLUID_INDEX
 };
 
 //This defines a class which can be rendered by our shader program.
@@ -41,6 +43,7 @@ public:
 
     // Call these functions when you want to call glGenBuffers on the buffers stored in the Drawable
     // These will properly set the values of idxBound etc. which need to be checked in ShaderProgram::draw()
+    // A buffer that already exists is kept
     void generateBuffer(BufferType buf);
 
     bool bindBuffer(BufferType buf);
@@ -65,6 +68,12 @@ public:
     bool bindOffsetBuf();
     void clearOffsetBuf();
     void clearColorBuf();
+    // Per-instance box size in xyz and texture array layer in w. Without
+    // them every instance is a unit cube drawn with layer 0.
+    void setInstanceShapes(std::vector<glm::vec4> &shapes);
+    // Overwrites instances [first, first + count) of the offset, color and
+    // shape buffers in place, which must already hold that many
+    void updateInstanceRange(int first, int count, const glm::vec3 *offsets, const glm::vec3 *colors, const glm::vec4 *shapes);
 
     virtual void createInstancedVBOdata(std::vector<glm::vec3> &offsets, std::vector<glm::vec3> &colors) = 0;
 };
@@ -0,0 +1,67 @@
+#include "dynamicresolution.h"
+#include <algorithm>
+#include <cmath>
+
+// Frames to wait after a change before judging the new scale
+const static int settleFrames = 30;
+const static float scaleStep = 0.05f;
+
+DynamicResolution::DynamicResolution(float budgetMs, float minScale)
+    : m_enabled(false), m_scale(1.f), m_fixedScale(1.f), m_budgetMs(budgetMs), m_minScale(minScale),
+      m_smoothedMs(-1.f), m_framesSinceChange(0)
+{}
+
+void DynamicResolution::setEnabled(bool enabled) {
+    m_enabled = enabled;
+    m_scale = m_fixedScale;
+    m_smoothedMs = -1.f;
+    m_framesSinceChange = 0;
+}
+
+bool DynamicResolution::isEnabled() const {
+    return m_enabled;
+}
+
+void DynamicResolution::setFixedScale(float scale) {
+    m_fixedScale = std::clamp(scale, m_minScale, 1.f);
+    if (!m_enabled) {
+        m_scale = m_fixedScale;
+    }
+}
+
+void DynamicResolution::push(float frameMs) {
+    if (!m_enabled) {
+        return;
+    }
+    m_smoothedMs = m_smoothedMs < 0.f ? frameMs : 0.9f * m_smoothedMs + 0.1f * frameMs;
+    if (++m_framesSinceChange < settleFrames) {
+        return;
+    }
+    float scale = m_scale;
+    // Only step up when the frame would still fit if its cost grew with the
+    // pixel count, with a little to spare, so the scale does not bounce
+    // between two steps
+    float up = std::min(1.f, m_scale + scaleStep);
+    float upMs = m_smoothedMs * (up * up) / (m_scale * m_scale);
+    if (m_smoothedMs > m_budgetMs) {
+        scale = std::max(m_minScale, m_scale - scaleStep);
+    } else if (upMs < m_budgetMs * 0.95f) {
+        scale = up;
+    }
+    if (scale != m_scale) {
+        m_scale = scale;
+        m_framesSinceChange = 0;
+    }
+}
+
+float DynamicResolution::getScale() const {
+    return m_scale;
+}
+
+int DynamicResolution::scaled(int pixels) const {
+    if (m_scale >= 1.f) {
+        return pixels;
+    }
+    int steps = std::max(1, static_cast<int>(std::round(pixels * m_scale / PIXEL_STEP)));
+    return std::min(pixels, steps * PIXEL_STEP);
+}
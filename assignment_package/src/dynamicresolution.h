@@ -0,0 +1,38 @@
+#pragma once
+
+// Picks the scale the 3D scene is drawn at, relative to the window, from the
+// measured frame work. The scale drops in steps while frames take longer
+// than the budget and climbs back once the next step up would still fit in
+// it. The scaled size is rounded to whole blocks of pixels so the render
+// target pool only ever sees a handful of sizes.
+class DynamicResolution {
+public:
+    const static int PIXEL_STEP = 8;
+
+private:
+    bool m_enabled;
+    float m_scale;
+    float m_fixedScale;  // The scale while disabled
+    float m_budgetMs;
+    float m_minScale;
+    float m_smoothedMs;  // Exponential average of the frame times, -1 before the first
+    int m_framesSinceChange;
+
+public:
+    // The budget sits under the 16.7ms of a 60Hz swap, so a frame that
+    // fits in it is not held back a whole refresh by vsync
+    DynamicResolution(float budgetMs = 14.f, float minScale = 0.5f);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    // Used whenever scaling is off, between minScale and 1
+    void setFixedScale(float scale);
+
+    // Feeds in how long the last frame kept the CPU or the GPU busy, in
+    // milliseconds. Not the time between frames, which vsync rounds up to
+    // the refresh period and so hides any room to spare.
+    void push(float frameMs);
+    float getScale() const;
+    // The internal size for a window of the given size in pixels
+    int scaled(int pixels) const;
+};
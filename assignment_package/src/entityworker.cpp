@@ -0,0 +1,12 @@
+#include "entityworker.h"
+#include "profiler.h"
+
+EntityWorker::EntityWorker(EntitySystem *entities, int begin, int end, float dt, QSemaphore *done)
+    : entities(entities), begin(begin), end(end), dt(dt), done(done)
+{}
+
+void EntityWorker::run() {
+    PROFILE_SCOPE("entity physics");
+    entities->stepRange(begin, end, dt);
+    done->release();
+}
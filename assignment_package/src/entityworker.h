@@ -0,0 +1,16 @@
+#pragma once
+#include "scene/entitysystem.h"
+#include <QRunnable>
+#include <QSemaphore>
+
+// Runs the physics of one share of the entities for EntitySystem::step
+class EntityWorker : public QRunnable {
+private:
+    EntitySystem *entities;
+    int begin, end;
+    float dt;
+    QSemaphore *done; // Released once the share is simulated
+public:
+    EntityWorker(EntitySystem *entities, int begin, int end, float dt, QSemaphore *done);
+    void run() override;
+};
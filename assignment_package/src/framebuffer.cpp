@@ -2,10 +2,12 @@
 #include <iostream>
 
 FrameBuffer::FrameBuffer(OpenGLContext *context,
-                         unsigned int width, unsigned int height, unsigned int devicePixelRatio)
+                         unsigned int width, unsigned int height, unsigned int devicePixelRatio,
+                         GLenum internalFormat)
     : mp_context(context), m_frameBuffer(-1),
     m_outputTexture(-1), m_depthRenderBuffer(-1),
-    m_width(width), m_height(height), m_devicePixelRatio(devicePixelRatio), m_created(false)
+    m_width(width), m_height(height), m_devicePixelRatio(devicePixelRatio),
+    m_internalFormat(internalFormat), m_created(false), m_textureSlot(0)
 {}
 
 void FrameBuffer::resize(unsigned int width, unsigned int height, unsigned int devicePixelRatio) {
@@ -15,6 +17,8 @@ void FrameBuffer::resize(unsigned int width, unsigned int height, unsigned int d
 }
 
 void FrameBuffer::create() {
+    // Resizing creates the buffer again, don't leak the old one
+    destroy();
     // Initialize the frame buffers and render textures
     mp_context->glGenFramebuffers(1, &m_frameBuffer);
     mp_context->glGenTextures(1, &m_outputTexture);
@@ -24,19 +28,20 @@ void FrameBuffer::create() {
     // Bind our texture so that all functions that deal with textures will interact with this one
     mp_context->glBindTexture(GL_TEXTURE_2D, m_outputTexture);
     // Give an empty image to OpenGL ( the last "0" )
-    mp_context->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width * m_devicePixelRatio, m_height * m_devicePixelRatio, 0, GL_RGB, GL_UNSIGNED_BYTE, (void*)0);
+    mp_context->glTexImage2D(GL_TEXTURE_2D, 0, m_internalFormat, getPixelWidth(), getPixelHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
 
     // Set the render settings for the texture we've just created.
-    // Essentially zero filtering on the "texture" so it appears exactly as rendered
-    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    // Linear filtering so a frame buffer drawn at a lower resolution is upscaled
+    // smoothly. Drawn at its own size every lookup lands on a texel center anyway.
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     // Clamp the colors at the edge of our texture
     mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     // Initialize our depth buffer
     mp_context->glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderBuffer);
-    mp_context->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, m_width, m_height);
+    mp_context->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, getPixelWidth(), getPixelHeight());
     mp_context->glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderBuffer);
 
     // Set m_renderedTexture as the color output of our frame buffer
@@ -78,3 +83,15 @@ void FrameBuffer::bindToTextureSlot(unsigned int slot) {
 unsigned int FrameBuffer::getTextureSlot() const {
     return m_textureSlot;
 }
+
+unsigned int FrameBuffer::getPixelWidth() const {
+    return m_width * m_devicePixelRatio;
+}
+
+unsigned int FrameBuffer::getPixelHeight() const {
+    return m_height * m_devicePixelRatio;
+}
+
+GLenum FrameBuffer::getInternalFormat() const {
+    return m_internalFormat;
+}
@@ -20,16 +20,18 @@ private:
     GLuint m_depthRenderBuffer;
 
     unsigned int m_width, m_height, m_devicePixelRatio;
+    GLenum m_internalFormat;
     bool m_created;
 
     unsigned int m_textureSlot;
 
 public:
-    FrameBuffer(OpenGLContext *context, unsigned int width, unsigned int height, unsigned int devicePixelRatio);
+    FrameBuffer(OpenGLContext *context, unsigned int width, unsigned int height, unsigned int devicePixelRatio,
+                GLenum internalFormat = GL_RGB8);
     // Make sure to call resize from MyGL::resizeGL to keep your frame buffer up to date with
-    // your screen dimensions
+    // your screen dimensions, then create to reallocate it
     void resize(unsigned int width, unsigned int height, unsigned int devicePixelRatio);
-    // Initialize all GPU-side data required
+    // Initialize all GPU-side data required, releasing whatever was there before
     void create();
     // Deallocate all GPU-side data
     void destroy();
@@ -37,4 +39,8 @@ public:
     // Associate our output texture with the indicated texture slot
     void bindToTextureSlot(unsigned int slot);
     unsigned int getTextureSlot() const;
+    // Size in pixels, devicePixelRatio included
+    unsigned int getPixelWidth() const;
+    unsigned int getPixelHeight() const;
+    GLenum getInternalFormat() const;
 };
@@ -0,0 +1,45 @@
+#include "framegraph.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+FrameGraph::FrameGraph(QWidget *parent)
+    : QWidget(parent), m_times()
+{}
+
+void FrameGraph::setFrameTimes(const QVector<float> &times) {
+    m_times = times;
+    update();
+}
+
+void FrameGraph::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+
+    // Always show at least up to the 30 fps budget
+    float top = 40.f;
+    for (float t : m_times) {
+        top = std::max(top, t);
+    }
+    auto toY = [&](float ms) {
+        return height() - 1 - (height() - 1) * ms / top;
+    };
+
+    painter.setPen(QPen(QColor(80, 160, 80), 1, Qt::DashLine));
+    painter.drawLine(QPointF(0, toY(1000.f / 60.f)), QPointF(width(), toY(1000.f / 60.f)));
+    painter.setPen(QPen(QColor(180, 140, 60), 1, Qt::DashLine));
+    painter.drawLine(QPointF(0, toY(1000.f / 30.f)), QPointF(width(), toY(1000.f / 30.f)));
+
+    if (m_times.size() < 2) {
+        return;
+    }
+    QPainterPath path;
+    float step = width() / static_cast<float>(m_times.size() - 1);
+    path.moveTo(0, toY(m_times[0]));
+    for (int i = 1; i < m_times.size(); ++i) {
+        path.lineTo(i * step, toY(m_times[i]));
+    }
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QColor(230, 230, 230), 1));
+    painter.drawPath(path);
+}
@@ -0,0 +1,23 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <QWidget>
+#include <QVector>
+
+// A line graph of recent frame times in milliseconds, with guides at the
+// 60 and 30 frames per second budgets
+class FrameGraph : public QWidget {
+    Q_OBJECT
+public:
+    explicit FrameGraph(QWidget *parent = nullptr);
+
+    void setFrameTimes(const QVector<float> &times);
+
+protected:
+    void paintEvent(QPaintEvent *e) override;
+
+private:
+    QVector<float> m_times;
+};
+
+#endif // FRAMEGRAPH_H
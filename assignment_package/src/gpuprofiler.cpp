@@ -0,0 +1,162 @@
+#include "gpuprofiler.h"
+#include "profiler.h"
+#include <QOpenGLContext>
+#include <QDebug>
+#include <cstring>
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_SAMPLES_PASSED
+#define GL_SAMPLES_PASSED 0x8914
+#endif
+#ifndef GL_QUERY_COUNTER_BITS
+#define GL_QUERY_COUNTER_BITS 0x8864
+#endif
+
+GpuProfiler::GpuProfiler(OpenGLContext *context)
+    : mp_context(context), m_supported(false), m_frames(), m_frame(0), m_passActive(false),
+      m_passNames(), m_passMs(), m_passFragments(), m_framePasses(), m_lastFramePasses()
+{}
+
+void GpuProfiler::create() {
+    QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (ctx) {
+        QSurfaceFormat format = ctx->format();
+        bool core33 = format.majorVersion() > 3 || (format.majorVersion() == 3 && format.minorVersion() >= 3);
+        m_supported = core33 || ctx->hasExtension("GL_ARB_timer_query");
+    }
+    if (m_supported) {
+        // Some drivers accept the query but have no timer behind it
+        while (mp_context->glGetError() != GL_NO_ERROR) {}
+        GLint bits = 0;
+        mp_context->glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+        m_supported = mp_context->glGetError() == GL_NO_ERROR && bits > 0;
+    }
+    if (!m_supported) {
+        qDebug() << "GPU timer queries are not supported, GPU pass times will not be shown";
+    }
+}
+
+void GpuProfiler::destroy() {
+    for (FrameQueries &frame : m_frames) {
+        if (!frame.queries.empty()) {
+            mp_context->glDeleteQueries(frame.queries.size(), frame.queries.data());
+            mp_context->glDeleteQueries(frame.sampleQueries.size(), frame.sampleQueries.data());
+        }
+        frame.queries.clear();
+        frame.sampleQueries.clear();
+        frame.passes.clear();
+        frame.starts.clear();
+    }
+}
+
+bool GpuProfiler::isSupported() const {
+    return m_supported;
+}
+
+int GpuProfiler::passIndex(const char *name) {
+    for (size_t i = 0; i < m_passNames.size(); ++i) {
+        if (std::strcmp(m_passNames[i], name) == 0) {
+            return i;
+        }
+    }
+    m_passNames.push_back(name);
+    m_passMs.push_back(-1.f);
+    m_passFragments.push_back(-1);
+    return m_passNames.size() - 1;
+}
+
+void GpuProfiler::collect(FrameQueries &frame) {
+    for (size_t i = 0; i < frame.passes.size(); ++i) {
+        GLuint available = 0, samplesAvailable = 0;
+        mp_context->glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        mp_context->glGetQueryObjectuiv(frame.sampleQueries[i], GL_QUERY_RESULT_AVAILABLE, &samplesAvailable);
+        // The GPU is more than FRAMES frames behind, drop the result rather than wait
+        if (!available || !samplesAvailable) {
+            continue;
+        }
+        GLuint elapsed = 0, samples = 0;
+        mp_context->glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+        mp_context->glGetQueryObjectuiv(frame.sampleQueries[i], GL_QUERY_RESULT, &samples);
+        int pass = frame.passes[i];
+        m_passFragments[pass] = samples;
+        float ms = elapsed / 1e6f;
+        m_passMs[pass] = m_passMs[pass] < 0.f ? ms : 0.9f * m_passMs[pass] + 0.1f * ms;
+        Profiler::recordGpu(m_passNames[pass], frame.starts[i], elapsed);
+    }
+    frame.passes.clear();
+    frame.starts.clear();
+}
+
+void GpuProfiler::beginFrame() {
+    if (!m_supported) {
+        return;
+    }
+    collect(m_frames[m_frame]);
+}
+
+void GpuProfiler::beginPass(const char *name) {
+    m_framePasses.push_back(name);
+    if (!m_supported) {
+        return;
+    }
+    // GL_TIME_ELAPSED queries can't be nested
+    endPass();
+    FrameQueries &frame = m_frames[m_frame];
+    size_t n = frame.passes.size();
+    if (n == frame.queries.size()) {
+        GLuint query[2];
+        mp_context->glGenQueries(2, query);
+        frame.queries.push_back(query[0]);
+        frame.sampleQueries.push_back(query[1]);
+    }
+    mp_context->glBeginQuery(GL_TIME_ELAPSED, frame.queries[n]);
+    mp_context->glBeginQuery(GL_SAMPLES_PASSED, frame.sampleQueries[n]);
+    frame.passes.push_back(passIndex(name));
+    frame.starts.push_back(Profiler::now());
+    m_passActive = true;
+}
+
+void GpuProfiler::endPass() {
+    if (!m_supported || !m_passActive) {
+        return;
+    }
+    mp_context->glEndQuery(GL_TIME_ELAPSED);
+    mp_context->glEndQuery(GL_SAMPLES_PASSED);
+    m_passActive = false;
+}
+
+void GpuProfiler::endFrame() {
+    m_lastFramePasses.swap(m_framePasses);
+    m_framePasses.clear();
+    if (!m_supported) {
+        return;
+    }
+    endPass();
+    m_frame = (m_frame + 1) % FRAMES;
+}
+
+std::vector<std::pair<std::string, float>> GpuProfiler::getPassTimes() const {
+    std::vector<std::pair<std::string, float>> times;
+    for (size_t i = 0; i < m_passNames.size(); ++i) {
+        if (m_passMs[i] >= 0.f) {
+            times.push_back(std::make_pair(std::string(m_passNames[i]), m_passMs[i]));
+        }
+    }
+    return times;
+}
+
+std::vector<std::pair<std::string, int64_t>> GpuProfiler::getPassFragments() const {
+    std::vector<std::pair<std::string, int64_t>> fragments;
+    for (size_t i = 0; i < m_passNames.size(); ++i) {
+        if (m_passFragments[i] >= 0) {
+            fragments.push_back(std::make_pair(std::string(m_passNames[i]), m_passFragments[i]));
+        }
+    }
+    return fragments;
+}
+
+const std::vector<const char*>& GpuProfiler::getFramePasses() const {
+    return m_lastFramePasses;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "openglcontext.h"
+#include <array>
+#include <string>
+#include <vector>
+
+// Times render passes on the GPU with GL_TIME_ELAPSED queries, and counts
+// the fragments each pass wrote with GL_SAMPLES_PASSED queries. Each frame
+// gets its own set of queries and results are read FRAMES frames later, by
+// which point the GPU has finished them, so reading never stalls the CPU.
+// Only one pass can be timed at a time. If the driver has no timer queries
+// (software rasterisers often don't) every call is a no-op, apart from
+// noting which passes ran.
+class GpuProfiler
+{
+private:
+    static const int FRAMES = 3;
+
+    struct FrameQueries {
+        std::vector<GLuint> queries; // Grown as needed, reused every FRAMES frames
+        std::vector<GLuint> sampleQueries; // One per timer query
+        std::vector<int> passes;     // The pass each issued query timed
+        std::vector<int64_t> starts; // CPU time each pass began, for the trace
+    };
+
+    OpenGLContext *mp_context;
+    bool m_supported;
+    std::array<FrameQueries, FRAMES> m_frames;
+    int m_frame;
+    bool m_passActive;
+
+    std::vector<const char*> m_passNames;
+    // Smoothed milliseconds of each pass, -1 until the first result arrives
+    std::vector<float> m_passMs;
+    // Fragments that passed the depth test in the last result of each pass, -1 until it arrives
+    std::vector<int64_t> m_passFragments;
+    // The passes begun this frame and in the last finished frame, in order
+    std::vector<const char*> m_framePasses;
+    std::vector<const char*> m_lastFramePasses;
+
+    int passIndex(const char *name);
+    void collect(FrameQueries &frame);
+
+public:
+    GpuProfiler(OpenGLContext *context);
+
+    // Call once the GL functions are initialized
+    void create();
+    void destroy();
+    bool isSupported() const;
+
+    // Reads back the results of the frame that last used this frame's queries
+    void beginFrame();
+    void beginPass(const char *name);
+    void endPass();
+    void endFrame();
+
+    // The latest smoothed time of every pass seen so far, in milliseconds
+    std::vector<std::pair<std::string, float>> getPassTimes() const;
+    // The fragments every pass seen so far wrote in its latest result
+    std::vector<std::pair<std::string, int64_t>> getPassFragments() const;
+    // The passes the last finished frame ran, whether or not they could be timed
+    const std::vector<const char*>& getFramePasses() const;
+};
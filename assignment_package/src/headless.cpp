@@ -0,0 +1,201 @@
+#include "headless.h"
+#include "mygl.h"
+#include "profiler.h"
+#include <QApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+bool wantsHeadless(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+FILE *diagnosticStream() {
+    QStringList args = QApplication::arguments();
+    return args.contains("--headless") || args.contains("--replay") ? stderr : stdout;
+}
+
+static HeadlessOptions parseOptions() {
+    HeadlessOptions options;
+    QStringList args = QApplication::arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        bool hasValue = i + 1 < args.size();
+        if (args[i] == "--frames" && hasValue) {
+            options.frames = std::max(1, args[++i].toInt());
+        } else if (args[i] == "--size" && hasValue) {
+            QStringList size = args[++i].split("x");
+            if (size.size() == 2) {
+                options.width = std::max(1, size[0].toInt());
+                options.height = std::max(1, size[1].toInt());
+            }
+        } else if (args[i] == "--seed" && hasValue) {
+            options.seed = args[++i].toUInt();
+        } else if (args[i] == "--checksum-every" && hasValue) {
+            options.checksumInterval = std::max(1, args[++i].toInt());
+        } else if (args[i] == "--golden" && hasValue) {
+            options.goldenPath = args[++i].toStdString();
+        } else if (args[i] == "--output" && hasValue) {
+            options.outputPath = args[++i].toStdString();
+        } else if (args[i] == "--write-golden") {
+            options.writeGolden = true;
+        } else if (args[i] == "--no-depth-prepass") {
+            options.depthPrepass = false;
+        } else if (args[i] == "--analytic-noise") {
+            options.bakedNoise = false;
+        } else if (args[i] == "--render-scale" && hasValue) {
+            options.renderScale = args[++i].toFloat();
+        } else if (args[i] == "--entities" && hasValue) {
+            options.entities = std::max(0, args[++i].toInt());
+        }
+    }
+    return options;
+}
+
+// Golden files hold one "<frame> <checksum in hex>" line per checksum
+static std::map<int, uint64_t> readGolden(const std::string &path) {
+    std::map<int, uint64_t> golden;
+    std::ifstream in(path);
+    int frame;
+    std::string hex;
+    while (in >> frame >> hex) {
+        golden[frame] = std::stoull(hex, nullptr, 16);
+    }
+    return golden;
+}
+
+static bool writeGolden(const std::string &path, const std::vector<std::pair<int, uint64_t>> &checksums) {
+    std::ofstream out(path);
+    for (auto &c : checksums) {
+        out << c.first << " " << std::hex << c.second << std::dec << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+int runHeadless() {
+    HeadlessOptions options = parseOptions();
+
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create()) {
+        std::fprintf(stderr, "Could not create an OpenGL context\n");
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface)) {
+        std::fprintf(stderr, "Could not make the OpenGL context current on an offscreen surface\n");
+        return 1;
+    }
+
+    HeadlessResult result;
+    {
+        // Never shown, MyGL only lends its renderer to the offscreen context
+        MyGL gl;
+        gl.renderHeadless(options, result);
+        context.makeCurrent(&surface);
+    }
+
+    // Compare or record the golden checksums
+    int mismatches = 0;
+    bool goldenWritten = false;
+    if (!options.goldenPath.empty()) {
+        if (options.writeGolden) {
+            goldenWritten = writeGolden(options.goldenPath, result.checksums);
+        } else {
+            std::map<int, uint64_t> golden = readGolden(options.goldenPath);
+            for (auto &c : result.checksums) {
+                auto expected = golden.find(c.first);
+                if (expected == golden.end() || expected->second != c.second) {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+
+    FrameStats frames = summarize(result.frameMs);
+    double total = 0.0;
+    for (float ms : result.frameMs) {
+        total += ms;
+    }
+    const char *renderer = reinterpret_cast<const char*>(context.functions()->glGetString(GL_RENDERER));
+
+    FILE *out = options.outputPath.empty() ? stdout : std::fopen(options.outputPath.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "Could not open %s\n", options.outputPath.c_str());
+        return 1;
+    }
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"benchmark\": \"headless_render\",\n");
+    std::fprintf(out, "  \"renderer\": \"%s\",\n", renderer ? renderer : "unknown");
+    std::fprintf(out, "  \"size\": [%d, %d],\n", options.width, options.height);
+    std::fprintf(out, "  \"seed\": %u,\n", options.seed);
+    std::fprintf(out, "  \"depth_prepass\": %s,\n", options.depthPrepass ? "true" : "false");
+    std::fprintf(out, "  \"baked_noise\": %s,\n", options.bakedNoise ? "true" : "false");
+    std::fprintf(out, "  \"render_scale\": %.2f,\n", options.renderScale);
+    std::fprintf(out, "  \"entities\": %d,\n", options.entities);
+    std::fprintf(out, "  \"chunks\": %zu,\n", result.chunks);
+    std::fprintf(out, "  \"generate_seconds\": %.3f,\n", result.generateSeconds);
+    std::fprintf(out, "  \"frames\": %zu,\n", result.frameMs.size());
+    std::fprintf(out, "  \"fps\": %.2f,\n", total > 0.0 ? 1000.0 * result.frameMs.size() / total : 0.0);
+    std::fprintf(out, "  \"frame_ms\": { \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n", frames.p50, frames.p99, frames.max);
+    std::fprintf(out, "  \"raycast_us\": %.3f,\n", result.raycastMicros);
+    std::fprintf(out, "  \"raycast_hits\": %d,\n", result.raycastHits);
+    std::fprintf(out, "  \"edit_fill\": { \"blocks\": %zu, \"changed\": %zu, \"remeshed\": %zu, \"ms\": %.3f, "
+                 "\"undo_remeshed\": %zu, \"undo_ms\": %.3f, \"undo_bytes\": %zu },\n",
+                 result.editBlocks, result.editChanged, result.editRemeshed, result.editMs,
+                 result.undoRemeshed, result.undoMs, result.undoBytes);
+    FrameStats entitySteps = summarize(result.entityStepMs);
+    std::fprintf(out, "  \"entity_step_ms\": { \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+                 entitySteps.p50, entitySteps.p99, entitySteps.max);
+    std::fprintf(out, "  \"gpu_ms\": {");
+    for (size_t i = 0; i < result.gpuPasses.size(); ++i) {
+        std::fprintf(out, "%s \"%s\": %.3f", i > 0 ? "," : "", result.gpuPasses[i].first.c_str(), result.gpuPasses[i].second);
+    }
+    std::fprintf(out, " },\n");
+    std::fprintf(out, "  \"gpu_fragments\": {");
+    for (size_t i = 0; i < result.gpuFragments.size(); ++i) {
+        std::fprintf(out, "%s \"%s\": %lld", i > 0 ? "," : "", result.gpuFragments[i].first.c_str(),
+                     static_cast<long long>(result.gpuFragments[i].second));
+    }
+    std::fprintf(out, " },\n");
+    std::fprintf(out, "  \"pass_frames\": {");
+    for (size_t i = 0; i < result.passFrames.size(); ++i) {
+        std::fprintf(out, "%s \"%s\": %d", i > 0 ? "," : "", result.passFrames[i].first.c_str(), result.passFrames[i].second);
+    }
+    std::fprintf(out, " },\n");
+    std::fprintf(out, "  \"checksums\": {");
+    for (size_t i = 0; i < result.checksums.size(); ++i) {
+        std::fprintf(out, "%s \"%d\": \"%016llx\"", i > 0 ? "," : "", result.checksums[i].first,
+                    static_cast<unsigned long long>(result.checksums[i].second));
+    }
+    std::fprintf(out, " },\n");
+    if (options.goldenPath.empty()) {
+        std::fprintf(out, "  \"golden\": null\n");
+    } else if (options.writeGolden) {
+        std::fprintf(out, "  \"golden\": { \"file\": \"%s\", \"written\": %s }\n", options.goldenPath.c_str(), goldenWritten ? "true" : "false");
+    } else {
+        std::fprintf(out, "  \"golden\": { \"file\": \"%s\", \"mismatches\": %d }\n", options.goldenPath.c_str(), mismatches);
+    }
+    std::fprintf(out, "}\n");
+    if (out == stdout) {
+        std::fflush(stdout);
+    } else {
+        std::fclose(out);
+    }
+
+    if (options.writeGolden && !goldenWritten) {
+        return 1;
+    }
+    return mismatches > 0 ? 2 : 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Settings of the headless render benchmark, see runHeadless
+struct HeadlessOptions {
+    int frames = 240;
+    int width = 640, height = 360;
+    unsigned int seed = 277;
+    // Hash the final image every this many frames (and on the last one)
+    int checksumInterval = 60;
+    // Compare the checksums against this file, or write them to it
+    std::string goldenPath;
+    bool writeGolden = false;
+    // Where the JSON report goes, stdout if empty
+    std::string outputPath;
+    // Lay down the terrain's depth before shading it, see MyGL::m_depthPrepass
+    bool depthPrepass = true;
+    // Sample the noise textures rather than evaluate the noise, see MyGL::m_bakedNoise
+    bool bakedNoise = true;
+    // Resolution of the 3D scene relative to the image, upscaled by the post-process pass
+    float renderScale = 1.f;
+    // Mobs and falling blocks dropped around the orbit, stepped once a frame
+    int entities = 0;
+};
+
+// What MyGL::renderHeadless measured
+struct HeadlessResult {
+    double generateSeconds = 0.0;
+    size_t chunks = 0;
+    std::vector<float> frameMs; // Scene update, draw and glFinish of each frame
+    std::vector<std::pair<int, uint64_t>> checksums; // FNV-1a of the RGBA pixels, by frame
+    std::vector<std::pair<std::string, float>> gpuPasses;
+    std::vector<std::pair<std::string, int64_t>> gpuFragments; // Fragments each pass wrote in its latest result
+    std::vector<std::pair<std::string, int>> passFrames; // How many frames ran each pass
+    std::vector<float> entityStepMs; // EntitySystem::step of each frame, part of the frame time
+    float raycastMicros = 0.f; // Mean time of a 128 block raycastBlocks from the orbit
+    int raycastHits = 0;
+    // A fill through Terrain::applyEdits after the last frame, then its undo
+    size_t editBlocks = 0, editChanged = 0, editRemeshed = 0, undoRemeshed = 0, undoBytes = 0;
+    float editMs = 0.f, undoMs = 0.f;
+};
+
+// Whether argv asks for the headless benchmark. Checked before the
+// QApplication exists so the offscreen platform can be picked.
+bool wantsHeadless(int argc, char *argv[]);
+
+// Where the GL version diagnostics are printed. --headless and --replay runs
+// write their JSON reports to stdout, so they get stderr instead.
+FILE *diagnosticStream();
+
+// Renders an orbit around the spawn point through the full scene and
+// post-process pipeline into an offscreen frame buffer, without a window,
+// and reports the frame times and image checksums as JSON. The world under
+// the orbit is generated on one thread from a fixed seed before timing
+// starts, and worker threads are waited on every frame, so the images are
+// the same run to run on the same GL implementation.
+//
+//   MiniMinecraft --headless [--frames N] [--size WxH] [--seed S]
+//                 [--checksum-every N] [--golden FILE] [--write-golden]
+//                 [--output FILE] [--no-depth-prepass] [--analytic-noise]
+//                 [--render-scale S] [--entities N]
+//
+// With --golden the checksums are compared against FILE and the exit code
+// is 2 on a mismatch; add --write-golden to record FILE instead. The
+// fragment counts of the passes show what --no-depth-prepass costs, and the
+// "sky lut" and "post process" times what --analytic-noise costs. The
+// "post process" pass only runs when the render scale is below 1, since the
+// orbit stays out of fluids, which "pass_frames" shows. "entity_step_ms"
+// is what simulating --entities mobs and falling blocks costs, and
+// "raycast_us" what a long raycast through the generated world costs.
+// "edit_fill" is a batched fill of about 10,000 blocks and its undo. The Qt
+// platform defaults to "offscreen", but Qt 5 makes its GL context through
+// GLX, so an X server is still needed: without a display, run it under
+// xvfb-run -a. On a machine without a GPU, Mesa's llvmpipe can be forced
+// with LIBGL_ALWAYS_SOFTWARE=1.
+int runHeadless();
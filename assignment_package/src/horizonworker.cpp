@@ -0,0 +1,17 @@
+#include "horizonworker.h"
+#include "profiler.h"
+
+HorizonWorker::HorizonWorker(const Terrain *t, QMutex *mutex, int x, int z, std::vector<std::pair<int64_t, HorizonRegion*>> *finished,
+                             QSemaphore *done)
+    : terrain(t), regionMutex(mutex), finished(finished), done(done), x(x), z(z)
+{}
+
+void HorizonWorker::run() {
+    PROFILE_SCOPE("horizon region");
+    HorizonRegion *region = new HorizonRegion();
+    fillHorizonRegion(*terrain, x, z, *region);
+    regionMutex->lock();
+    finished->push_back(std::pair(toKey(x, z), region));
+    regionMutex->unlock();
+    done->release();
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "scene/horizon.h"
+#include <QRunnable>
+#include <QMutex>
+#include <QSemaphore>
+
+class HorizonWorker : public QRunnable {
+private:
+    const Terrain *terrain;
+    QMutex *regionMutex;
+    std::vector<std::pair<int64_t, HorizonRegion*>> *finished;
+    QSemaphore *done; // Released once the region is handed over
+    int x;
+    int z;
+public:
+    HorizonWorker(const Terrain *t, QMutex *mutex, int x, int z, std::vector<std::pair<int64_t, HorizonRegion*>> *finished,
+                  QSemaphore *done);
+    void run() override;
+};
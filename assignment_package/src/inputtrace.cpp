@@ -0,0 +1,117 @@
+#include "inputtrace.h"
+#include <cstring>
+#include <fstream>
+
+// "MMIT" followed by the format version
+const static char traceMagic[4] = {'M', 'M', 'I', 'T'};
+const static uint32_t traceVersion = 1;
+
+namespace {
+    template <typename T>
+    void write(std::ofstream &out, const T &value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool read(std::ifstream &in, T &value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    void writeVec3(std::ofstream &out, glm::vec3 v) {
+        write(out, v.x);
+        write(out, v.y);
+        write(out, v.z);
+    }
+
+    bool readVec3(std::ifstream &in, glm::vec3 &v) {
+        return read(in, v.x) && read(in, v.y) && read(in, v.z);
+    }
+}
+
+InputTrace::InputTrace()
+    : m_start(), m_frames()
+{}
+
+uint8_t InputTrace::packKeys(const InputBundle &inputs) {
+    return (inputs.wPressed ? 1 : 0) | (inputs.aPressed ? 2 : 0) | (inputs.sPressed ? 4 : 0) |
+           (inputs.dPressed ? 8 : 0) | (inputs.qPressed ? 16 : 0) | (inputs.ePressed ? 32 : 0) |
+           (inputs.spacePressed ? 64 : 0);
+}
+
+void InputTrace::unpackKeys(uint8_t keys, InputBundle &inputs) {
+    inputs.wPressed = keys & 1;
+    inputs.aPressed = keys & 2;
+    inputs.sPressed = keys & 4;
+    inputs.dPressed = keys & 8;
+    inputs.qPressed = keys & 16;
+    inputs.ePressed = keys & 32;
+    inputs.spacePressed = keys & 64;
+}
+
+void InputTrace::reset(const PlayerState &start) {
+    m_start = start;
+    m_frames.clear();
+}
+
+void InputTrace::push(const TraceFrame &frame) {
+    m_frames.push_back(frame);
+}
+
+bool InputTrace::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    out.write(traceMagic, 4);
+    write(out, traceVersion);
+    writeVec3(out, m_start.position);
+    writeVec3(out, m_start.forward);
+    writeVec3(out, m_start.right);
+    writeVec3(out, m_start.up);
+    writeVec3(out, m_start.velocity);
+    write(out, static_cast<uint8_t>(m_start.flightMode));
+    write(out, static_cast<uint32_t>(m_frames.size()));
+    for (const TraceFrame &f : m_frames) {
+        write(out, f.dt);
+        write(out, f.rotateUp);
+        write(out, f.rotateRight);
+        write(out, f.keys);
+        write(out, f.actions);
+    }
+    return static_cast<bool>(out);
+}
+
+bool InputTrace::load(const std::string &path) {
+    m_frames.clear();
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t version, count;
+    uint8_t flight;
+    PlayerState start;
+    if (!in.read(magic, 4) || std::memcmp(magic, traceMagic, 4) != 0 ||
+        !read(in, version) || version != traceVersion ||
+        !readVec3(in, start.position) || !readVec3(in, start.forward) || !readVec3(in, start.right) ||
+        !readVec3(in, start.up) || !readVec3(in, start.velocity) || !read(in, flight) || !read(in, count)) {
+        return false;
+    }
+    start.flightMode = flight != 0;
+
+    std::vector<TraceFrame> frames(count);
+    for (TraceFrame &f : frames) {
+        if (!read(in, f.dt) || !read(in, f.rotateUp) || !read(in, f.rotateRight) ||
+            !read(in, f.keys) || !read(in, f.actions)) {
+            return false;
+        }
+    }
+    m_start = start;
+    m_frames = std::move(frames);
+    return true;
+}
+
+const PlayerState& InputTrace::getStart() const {
+    return m_start;
+}
+
+const std::vector<TraceFrame>& InputTrace::getFrames() const {
+    return m_frames;
+}
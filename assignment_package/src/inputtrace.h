@@ -0,0 +1,45 @@
+#pragma once
+#include "scene/player.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One-off actions that happened during a tick
+enum TraceAction : uint8_t {
+    TOGGLE_FLIGHT = 1, BREAK_BLOCK = 2, PLACE_BLOCK = 4, BLAST = 8, UNDO_EDIT = 16
+};
+
+// Everything MyGL::tick feeds the Player in one tick
+struct TraceFrame {
+    float dt;          // Milliseconds
+    float rotateUp;    // Degrees about the global up axis
+    float rotateRight; // Degrees about the local right axis
+    uint8_t keys;      // InputBundle packed by InputTrace::packKeys
+    uint8_t actions;   // TraceAction flags
+};
+
+// A recording of the player's inputs, tick by tick, along with the state
+// the player started in. Stored as a small binary file: a header holding
+// the starting PlayerState followed by 14 bytes per tick.
+class InputTrace {
+private:
+    PlayerState m_start;
+    std::vector<TraceFrame> m_frames;
+
+public:
+    InputTrace();
+
+    static uint8_t packKeys(const InputBundle &inputs);
+    static void unpackKeys(uint8_t keys, InputBundle &inputs);
+
+    // Starts a new recording from the given state
+    void reset(const PlayerState &start);
+    void push(const TraceFrame &frame);
+
+    bool save(const std::string &path) const;
+    // Returns false and leaves the trace empty if the file is missing or malformed
+    bool load(const std::string &path);
+
+    const PlayerState& getStart() const;
+    const std::vector<TraceFrame>& getFrames() const;
+};
@@ -0,0 +1,121 @@
+#include "instancerenderer.h"
+#include <algorithm>
+
+InstanceRenderer::InstanceRenderer()
+    : m_batches()
+{}
+
+int InstanceRenderer::addType(InstancedDrawable *mesh) {
+    Batch batch;
+    batch.mesh = mesh;
+    batch.dirtyBegin = batch.dirtyEnd = 0;
+    batch.resized = false;
+    m_batches.push_back(batch);
+    return m_batches.size() - 1;
+}
+
+bool InstanceRenderer::isCurrent(int type, int64_t key, int version) const {
+    const Batch &batch = m_batches[type];
+    auto it = batch.groups.find(key);
+    return it != batch.groups.end() && it->second.version == version;
+}
+
+void InstanceRenderer::setGroup(int type, int64_t key, const std::vector<glm::vec3> &offsets,
+                                const std::vector<glm::vec4> &shapes, int version) {
+    Batch &batch = m_batches[type];
+    int count = offsets.size();
+    auto it = batch.groups.find(key);
+    if (it != batch.groups.end() && it->second.count == count) {
+        Group &group = it->second;
+        group.version = version;
+        if (count == 0) {
+            return;
+        }
+        std::copy(offsets.begin(), offsets.end(), batch.offsets.begin() + group.first);
+        std::copy(shapes.begin(), shapes.end(), batch.shapes.begin() + group.first);
+        if (batch.dirtyEnd > batch.dirtyBegin) {
+            batch.dirtyBegin = std::min(batch.dirtyBegin, group.first);
+            batch.dirtyEnd = std::max(batch.dirtyEnd, group.first + count);
+        } else {
+            batch.dirtyBegin = group.first;
+            batch.dirtyEnd = group.first + count;
+        }
+        return;
+    }
+    if (it != batch.groups.end()) {
+        removeRange(batch, it->second);
+        batch.groups.erase(it);
+    }
+    batch.groups[key] = Group{static_cast<int>(batch.offsets.size()), count, version};
+    batch.offsets.insert(batch.offsets.end(), offsets.begin(), offsets.end());
+    batch.shapes.insert(batch.shapes.end(), shapes.begin(), shapes.end());
+    batch.colors.resize(batch.offsets.size(), glm::vec3(1.f));
+    batch.resized = batch.resized || count > 0;
+}
+
+void InstanceRenderer::removeRange(Batch &batch, const Group &group) {
+    if (group.count == 0) {
+        return;
+    }
+    batch.offsets.erase(batch.offsets.begin() + group.first, batch.offsets.begin() + group.first + group.count);
+    batch.shapes.erase(batch.shapes.begin() + group.first, batch.shapes.begin() + group.first + group.count);
+    batch.colors.resize(batch.offsets.size());
+    // The groups after it slide down into the gap
+    for (auto &g : batch.groups) {
+        if (g.second.first > group.first) {
+            g.second.first -= group.count;
+        }
+    }
+    batch.resized = true;
+}
+
+void InstanceRenderer::removeGroup(int type, int64_t key) {
+    Batch &batch = m_batches[type];
+    auto it = batch.groups.find(key);
+    if (it != batch.groups.end()) {
+        removeRange(batch, it->second);
+        batch.groups.erase(it);
+    }
+}
+
+void InstanceRenderer::retainGroups(int type, const std::unordered_set<int64_t> &keys) {
+    Batch &batch = m_batches[type];
+    for (auto it = batch.groups.begin(); it != batch.groups.end();) {
+        if (keys.count(it->first) == 0) {
+            removeRange(batch, it->second);
+            it = batch.groups.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t InstanceRenderer::instanceCount() const {
+    size_t count = 0;
+    for (const Batch &batch : m_batches) {
+        count += batch.offsets.size();
+    }
+    return count;
+}
+
+size_t InstanceRenderer::instanceCount(int type) const {
+    return m_batches[type].offsets.size();
+}
+
+void InstanceRenderer::draw(ShaderProgram &prog) {
+    for (Batch &batch : m_batches) {
+        if (batch.resized) {
+            batch.mesh->createInstancedVBOdata(batch.offsets, batch.colors);
+            batch.mesh->setInstanceShapes(batch.shapes);
+        } else if (batch.dirtyEnd > batch.dirtyBegin) {
+            int first = batch.dirtyBegin;
+            batch.mesh->updateInstanceRange(first, batch.dirtyEnd - first, &batch.offsets[first],
+                                            &batch.colors[first], &batch.shapes[first]);
+        }
+        batch.resized = false;
+        batch.dirtyBegin = batch.dirtyEnd = 0;
+        if (!batch.offsets.empty()) {
+            prog.drawInstanced(*batch.mesh);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "drawable.h"
+#include "shaderprogram.h"
+#include <glm_includes.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Draws many copies of a few small models, such as foliage and entities,
+// with one instanced draw call per model. Each model's instances come in
+// groups, one per source (a Chunk, the EntitySystem), packed end to end in
+// one set of instance buffers. A group that keeps its size is re-uploaded
+// in place; adding, removing or resizing one repacks that model's buffers.
+class InstanceRenderer {
+private:
+    struct Group {
+        int first, count;
+        int version; // Whatever the caller passed to setGroup
+    };
+
+    struct Batch {
+        InstancedDrawable *mesh;
+        std::vector<glm::vec3> offsets, colors;
+        std::vector<glm::vec4> shapes;
+        std::unordered_map<int64_t, Group> groups;
+        // Instances overwritten since the last upload, [dirtyBegin, dirtyEnd)
+        int dirtyBegin, dirtyEnd;
+        // The instance count changed, so the buffers are replaced whole
+        bool resized;
+    };
+
+    std::vector<Batch> m_batches;
+
+    static void removeRange(Batch &batch, const Group &group);
+
+public:
+    InstanceRenderer();
+
+    // Registers a model and returns its type. The mesh's own VBO data is left to the caller.
+    int addType(InstancedDrawable *mesh);
+    // Whether the group was last set with this version, so rebuilding it can be skipped
+    bool isCurrent(int type, int64_t key, int version) const;
+    // Replaces the instances of a group, boxes sized and textured by shapes as in
+    // InstancedDrawable::setInstanceShapes. Empty groups are kept for isCurrent.
+    void setGroup(int type, int64_t key, const std::vector<glm::vec3> &offsets,
+                  const std::vector<glm::vec4> &shapes, int version = 0);
+    void removeGroup(int type, int64_t key);
+    // Removes every group of the type that isn't in keys
+    void retainGroups(int type, const std::unordered_set<int64_t> &keys);
+    size_t instanceCount() const;
+    size_t instanceCount(int type) const;
+
+    // Uploads what changed and draws every model that has instances
+    void draw(ShaderProgram &prog);
+};
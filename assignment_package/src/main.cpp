@@ -1,10 +1,11 @@
 #include <mainwindow.h>
+#include "headless.h"
 
 #include <QApplication>
 #include <QSurfaceFormat>
 #include <QDebug>
 
-void debugFormatVersion()
+void debugFormatVersion(FILE *out)
 {
     QSurfaceFormat form = QSurfaceFormat::defaultFormat();
     QSurfaceFormat::OpenGLContextProfile prof = form.profile();
@@ -14,13 +15,20 @@ void debugFormatVersion()
         prof == QSurfaceFormat::CompatibilityProfile ? "Compatibility" :
         "None";
 
-    printf("Requested format:\n");
-    printf("  Version: %d.%d\n", form.majorVersion(), form.minorVersion());
-    printf("  Profile: %s\n", profile);
+    fprintf(out, "Requested format:\n");
+    fprintf(out, "  Version: %d.%d\n", form.majorVersion(), form.minorVersion());
+    fprintf(out, "  Profile: %s\n", profile);
 }
 
 int main(int argc, char *argv[])
 {
+    // The headless benchmark must not need a window. Qt 5's offscreen platform
+    // still needs an X server for GL, see runHeadless.
+    bool headless = wantsHeadless(argc, argv);
+    if (headless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     QApplication a(argc, argv);
 
     // Set OpenGL 4.0 and, optionally, 4-sample multisampling
@@ -34,8 +42,17 @@ int main(int argc, char *argv[])
     /*** Check whether automatic testing is enabled */
     /***/ if (qgetenv("CIS277_AUTOTESTING") != nullptr) format.setSamples(0);
 
+    // Frames are paced by vsync unless asked not to, see MyGL::tick
+    if (QApplication::arguments().contains("--no-vsync")) {
+        format.setSwapInterval(0);
+    }
+
     QSurfaceFormat::setDefaultFormat(format);
-    debugFormatVersion();
+    debugFormatVersion(diagnosticStream());
+
+    if (headless) {
+        return runHeadless();
+    }
 
     MainWindow w;
     w.show();
@@ -18,6 +18,10 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->mygl, SIGNAL(sig_sendPlayerLook(QString)), &playerInfoWindow, SLOT(slot_setLookText(QString)));
     connect(ui->mygl, SIGNAL(sig_sendPlayerChunk(QString)), &playerInfoWindow, SLOT(slot_setChunkText(QString)));
     connect(ui->mygl, SIGNAL(sig_sendPlayerTerrainZone(QString)), &playerInfoWindow, SLOT(slot_setZoneText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendFrameStats(QString)), &playerInfoWindow, SLOT(slot_setFrameText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendSlowestRegions(QString)), &playerInfoWindow, SLOT(slot_setSlowestText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendGpuTimes(QString)), &playerInfoWindow, SLOT(slot_setGpuText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendFrameTimes(QVector<float>)), &playerInfoWindow, SLOT(slot_setFrameTimes(QVector<float>)));
 }
 
 MainWindow::~MainWindow()
@@ -1,27 +1,77 @@
 #include "mygl.h"
 #include "blockworker.h"
 #include "vboworker.h"
+#include "sortworker.h"
 #include <glm_includes.h>
 
 #include <QApplication>
 #include <QKeyEvent>
 #include <QDateTime>
 #include <QThreadPool>
+#include <QDir>
+#include <QDebug>
+#include <cstdio>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include <random>
 
 #include "framebuffer.h"
+#include "scene/collision.h"
+
+// Distances from the camera at which fog starts and fully covers the world.
+// The horizon carries the terrain out to fogEnd.
+const static float fogStart = VIEW_RADIUS - 64.f;
+const static float fogEnd = 896.f;
+// expand only looks at the Chunks again when the player changes zones, so it
+// loads and meshes for anywhere in the zone: half its diagonal, rounded up
+const static float zoneMargin = 48.f;
 
 MyGL::MyGL(QWidget *parent)
     : OpenGLContext(parent),
       m_worldAxes(this),
-      m_progLambert(this), m_progFlat(this), m_progInstanced(this),
-      m_terrain(this), m_player(glm::vec3(-91.f, 271.f, 103.f), m_terrain),
-      m_texture(this), animateTime(0), quad(this), m_progSky(this),  m_progFluid(this),
-      postProcessFrameBuffer(this, this->width(), this->height(), this->devicePixelRatio())
+      m_progLambert(this), m_progFlat(this), m_progInstanced(this), m_progDepth(this), m_depthPrepass(true),
+      m_terrain(this), m_horizon(this, m_terrain), m_progHorizon(this), m_player(glm::vec3(-91.f, 271.f, 103.f), m_terrain),
+      m_frameHistory(), m_lastFrameStart(-1), m_ticksSinceStats(0), m_tickStart(-1), m_gpuProfiler(this),
+      m_traceMode(LIVE), m_trace(), m_tracePath("input.trace"), m_replayFrame(0), m_replayDt(0.f),
+      m_recordOnStart(false), m_replayOnStart(false), m_exitAfterReplay(false),
+      m_pendingRotation(0.f), m_pendingActions(0), m_chunkRequests(),
+      m_replayFrameTimes(), m_replayChunkLatencies(), m_replayStart(0),
+      m_texture(this), animateTime(0), quad(this), m_progSky(this), m_skyLUT(this), m_progSkyLUT(this), m_noise(this), m_bakedNoise(true), m_progFluid(this),
+      m_targetPool(this), m_dynamicResolution(), m_renderGraph(this, &m_targetPool, &m_gpuProfiler), m_drawnChunks(),
+      m_entities(), m_entityCubes(this), m_instances(), m_foliageQuads(this), m_entityType(-1), m_foliageType(-1),
+      m_shadowMap(this), m_progShadow(this)
 {
-    // Connect the timer to a function so that when the timer ticks the function is executed
-    connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
-    // Tell the timer to redraw 60 times per second
-    m_timer.start(16);
+    Profiler::registerMainThread();
+
+    // --record <file> records from startup until F5 or exit, --replay <file> replays a
+    // recording on startup, --replay-dt <ms> sets the replay timestep (0 uses the
+    // recorded ones) and --exit-after-replay quits once the replay is reported.
+    // --sim-rate <Hz> sets how many fixed steps the simulation takes a second.
+    QStringList args = QApplication::arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--record" && i + 1 < args.size()) {
+            m_tracePath = args[++i].toStdString();
+            m_recordOnStart = true;
+        } else if (args[i] == "--replay" && i + 1 < args.size()) {
+            m_tracePath = args[++i].toStdString();
+            m_replayOnStart = true;
+        } else if (args[i] == "--replay-dt" && i + 1 < args.size()) {
+            m_replayDt = args[++i].toFloat();
+        } else if (args[i] == "--exit-after-replay") {
+            m_exitAfterReplay = true;
+        } else if (args[i] == "--render-scale" && i + 1 < args.size()) {
+            m_dynamicResolution.setFixedScale(args[++i].toFloat());
+        } else if (args[i] == "--dynamic-resolution") {
+            m_dynamicResolution.setEnabled(true);
+        } else if (args[i] == "--sim-rate" && i + 1 < args.size()) {
+            m_simStepMs = 1000.f / std::max(1.f, args[++i].toFloat());
+        }
+    }
+    // Tick again as soon as a frame is on screen. The loop runs as fast as
+    // the swap interval lets it, vsync by default and uncapped with --no-vsync.
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(tick()));
+    m_prevEye = m_player.mcr_camera.mcr_position;
     setFocusPolicy(Qt::ClickFocus);
 
     setMouseTracking(true); // MyGL will track the mouse's movements even if a mouse button is not pressed
@@ -29,8 +79,18 @@ MyGL::MyGL(QWidget *parent)
 }
 
 MyGL::~MyGL() {
+    if (m_traceMode == RECORDING) {
+        stopRecording();
+    }
     makeCurrent();
     glDeleteVertexArrays(1, &vao);
+    m_gpuProfiler.destroy();
+    m_shadowMap.destroy();
+    m_skyLUT.destroy();
+    m_noise.destroy();
+    m_targetPool.destroy();
+    m_entityCubes.destroyVBOdata();
+    m_foliageQuads.destroyVBOdata();
 }
 
 
@@ -44,7 +104,7 @@ void MyGL::initializeGL()
     // If you were programming in a non-Qt context you might use GLEW (GL Extension Wrangler)instead
     initializeOpenGLFunctions();
     // Print out some information about the current OpenGL context
-    debugContextVersion();
+    debugContextVersion(diagnosticStream());
 
     // Set a few settings/modes in OpenGL rendering
     glEnable(GL_DEPTH_TEST);
@@ -58,22 +118,35 @@ void MyGL::initializeGL()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    m_gpuProfiler.create();
+
     // Create a Vertex Attribute Object
     glGenVertexArrays(1, &vao);
 
     //Create the instance of the world axes
     m_worldAxes.createVBOdata();
+    m_entityCubes.createVBOdata();
+    m_foliageQuads.createVBOdata();
+    m_entityType = m_instances.addType(&m_entityCubes);
+    m_foliageType = m_instances.addType(&m_foliageQuads);
 
     // Create and set up the diffuse shader
     m_progLambert.create(":/glsl/lambert.vert.glsl", ":/glsl/lambert.frag.glsl");
     // Create and set up the flat lighting shader
     m_progFlat.create(":/glsl/flat.vert.glsl", ":/glsl/flat.frag.glsl");
     m_progInstanced.create(":/glsl/instanced.vert.glsl", ":/glsl/lambert.frag.glsl");
+    // Create and set up the depth pre-pass shader
+    m_progDepth.create(":/glsl/depth.vert.glsl", ":/glsl/depth.frag.glsl");
     // Create and set up the sky shader
     m_progSky.create(":/glsl/sky.vert.glsl", ":/glsl/sky.frag.glsl");
+    m_progSkyLUT.create(":/glsl/sky.vert.glsl", ":/glsl/skylut.frag.glsl");
+    // Create and set up the horizon shader
+    m_progHorizon.create(":/glsl/horizon.vert.glsl", ":/glsl/horizon.frag.glsl");
 
     // Create and set up fluid shader
     m_progFluid.create(":/glsl/fluid.vert.glsl", ":/glsl/fluid.frag.glsl");
+    // Create and set up the shadow map shader
+    m_progShadow.create(":/glsl/shadow.vert.glsl", ":/glsl/shadow.frag.glsl");
 
     quad.createVBOdata();
 
@@ -81,13 +154,29 @@ void MyGL::initializeGL()
     // using multiple VAOs, we can just bind one once.
     glBindVertexArray(vao);
     // Bind the minecraft texture
-    m_texture.create(":/textures/minecraft_textures_all.png");
+    m_texture.create(":/textures/minecraft_textures_all.png", 16);
     m_texture.load(0);
     m_progLambert.setUnifInt("u_Texture", 0);
+    m_progDepth.setUnifInt("u_Texture", 0);
+    m_progLambert.setUnifInt("u_ShadowMap", 2);
+    m_progLambert.setUnifInt("u_SkyLUT", 3);
+    m_progInstanced.setUnifInt("u_ShadowMap", 2);
+    m_progInstanced.setUnifInt("u_SkyLUT", 3);
+    m_progHorizon.setUnifInt("u_SkyLUT", 3);
+    m_progSky.setUnifInt("u_SkyLUT", 3);
+    m_progSkyLUT.setUnifInt("u_WorleyVolume", 4);
+    m_progFluid.setUnifInt("u_NoiseTexture", 5);
+    m_progLambert.setUnifFloat("u_FogStart", fogStart);
+    m_progLambert.setUnifFloat("u_FogEnd", fogEnd);
+    m_progInstanced.setUnifFloat("u_FogStart", fogStart);
+    m_progInstanced.setUnifFloat("u_FogEnd", fogEnd);
+    m_progHorizon.setUnifFloat("u_FogStart", fogStart);
+    m_progHorizon.setUnifFloat("u_FogEnd", fogEnd);
     //m_progFluid.setUnifInt("u_Texture", 0);
 
-    postProcessFrameBuffer.resize(this->width(), this->height(), this->devicePixelRatio());
-    postProcessFrameBuffer.create();
+    m_shadowMap.create();
+    m_skyLUT.create();
+    m_noise.create();
 }
 
 
@@ -102,10 +191,10 @@ void MyGL::resizeGL(int w, int h) {
     m_progLambert.setUnifMat4("u_ViewProj", viewproj);
     m_progFlat.setUnifMat4("u_ViewProj", viewproj);
     m_progInstanced.setUnifMat4("u_ViewProj", viewproj);
+    m_progHorizon.setUnifMat4("u_ViewProj", viewproj);
+    m_progDepth.setUnifMat4("u_ViewProj", viewproj);
 
-
-    postProcessFrameBuffer.resize(w, h, this->devicePixelRatio());
-    postProcessFrameBuffer.create();
+    // The scene target is sized every frame, targets of the old size are let go by the pool
 
     printGLErrorLog();
 
@@ -113,27 +202,181 @@ void MyGL::resizeGL(int w, int h) {
 }
 
 
-// MyGL's constructor links tick() to a timer that fires 60 times per second.
+// MyGL's constructor links tick() to the end of every frame.
 // We're treating MyGL as our game engine class, so we're going to perform
 // all per-frame actions here, such as performing physics updates on all
-// entities in the scene.
+// entities in the scene. The physics run in fixed steps, as many as the
+// time since the last tick covers.
 void MyGL::tick() {
+    m_tickStart = Profiler::now();
+    PROFILE_SCOPE("tick");
     double currTime = QDateTime::currentMSecsSinceEpoch();
-    double deltaTime = currTime - lastTime;
+    if (lastTime > 0) {
+        m_simAccumulator += std::min(currTime - lastTime, MAX_TICK_MS);
+    }
     lastTime = currTime;
-    m_player.tick(deltaTime, m_inputs);
+    if (m_recordOnStart) {
+        m_recordOnStart = false;
+        startRecording();
+    } else if (m_replayOnStart) {
+        m_replayOnStart = false;
+        startReplay();
+    }
+    int steps = 0;
+    while (m_simAccumulator >= m_simStepMs && steps < MAX_SIM_STEPS && !replayFinished()) {
+        PROFILE_SCOPE("player");
+        m_prevEye = m_player.mcr_camera.mcr_position;
+        // The entities step by the same dt as the player, which replays take from the trace
+        TraceFrame frame = nextTraceFrame(m_simStepMs);
+        applyTraceFrame(frame);
+        m_entities.step(frame.dt / 1000.f, m_terrain);
+        m_simAccumulator -= m_simStepMs;
+        m_simTimeMs += frame.dt;
+        ++steps;
+    }
+    if (steps == MAX_SIM_STEPS) {
+        // Too far behind to catch up, drop the backlog rather than fall further behind
+        m_simAccumulator = std::fmod(m_simAccumulator, m_simStepMs);
+    }
+    m_simAlpha = std::min(1.f, static_cast<float>(m_simAccumulator / m_simStepMs));
+    animateTime = static_cast<int>(m_simTimeMs * 60.0 / 1000.0);
+    if (steps > 0) {
+        updateWorld();
+    }
+
+    update(); // Calls paintGL() as part of a larger QOpenGLWidget pipeline
+    sendPlayerDataToGUI(); // Updates the info in the secondary window displaying player data
+    sendFrameStatsToGUI();
+
+    if (replayFinished()) {
+        finishReplay();
+    }
+}
+
+bool MyGL::replayFinished() const {
+    return m_traceMode == REPLAYING && m_replayFrame >= m_trace.getFrames().size();
+}
+
+void MyGL::updateWorld() {
     glm::vec3 currPos = m_player.mcr_position;
     expand(prevPos, currPos);
-    ++animateTime;
+    {
+        PROFILE_SCOPE("horizon");
+        m_horizon.update(currPos, VIEW_RADIUS);
+    }
+    sortTransparency(currPos);
     m_progLambert.setUnifInt("u_Time", animateTime);
+    m_progDepth.setUnifInt("u_Time", animateTime);
     m_progSky.setUnifInt("u_Time", animateTime);
     m_progFluid.setUnifInt("u_Time", animateTime);
+    m_progHorizon.setUnifInt("u_Time", animateTime);
+    prevPos = currPos;
+}
 
-    m_progLambert.setUnifVec3("u_CamPos", glm::vec3(m_player.mcr_position.x, m_player.mcr_position.y, m_player.mcr_position.z));
+TraceFrame MyGL::nextTraceFrame(double deltaTime) {
+    TraceFrame frame;
+    if (m_traceMode == REPLAYING) {
+        frame = m_trace.getFrames()[m_replayFrame++];
+        if (m_replayDt > 0.f) {
+            frame.dt = m_replayDt;
+        }
+    } else {
+        frame = TraceFrame{static_cast<float>(deltaTime), m_pendingRotation.x, m_pendingRotation.y,
+                           InputTrace::packKeys(m_inputs), m_pendingActions};
+        if (m_traceMode == RECORDING) {
+            m_trace.push(frame);
+        }
+    }
+    // Anything the user did during a replay is thrown away
+    m_pendingRotation = glm::vec2(0.f);
+    m_pendingActions = 0;
+    return frame;
+}
 
-    update(); // Calls paintGL() as part of a larger QOpenGLWidget pipeline
-    sendPlayerDataToGUI(); // Updates the info in the secondary window displaying player data
-    prevPos = currPos;
+void MyGL::applyTraceFrame(const TraceFrame &frame) {
+    m_player.rotateOnUpGlobal(frame.rotateUp);
+    m_player.rotateOnRightLocal(frame.rotateRight);
+    if (frame.actions & TOGGLE_FLIGHT) {
+        m_player.toggleFlightMode();
+    }
+    InputBundle inputs;
+    InputTrace::unpackKeys(frame.keys, inputs);
+    m_player.tick(frame.dt, inputs);
+    if (frame.actions & PLACE_BLOCK) {
+        placeBlock();
+    }
+    if (frame.actions & BREAK_BLOCK) {
+        breakBlock();
+    }
+    if (frame.actions & BLAST) {
+        blast();
+    }
+    if (frame.actions & UNDO_EDIT) {
+        undoEdit();
+    }
+}
+
+void MyGL::startRecording() {
+    m_trace.reset(m_player.getState());
+    m_traceMode = RECORDING;
+    qDebug() << "Recording inputs to" << QString::fromStdString(m_tracePath);
+}
+
+void MyGL::stopRecording() {
+    m_traceMode = LIVE;
+    if (m_trace.save(m_tracePath)) {
+        qDebug() << "Saved" << m_trace.getFrames().size() << "ticks of input to" << QString::fromStdString(m_tracePath);
+    } else {
+        qDebug() << "Could not save the input trace to" << QString::fromStdString(m_tracePath);
+    }
+}
+
+void MyGL::startReplay() {
+    if (!m_trace.load(m_tracePath)) {
+        qDebug() << "Could not load the input trace" << QString::fromStdString(m_tracePath);
+        if (m_exitAfterReplay) {
+            QApplication::exit(1);
+        }
+        return;
+    }
+    m_player.setState(m_trace.getStart());
+    m_prevEye = m_player.mcr_camera.mcr_position;
+    m_traceMode = REPLAYING;
+    m_replayFrame = 0;
+    m_replayFrameTimes.clear();
+    m_replayChunkLatencies.clear();
+    m_replayStart = Profiler::now();
+}
+
+// Prints what the replay measured as JSON on stdout
+void MyGL::finishReplay() {
+    m_traceMode = LIVE;
+    double simSeconds = 0.0;
+    for (const TraceFrame &f : m_trace.getFrames()) {
+        simSeconds += (m_replayDt > 0.f ? m_replayDt : f.dt) / 1000.0;
+    }
+    FrameStats frames = summarize(m_replayFrameTimes);
+    FrameStats chunks = summarize(m_replayChunkLatencies);
+    glm::vec3 pos = m_player.mcr_position;
+
+    printf("{\n");
+    printf("  \"benchmark\": \"replay\",\n");
+    printf("  \"trace\": \"%s\",\n", m_tracePath.c_str());
+    printf("  \"ticks\": %zu,\n", m_trace.getFrames().size());
+    printf("  \"replay_dt_ms\": %.3f,\n", m_replayDt);
+    printf("  \"sim_seconds\": %.3f,\n", simSeconds);
+    printf("  \"wall_seconds\": %.3f,\n", (Profiler::now() - m_replayStart) / 1e9);
+    printf("  \"frame_ms\": { \"count\": %zu, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+           m_replayFrameTimes.size(), frames.p50, frames.p99, frames.max);
+    printf("  \"chunk_latency_ms\": { \"count\": %zu, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+           m_replayChunkLatencies.size(), chunks.p50, chunks.p99, chunks.max);
+    printf("  \"final_position\": [%.4f, %.4f, %.4f]\n", pos.x, pos.y, pos.z);
+    printf("}\n");
+    fflush(stdout);
+
+    if (m_exitAfterReplay) {
+        QApplication::exit(0);
+    }
 }
 
 void MyGL::sendPlayerDataToGUI() const {
@@ -148,24 +391,103 @@ void MyGL::sendPlayerDataToGUI() const {
     emit sig_sendPlayerTerrainZone(QString::fromStdString("( " + std::to_string(zone.x) + ", " + std::to_string(zone.y) + " )"));
 }
 
+// "sky lut > shadows > opaque", the passes a frame ran in order
+static QString joinPasses(const std::vector<const char*> &passes) {
+    QStringList names;
+    for (const char *pass : passes) {
+        names.append(pass);
+    }
+    return names.join(" > ");
+}
+
+void MyGL::sendFrameStatsToGUI() {
+    if (++m_ticksSinceStats < 30) {
+        return;
+    }
+    m_ticksSinceStats = 0;
+    FrameStats stats = m_frameHistory.getStats();
+    emit sig_sendFrameStats(QString::asprintf("p50 %.1f  p99 %.1f  max %.1f  scale %.2f", stats.p50, stats.p99, stats.max,
+                                              m_dynamicResolution.getScale()));
+
+    // The stages inside tick and paintGL over the last second
+    QStringList slowest;
+    for (auto &r : Profiler::slowestRegions(1000000000, 5)) {
+        if (r.first != "tick" && r.first != "paintGL" && slowest.size() < 3) {
+            slowest.append(QString::asprintf("%s %.1f", r.first.c_str(), r.second));
+        }
+    }
+    emit sig_sendSlowestRegions(slowest.join(", "));
+
+    QString ran = QString("\nran: ") + joinPasses(m_gpuProfiler.getFramePasses());
+    if (!m_renderGraph.getCulledPasses().empty()) {
+        ran += QString("\nculled: ") + joinPasses(m_renderGraph.getCulledPasses());
+    }
+    if (m_gpuProfiler.isSupported()) {
+        // Each pass's time, and how many fragments it wrote per pixel of the screen
+        std::map<std::string, int64_t> fragments;
+        for (auto &f : m_gpuProfiler.getPassFragments()) {
+            fragments[f.first] = f.second;
+        }
+        float pixels = std::max(1, width() * height());
+        QStringList passes;
+        for (auto &p : m_gpuProfiler.getPassTimes()) {
+            auto f = fragments.find(p.first);
+            if (f != fragments.end() && f->second > 0) {
+                passes.append(QString::asprintf("%s %.2f (%.2fx)", p.first.c_str(), p.second, f->second / pixels));
+            } else {
+                passes.append(QString::asprintf("%s %.2f", p.first.c_str(), p.second));
+            }
+        }
+        emit sig_sendGpuTimes(passes.join(", ") + ran);
+    } else {
+        emit sig_sendGpuTimes(QString("unavailable") + ran);
+    }
+
+    std::vector<float> times = m_frameHistory.getTimes();
+    emit sig_sendFrameTimes(QVector<float>(times.begin(), times.end()));
+}
+
 // This function is called whenever update() is called.
-// MyGL's constructor links update() to a timer that fires 60 times per second,
-// so paintGL() called at a rate of 60 frames per second.
+// tick() calls update() once the last frame is on screen, so paintGL() runs
+// once per swap, at the refresh rate with vsync.
 void MyGL::paintGL() {
+    int64_t frameStart = Profiler::now();
+    if (m_lastFrameStart >= 0) {
+        m_frameHistory.push((frameStart - m_lastFrameStart) / 1e6f);
+        if (m_traceMode == REPLAYING) {
+            m_replayFrameTimes.push_back((frameStart - m_lastFrameStart) / 1e6f);
+        }
+    }
+    m_lastFrameStart = frameStart;
+    PROFILE_SCOPE("paintGL");
+    m_gpuProfiler.beginFrame();
+
     m_texture.bind(0);
     // Clear the screen so that we only see newly drawn images
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glm::mat4 viewproj = m_player.mcr_camera.getViewProj();
+    // Draw from between the last two simulation steps. Only the position is
+    // blended, turning is applied every step and lags by at most one.
+    Camera camera = m_player.mcr_camera;
+    glm::vec3 eye = glm::mix(m_prevEye, camera.mcr_position, m_simAlpha);
+    camera.setPose(eye, camera.F(), camera.R(), camera.U());
+    glm::vec3 camPos = m_player.mcr_position + (eye - m_player.mcr_camera.mcr_position);
+    m_progLambert.setUnifVec3("u_CamPos", camPos);
+    m_progHorizon.setUnifVec3("u_CamPos", camPos);
+    m_progInstanced.setUnifVec3("u_CamPos", camPos);
+
+    glm::mat4 viewproj = camera.getViewProj();
     m_progLambert.setUnifMat4("u_ViewProj", viewproj);
     m_progLambert.setUnifMat4("u_Model", glm::mat4());
     m_progLambert.setUnifMat4("u_ModelInvTr", glm::mat4());
     m_progFlat.setUnifMat4("u_ViewProj", viewproj);
     m_progInstanced.setUnifMat4("u_ViewProj", viewproj);
+    m_progHorizon.setUnifMat4("u_ViewProj", viewproj);
+    m_progDepth.setUnifMat4("u_ViewProj", viewproj);
+    m_progDepth.setUnifMat4("u_Model", glm::mat4());
 
 
-    //renderTerrain();
-    render3dScene();
+    updateNoise();
 
     glDisable(GL_DEPTH_TEST);
     m_progFlat.setUnifMat4("u_Model", glm::mat4());
@@ -173,57 +495,73 @@ void MyGL::paintGL() {
     glEnable(GL_DEPTH_TEST);
 
     // Set values for ray casting in the sky
-    m_progSky.setUnifVec3("eye", m_player.mcr_camera.mcr_position);
-    m_progSky.setUnifVec3("R", m_player.mcr_camera.R());
-    m_progSky.setUnifVec3("U", m_player.mcr_camera.U());
-    m_progSky.setUnifVec3("F", m_player.mcr_camera.F());
+    m_progSky.setUnifVec3("R", camera.R());
+    m_progSky.setUnifVec3("U", camera.U());
+    m_progSky.setUnifVec3("F", camera.F());
     m_progSky.setUnifFloat("aspect", this->width() / (float) this->height());
 
-    m_progLambert.setUnifVec3("eye", m_player.mcr_camera.mcr_position);
-    m_progLambert.setUnifVec3("R", m_player.mcr_camera.R());
-    m_progLambert.setUnifVec3("U", m_player.mcr_camera.U());
-    m_progLambert.setUnifVec3("F", m_player.mcr_camera.F());
-    m_progLambert.setUnifFloat("aspect", this->width() / (float) this->height());
-
-
     m_progFluid.setUnifInt("inWater", m_player.getWaterState() ? 1 : 0);
     m_progFluid.setUnifInt("inLava", m_player.getLavaState() ? 1 : 0);
 
     //m_progLambert.setUnifInt("switchBiome", m_player.currBiome);
     // m_progLambert.setUnifInt("inLava", m_player.getLavaState() ? 1 : 0);
 
+    buildRenderGraph();
+    m_renderGraph.execute();
+    m_targetPool.endFrame();
 
-    // Draw the sky
-    m_progSky.draw(quad);
+    m_gpuProfiler.endFrame();
 
-    //Post Process
-    renderPostProcess();
+    // Judge the scale by the work of the frame, from the start of the tick
+    // to here, leaving out the wait for the swap
+    if (m_tickStart >= 0) {
+        float cpuMs = (Profiler::now() - m_tickStart) / 1e6f;
+        m_dynamicResolution.push(std::max(cpuMs, gpuFrameMs()));
+    }
+}
 
+float MyGL::gpuFrameMs() const {
+    float total = 0.f;
+    const std::vector<const char*> &ran = m_gpuProfiler.getFramePasses();
+    for (auto &p : m_gpuProfiler.getPassTimes()) {
+        for (const char *pass : ran) {
+            if (p.first == pass) {
+                total += std::max(0.f, p.second);
+                break;
+            }
+        }
+    }
+    return total;
 }
 
 
 void MyGL::expand(glm::vec3 prevPos, glm::vec3 currPos) {
+    PROFILE_SCOPE("expand");
     // Compute zone coordinates
     glm::ivec2 prevZone = glm::ivec2(floor(prevPos.x / 64.f) * 64, floor(prevPos.z / 64.f) * 64);
     glm::ivec2 currZone = glm::ivec2(floor(currPos.x / 64.f) * 64, floor(currPos.z / 64.f) * 64);
+    glm::vec2 zoneCenter = glm::vec2(currZone) + glm::vec2(32.f);
     // If currZone does not exist in terrain and zones have changed, expand.
+    // Chunks are loaded out to VIEW_RADIUS, and only get the meshes they
+    // can be drawn with from somewhere in the zone.
     if (prevZone != currZone) {
-        for (int dx = -10; dx < 10; ++dx) {
-            for (int dz = -10; dz <= 10; ++dz) {
+        const float reach = VIEW_RADIUS + zoneMargin;
+        const int steps = static_cast<int>(reach) / 16 + 2;
+        for (int dx = -steps; dx <= steps; ++dx) {
+            for (int dz = -steps; dz <= steps; ++dz) {
                 glm::ivec2 curr = currZone + (glm::ivec2(dx, dz) * 16);
+                if (glm::length(glm::vec2(curr) + glm::vec2(8.f) - zoneCenter) > reach) continue;
+                int levels = m_terrain.getWantedMeshLevels(curr, zoneCenter, zoneMargin);
                 if (!m_terrain.hasChunkAt(curr.x, curr.y)) {
                     Chunk* cPtr = m_terrain.instantiateChunkAt(curr.x, curr.y);
-                    blockMutex.lock();
-                    for (Chunk* n : cPtr->getNeighbors()) {
-                        vboData.insert(n);
-                    }
-                    blockMutex.unlock();
+                    m_chunkRequests[cPtr] = Profiler::now();
                     BlockWorker *bw = new BlockWorker(&m_terrain, &blockMutex, curr.x, curr.y, &vboData);
                     QThreadPool::globalInstance()->start(bw);
                 } else {
                     Chunk* cPtr = m_terrain.getChunkAt(curr.x, curr.y).get();
-                    if (cPtr->elemCount(INDEX) < 0) {
-                        VBOWorker *vw = new VBOWorker(cPtr, &vboMutex, &needBinding);
+                    // Unmeshed, or missing a level it may be drawn at from this zone
+                    if (cPtr->elemCount(INDEX) < 0 || (levels & ~cPtr->getMeshLevels()) != 0) {
+                        VBOWorker *vw = new VBOWorker(cPtr, levels, &vboMutex, &needBinding);
                         QThreadPool::globalInstance()->start(vw);
                     }
                 }
@@ -232,71 +570,266 @@ void MyGL::expand(glm::vec3 prevPos, glm::vec3 currPos) {
     }
     // Check shared data structures
     blockMutex.lock();
-    for (Chunk* cPtr : vboData) {
-        VBOWorker *vw = new VBOWorker(cPtr, &vboMutex, &needBinding);
-        QThreadPool::globalInstance()->start(vw);
-    }
+    std::vector<Chunk*> filled(vboData.begin(), vboData.end());
     vboData.clear();
     blockMutex.unlock();
+    // Spread the light of the new Chunks into their lit neighbors and back,
+    // then mesh them along with the neighbors and every Chunk the light reached
+    std::unordered_set<Chunk*> relit;
+    {
+        PROFILE_SCOPE("join chunk light");
+        for (Chunk* cPtr : filled) {
+            m_terrain.chunkLit(cPtr, relit);
+        }
+    }
+    for (Chunk* cPtr : relit) {
+        int levels = m_terrain.getWantedMeshLevels(cPtr->getMin(), zoneCenter, zoneMargin);
+        VBOWorker *vw = new VBOWorker(cPtr, levels, &vboMutex, &needBinding);
+        QThreadPool::globalInstance()->start(vw);
+    }
     // Bind to GPU
     vboMutex.lock();
-    for (Chunk* cPtr : needBinding) {
-        cPtr->createVBOdata();
+    {
+        PROFILE_SCOPE("upload chunks");
+        int64_t now = Profiler::now();
+        for (Chunk* cPtr : needBinding) {
+            cPtr->createVBOdata();
+            // How long the Chunk took to go from requested to drawable
+            auto request = m_chunkRequests.find(cPtr);
+            if (request != m_chunkRequests.end()) {
+                if (m_traceMode == REPLAYING) {
+                    m_replayChunkLatencies.push_back((now - request->second) / 1e6f);
+                }
+                m_chunkRequests.erase(request);
+            }
+        }
+    }
+    // The horizon's hole has to grow to fit the new Chunks
+    if (!needBinding.empty()) {
+        m_horizon.markDirty();
     }
     needBinding.clear();
     vboMutex.unlock();
 }
 
 
-// Change this so it renders the nine zones of generated
-// terrain that surround the player (refer to Terrain::m_generatedTerrain
-// for more info)
-void MyGL::renderTerrain() {
+void MyGL::sortTransparency(glm::vec3 viewPos) {
+    PROFILE_SCOPE("sort transparency");
+    // Upload the orders that finished since the last tick
+    sortMutex.lock();
+    for (SortedFaces &s : sortedFaces) {
+        s.chunk->setTransparentOrder(s.idx, s.version);
+    }
+    sortedFaces.clear();
+    sortMutex.unlock();
+    // Misordered faces only stand out up close, so just sort the nine nearest Chunks
+    int x = glm::floor(viewPos.x / 16.f) * 16;
+    int z = glm::floor(viewPos.z / 16.f) * 16;
+    for (int dx = -16; dx <= 16; dx += 16) {
+        for (int dz = -16; dz <= 16; dz += 16) {
+            if (m_terrain.hasChunkAt(x + dx, z + dz)) {
+                Chunk *cPtr = m_terrain.getChunkAt(x + dx, z + dz).get();
+                if (cPtr->needsTransparentSort(viewPos)) {
+                    SortWorker *sw = new SortWorker(cPtr, viewPos, &sortMutex, &sortedFaces);
+                    QThreadPool::globalInstance()->start(sw);
+                }
+            }
+        }
+    }
+}
+
+// Every frame is built from scratch, so passes come and go with the settings
+// and the player's surroundings. The sky LUT and the shadow map live across
+// frames and are only redrawn by their passes; the scene target only exists
+// while something post-processes it.
+void MyGL::buildRenderGraph() {
+    int width = this->width() * this->devicePixelRatio();
+    int height = this->height() * this->devicePixelRatio();
+    glm::vec4 skyBlue(0.37f, 0.74f, 1.0f, 1.f);
+
+    RenderGraph::Resource screen = m_renderGraph.import("screen", [this, width, height]() {
+        bindScreen();
+        glViewport(0, 0, width, height);
+    });
+    m_renderGraph.markOutput(screen);
+    m_renderGraph.setClear(screen, skyBlue);
+    RenderGraph::Resource skyLUT = m_renderGraph.import("sky lut");
+    RenderGraph::Resource shadowMap = m_renderGraph.import("shadow map");
+    RenderGraph::Resource scene = screen;
+    if (needsPostProcess()) {
+        scene = m_renderGraph.createTarget("scene", m_dynamicResolution.scaled(width), m_dynamicResolution.scaled(height));
+        m_renderGraph.setClear(scene, skyBlue);
+    }
 
-    m_texture.bind(0);
     int x = glm::floor(m_player.mcr_position.x / 16.f) * 16;
     int z = glm::floor(m_player.mcr_position.z / 16.f) * 16;
-    m_terrain.draw(x - 3 * 64, x + 3 * 64, z - 3 * 64, z + 3 * 64, &m_progLambert);
+    m_drawnChunks = m_terrain.getMeshedChunks(x - VIEW_RADIUS, x + VIEW_RADIUS, z - VIEW_RADIUS, z + VIEW_RADIUS);
+    Terrain::sortFrontToBack(m_drawnChunks, m_player.mcr_position);
+    updateInstances();
+
+    // Bakes the sky LUT if the time of day has moved on
+    if (m_skyLUT.isStale(animateTime)) {
+        m_renderGraph.addPass("sky lut", {}, {skyLUT}, [this]() {
+            m_skyLUT.update(animateTime, m_progSkyLUT, quad);
+        });
+    }
+    m_renderGraph.addPass("shadows", {}, {shadowMap}, [this]() {
+        renderShadows();
+    });
+    if (m_depthPrepass) {
+        m_renderGraph.addPass("depth prepass", {}, {scene}, [this]() {
+            renderDepthPrepass();
+        });
+    }
+    m_renderGraph.addPass("opaque", {skyLUT, shadowMap}, {scene}, [this]() {
+        renderOpaque();
+    });
+    if (m_instances.instanceCount() > 0) {
+        m_renderGraph.addPass("instances", {skyLUT}, {scene}, [this]() {
+            renderInstances();
+        });
+    }
+    m_renderGraph.addPass("transparent", {skyLUT, shadowMap}, {scene}, [this]() {
+        renderTransparent();
+    });
+    m_renderGraph.addPass("sky", {skyLUT}, {scene}, [this]() {
+        m_skyLUT.bindToTextureSlot(3);
+        m_progSky.draw(quad);
+    });
+    if (scene != screen) {
+        m_renderGraph.addPass("post process", {scene}, {screen}, [this, scene]() {
+            renderPostProcess(m_renderGraph.getTarget(scene));
+        });
+    }
 }
 
-// Bind the post-process frame buffer,
-// diverting the output of  render
-// calls to the texture within the frame buffer
-// rather than MainWindow display.
-void MyGL::render3dScene() {
-    postProcessFrameBuffer.bindFrameBuffer();
-    glViewport(0, 0, this->width(), this->height());
-    // Clear the screen so that we only see newly drawn images
-    glClearColor(0.37f, 0.74f, 1.0f, 1);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void MyGL::renderDepthPrepass() {
+    m_texture.bind(0);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    m_terrain.drawSolid(m_drawnChunks, m_player.mcr_position, &m_progDepth);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void MyGL::renderOpaque() {
+    m_texture.bind(0);
+    m_shadowMap.bindToTextureSlot(2);
+    m_skyLUT.bindToTextureSlot(3);
+    if (m_depthPrepass) {
+        // Only the nearest fragment of every pixel is left to shade. The depth is
+        // already final, and leaving it untouched keeps early-Z on despite the discard.
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+    m_terrain.drawSolid(m_drawnChunks, m_player.mcr_position, &m_progLambert);
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_TRUE);
+    if (m_horizon.elemCount(INDEX) > 0) {
+        m_progHorizon.draw(m_horizon);
+    }
+}
 
-    renderTerrain();
+void MyGL::updateInstances() {
+    std::unordered_set<int64_t> nearby;
+    for (Chunk *c : m_drawnChunks) {
+        if (m_terrain.getDrawLevel(*c, m_player.mcr_position) != 0) continue;
+        glm::ivec2 min = c->getMin();
+        int64_t key = toKey(min.x, min.y);
+        nearby.insert(key);
+        if (!m_instances.isCurrent(m_foliageType, key, c->getMeshVersion())) {
+            m_instances.setGroup(m_foliageType, key, c->getDecorationOffsets(), c->getDecorationShapes(), c->getMeshVersion());
+        }
+    }
+    m_instances.retainGroups(m_foliageType, nearby);
 
+    // The entities move every frame, but keep their count between spawns
+    std::vector<glm::vec3> offsets;
+    std::vector<glm::vec4> shapes;
+    m_entities.getInstances(m_simAlpha, offsets, shapes);
+    m_instances.setGroup(m_entityType, 0, offsets, shapes);
 }
 
-//Renders post process effects, player in fluid
-void MyGL::renderPostProcess() {
-    // Bind the default framebuffer (screen framebuffer)
-    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+void MyGL::renderInstances() {
+    m_texture.bind(0);
+    m_instances.draw(m_progInstanced);
+}
 
-    // Set the viewport to match the window size
-   glViewport(0, 0, this->width() * this->devicePixelRatio(), this->height() * this->devicePixelRatio());
+void MyGL::spawnEntities(int count, glm::vec2 center, float radius, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    for (int i = 0; i < count; ++i) {
+        float angle = 2.f * M_PI * unit(rng);
+        float dist = radius * glm::sqrt(unit(rng));
+        float x = center.x + dist * glm::cos(angle);
+        float z = center.y + dist * glm::sin(angle);
+        BiomeType biome;
+        glm::vec3 pos(x, m_terrain.getSurfaceHeight(x, z, &biome) + 1.f + 8.f * unit(rng), z);
+        // One in four is a block that just falls, the rest walk off in some direction
+        if (i % 4 == 0) {
+            m_entities.spawn(pos, glm::vec3(0.f), glm::vec3(0.5f), blockInfo(SAND).tiles[0]);
+        } else {
+            float heading = 2.f * M_PI * unit(rng);
+            glm::vec3 vel = 2.f * glm::vec3(glm::cos(heading), 0.f, glm::sin(heading));
+            m_entities.spawn(pos, vel, glm::vec3(0.4f, 0.9f, 0.4f), blockInfo(WOOD).tiles[0]);
+        }
+    }
+}
 
-    // Clear the screen with a solid color
-    glClearColor(0.37f, 0.74f, 1.0f, 1);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void MyGL::renderTransparent() {
+    int x = glm::floor(m_player.mcr_position.x / 16.f) * 16;
+    int z = glm::floor(m_player.mcr_position.z / 16.f) * 16;
+    m_terrain.drawTransparent(x - VIEW_RADIUS, x + VIEW_RADIUS, z - VIEW_RADIUS, z + VIEW_RADIUS, m_player.mcr_position, &m_progLambert);
+}
 
-    printGLErrorLog();
+void MyGL::updateNoise() {
+    if (m_noise.update()) {
+        m_skyLUT.invalidate();
+    }
+    int baked = m_bakedNoise && m_noise.isReady() ? 1 : 0;
+    m_progSkyLUT.setUnifInt("u_BakedNoise", baked);
+    m_progFluid.setUnifInt("u_BakedNoise", baked);
+    m_noise.bindToTextureSlots(4, 5);
+}
+
+void MyGL::renderShadows() {
+    int x = glm::floor(m_player.mcr_position.x / 16.f) * 16;
+    int z = glm::floor(m_player.mcr_position.z / 16.f) * 16;
+    m_shadowMap.render(m_terrain, x - VIEW_RADIUS, x + VIEW_RADIUS, z - VIEW_RADIUS, z + VIEW_RADIUS, m_player.mcr_position, animateTime, m_progShadow);
+
+    std::array<glm::mat4, ShadowMap::CASCADES> cascades;
+    for (int i = 0; i < ShadowMap::CASCADES; ++i) {
+        cascades[i] = m_shadowMap.getViewProj(i);
+    }
+    m_progLambert.setUnifMat4Array("u_ShadowViewProj", cascades.data(), ShadowMap::CASCADES);
+    m_progLambert.setUnifInt("u_ShadowsOn", m_shadowMap.isSunUp() ? 1 : 0);
+}
+
+bool MyGL::needsPostProcess() {
+    int w = this->width() * this->devicePixelRatio();
+    int h = this->height() * this->devicePixelRatio();
+    return m_player.getWaterState() || m_player.getLavaState() ||
+           m_dynamicResolution.scaled(w) != w || m_dynamicResolution.scaled(h) != h;
+}
 
-    // Bind the texture from the post-processing framebuffer to texture slot 0
-    postProcessFrameBuffer.bindToTextureSlot(1);
+void MyGL::bindScreen() {
+    if (mp_headlessTarget) {
+        mp_headlessTarget->bindFrameBuffer();
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    }
+}
+
+//Renders post process effects, player in fluid, into the screen the render graph bound
+void MyGL::renderPostProcess(FrameBuffer *scene) {
+    // Bind the texture from the post-processing framebuffer to texture slot 1
+    // Upscaled by the texture's linear filtering if the scene was drawn smaller
+    scene->bindToTextureSlot(1);
     printGLErrorLog();
 
     // Use the post-processing shader program
     m_progFluid.useMe();
 
     // Set the texture uniform for the post-processing shader
-    m_progFluid.setUnifInt("u_Texture", postProcessFrameBuffer.getTextureSlot());
+    m_progFluid.setUnifInt("u_Texture", scene->getTextureSlot());
 
     // Draw the full-screen quad with the texture
     m_progFluid.draw(quad);
@@ -320,13 +853,13 @@ void MyGL::keyPressEvent(QKeyEvent *e) {
     if (e->key() == Qt::Key_Escape) {
         QApplication::quit();
     } else if (e->key() == Qt::Key_Right) {
-        m_player.rotateOnUpGlobal(-amount);
+        m_pendingRotation.x -= amount;
     } else if (e->key() == Qt::Key_Left) {
-        m_player.rotateOnUpGlobal(amount);
+        m_pendingRotation.x += amount;
     } else if (e->key() == Qt::Key_Up) {
-        m_player.rotateOnRightLocal(-amount);
+        m_pendingRotation.y -= amount;
     } else if (e->key() == Qt::Key_Down) {
-        m_player.rotateOnRightLocal(amount);
+        m_pendingRotation.y += amount;
     } else if (e->key() == Qt::Key_W) {
         m_inputs.wPressed = true;
         //m_player.moveForwardLocal(amount);
@@ -346,9 +879,46 @@ void MyGL::keyPressEvent(QKeyEvent *e) {
         m_inputs.ePressed = true;
         //m_player.moveUpGlobal(amount);
     } else if (e->key() == Qt::Key_F) {
-        m_player.toggleFlightMode();
+        m_pendingActions |= TOGGLE_FLIGHT;
+    } else if (e->key() == Qt::Key_X) {
+        m_pendingActions |= BLAST;
+    } else if (e->key() == Qt::Key_Z) {
+        m_pendingActions |= UNDO_EDIT;
     } else if (e->key() == Qt::Key_Space) {
         m_inputs.spacePressed = true;
+    } else if (e->key() == Qt::Key_P) {
+        // Dump the recent CPU timings for chrome://tracing or Perfetto
+        std::string path = QDir::current().absoluteFilePath("trace.json").toStdString();
+        if (Profiler::exportChromeTrace(path)) {
+            qDebug() << "Wrote CPU trace to" << QString::fromStdString(path);
+        } else {
+            qDebug() << "Could not write CPU trace to" << QString::fromStdString(path);
+        }
+    } else if (e->key() == Qt::Key_F5) {
+        // Start or stop recording the inputs to m_tracePath
+        if (m_traceMode == RECORDING) {
+            stopRecording();
+        } else if (m_traceMode == LIVE) {
+            startRecording();
+        }
+    } else if (e->key() == Qt::Key_F6) {
+        // Replay the inputs last saved to m_tracePath
+        if (m_traceMode == LIVE) {
+            startReplay();
+        }
+    } else if (e->key() == Qt::Key_F7) {
+        m_depthPrepass = !m_depthPrepass;
+        qDebug() << "Depth pre-pass" << (m_depthPrepass ? "on" : "off");
+    } else if (e->key() == Qt::Key_F8) {
+        // Compare the baked noise against the analytic noise, and their GPU times
+        m_bakedNoise = !m_bakedNoise;
+        m_skyLUT.invalidate();
+        qDebug() << (m_bakedNoise ? "Baked noise" : "Analytic noise");
+    } else if (e->key() == Qt::Key_F9) {
+        m_dynamicResolution.setEnabled(!m_dynamicResolution.isEnabled());
+        qDebug() << "Dynamic resolution" << (m_dynamicResolution.isEnabled() ? "on" : "off");
+    } else if (e->key() == Qt::Key_F10) {
+        spawnEntities(1000, glm::vec2(m_player.mcr_position.x, m_player.mcr_position.z), 32.f, m_entities.size());
     }
 
 
@@ -392,31 +962,222 @@ void MyGL::mouseMoveEvent(QMouseEvent *e) {
 
     float rotateUp = 0.09 * (screenX - pos.x);
     float rotateRight = 0.09 * (screenY - pos.y);
-    m_player.rotateOnUpGlobal(rotateUp);
-    m_player.rotateOnRightLocal(rotateRight);
+    m_pendingRotation += glm::vec2(rotateUp, rotateRight);
     moveMouseToCenter();
 
 }
 
 void MyGL::mousePressEvent(QMouseEvent *e) {
 
+    // The edits happen in tick so that they can be recorded
     if(e->buttons() & (Qt::RightButton))
     {
-        glm::vec3 blockCoord = m_player.placeBlock(m_terrain);
-
-       // qDebug() << blockCoord.x << " " << blockCoord.y << " " << blockCoord.z;
-        m_terrain.setGlobalBlockAt(blockCoord.x, blockCoord.y, blockCoord.z, WOOD);
-       // m_terrain.generateTree(blockCoord.x, blockCoord.y, blockCoord.z);
+        m_pendingActions |= PLACE_BLOCK;
     }
 
     if(e->buttons() & (Qt::LeftButton))
     {
-        glm::vec3 blockCoord = m_player.getBlock(m_terrain);
-        if (m_player.validBlock()) {
-            m_terrain.setGlobalBlockAt(blockCoord.x, blockCoord.y, blockCoord.z, EMPTY);
+        m_pendingActions |= BREAK_BLOCK;
+    }
+
+
+}
+
+void MyGL::placeBlock() {
+    glm::vec3 blockCoord = m_player.placeBlock(m_terrain);
+
+   // qDebug() << blockCoord.x << " " << blockCoord.y << " " << blockCoord.z;
+    m_terrain.setGlobalBlockAt(blockCoord.x, blockCoord.y, blockCoord.z, WOOD);
+   // m_terrain.generateTree(blockCoord.x, blockCoord.y, blockCoord.z);
+}
+
+void MyGL::breakBlock() {
+    glm::vec3 blockCoord = m_player.getBlock(m_terrain);
+    if (m_player.validBlock()) {
+        m_terrain.setGlobalBlockAt(blockCoord.x, blockCoord.y, blockCoord.z, EMPTY);
+    }
+}
+
+void MyGL::blast() {
+    ChunkView view(m_terrain);
+    RayHit hit;
+    if (!raycastBlocks(view, m_player.mcr_camera.mcr_position, m_player.getState().forward, 64.f, &hit)) {
+        return;
+    }
+    BlockEditBuffer ball, edits;
+    ball.fillSphere(glm::vec3(hit.block) + 0.5f, 4.f, EMPTY);
+    for (const BlockEditBuffer::Edit &e : ball.getEdits()) {
+        if (blockInfo(view.getBlockAt(e.pos.x, e.pos.y, e.pos.z)).breakable) {
+            edits.set(e.pos, EMPTY);
         }
+    }
+    BlockEditRecord undo;
+    m_terrain.applyEdits(edits, &undo);
+    if (undo.empty()) {
+        return;
+    }
+    if (static_cast<int>(m_editHistory.size()) >= EDIT_HISTORY) {
+        m_editHistory.erase(m_editHistory.begin());
+    }
+    m_editHistory.push_back(std::move(undo));
+}
+
+void MyGL::undoEdit() {
+    if (m_editHistory.empty()) {
+        return;
+    }
+    m_terrain.applyEdits(m_editHistory.back().toEdits());
+    m_editHistory.pop_back();
+}
+
+size_t MyGL::pregenerate(glm::vec2 center, float reach, unsigned int seed) {
+    std::vector<Chunk*> chunks;
+    glm::ivec2 min = 16 * glm::ivec2(glm::floor((center - reach) / 16.f));
+    glm::ivec2 max = 16 * glm::ivec2(glm::ceil((center + reach) / 16.f));
+    for (int x = min.x; x < max.x; x += 16) {
+        for (int z = min.y; z < max.y; z += 16) {
+            if (glm::length(glm::vec2(x + 8, z + 8) - center) > reach) continue;
+            if (!m_terrain.hasChunkAt(x, z)) {
+                chunks.push_back(m_terrain.instantiateChunkAt(x, z));
+            }
+        }
+    }
+    // Assets are placed with rand(), so fill on this thread in a fixed order
+    srand(seed);
+    for (Chunk *c : chunks) {
+        glm::ivec2 cMin = c->getMin();
+        m_terrain.fillChunk(c, cMin.x, cMin.y);
+    }
+    // Each Chunk is lit on its own, then its light is joined up with the
+    // Chunks lit before it, so that goes in order too
+    std::unordered_set<Chunk*> relit;
+    for (Chunk *c : chunks) {
+        c->computeLight();
+        m_terrain.chunkLit(c, relit);
+    }
+    // Meshing is deterministic and can use every core. Every level is built
+    // so nothing is remeshed while the camera moves.
+    QMutex meshMutex;
+    std::vector<Chunk*> meshed;
+    for (Chunk *c : chunks) {
+        QThreadPool::globalInstance()->start(new VBOWorker(c, MESH_ALL, &meshMutex, &meshed));
+    }
+    QThreadPool::globalInstance()->waitForDone();
+    for (Chunk *c : chunks) {
+        c->createVBOdata();
+    }
+    return chunks.size();
+}
 
+uint64_t MyGL::checksumHeadlessTarget() {
+    int w = width() * devicePixelRatio(), h = height() * devicePixelRatio();
+    std::vector<unsigned char> pixels(w * h * 4);
+    mp_headlessTarget->bindFrameBuffer();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char p : pixels) {
+        hash = (hash ^ p) * 1099511628211ull;
     }
+    return hash;
+}
 
+void MyGL::renderHeadless(const HeadlessOptions &options, HeadlessResult &result) {
+    resize(options.width, options.height);
+    initializeGL();
+    resizeGL(options.width, options.height);
+    mp_headlessTarget = mkU<FrameBuffer>(this, options.width, options.height, devicePixelRatio());
+    mp_headlessTarget->create();
+    m_depthPrepass = options.depthPrepass;
+    m_bakedNoise = options.bakedNoise;
+    // Frame times vary run to run, keep the scale fixed so the images don't
+    m_dynamicResolution.setEnabled(false);
+    m_dynamicResolution.setFixedScale(options.renderScale);
+
+    // Orbit the spawn point, looking down at it
+    const glm::vec2 center(-91.f, 103.f);
+    const float radius = 48.f;
+    BiomeType biome;
+    const float height = m_terrain.getSurfaceHeight(center.x, center.y, &biome) + 40.f;
+
+    // Cover what the terrain passes draw and expand keeps loaded from anywhere on the
+    // orbit, so nothing streams in while timing
+    const float reach = radius + VIEW_RADIUS + 2.f * zoneMargin;
+    int64_t generateStart = Profiler::now();
+    result.chunks = pregenerate(center, reach, options.seed);
+    result.generateSeconds = (Profiler::now() - generateStart) / 1e9;
+
+    spawnEntities(options.entities, center, radius, options.seed);
+
+    // Long rays from around the orbit, the kind a line of sight check casts
+    const int raycasts = 10000;
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    ChunkView view(m_terrain);
+    RayHit hit;
+    int64_t raycastStart = Profiler::now();
+    for (int i = 0; i < raycasts; ++i) {
+        float angle = M_PI * unit(rng);
+        glm::vec3 origin(center.x + radius * glm::cos(angle), height, center.y + radius * glm::sin(angle));
+        glm::vec3 dir(unit(rng), unit(rng) - 0.5f, unit(rng));
+        result.raycastHits += raycastBlocks(view, origin, dir, 128.f, &hit) ? 1 : 0;
+    }
+    result.raycastMicros = (Profiler::now() - raycastStart) / 1e3f / raycasts;
+
+    std::map<std::string, int> passFrames;
+    for (int f = 0; f < options.frames; ++f) {
+        float angle = 2.f * M_PI * f / options.frames;
+        glm::vec3 pos(center.x + radius * glm::cos(angle), height, center.y + radius * glm::sin(angle));
+        glm::vec3 forward = glm::normalize(glm::vec3(center.x, height - 40.f, center.y) - pos);
+        glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0, 1, 0)));
+        glm::vec3 up = glm::cross(right, forward);
+
+        int64_t frameStart = Profiler::now();
+        m_player.setState(PlayerState{pos, forward, right, up, glm::vec3(0.f), true});
+        ++animateTime;
+        m_entities.step(1.f / 60.f, m_terrain);
+        result.entityStepMs.push_back(m_entities.getLastStepMs());
+        updateWorld();
+        int64_t updateEnd = Profiler::now();
+        // Let this frame's worker jobs land before drawing so every run sees the
+        // same world. Waiting is left out of the frame time.
+        QThreadPool::globalInstance()->waitForDone();
+        int64_t drawStart = Profiler::now();
+        paintGL();
+        glFinish();
+        int64_t drawEnd = Profiler::now();
+        for (const char *pass : m_gpuProfiler.getFramePasses()) {
+            ++passFrames[pass];
+        }
+        result.frameMs.push_back(((updateEnd - frameStart) + (drawEnd - drawStart)) / 1e6f);
+
+        if ((f + 1) % options.checksumInterval == 0 || f == options.frames - 1) {
+            result.checksums.push_back(std::make_pair(f, checksumHeadlessTarget()));
+        }
+    }
 
+    // A fill of 22 x 21 x 22 blocks around the surface and its undo, after the
+    // frames so the images don't see it
+    BlockEditBuffer fill;
+    glm::ivec3 fillCenter = glm::ivec3(glm::floor(glm::vec3(center.x, height - 40.f, center.y)));
+    fill.fillBox(fillCenter - glm::ivec3(11, 10, 11), fillCenter + glm::ivec3(10, 10, 10), STONE);
+    BlockEditRecord undo;
+    int64_t editStart = Profiler::now();
+    EditResult filled = m_terrain.applyEdits(fill, &undo);
+    int64_t undoStart = Profiler::now();
+    EditResult undone = m_terrain.applyEdits(undo.toEdits());
+    int64_t undoEnd = Profiler::now();
+    result.editBlocks = fill.size();
+    result.editChanged = filled.changed;
+    result.editRemeshed = filled.remeshed;
+    result.editMs = (undoStart - editStart) / 1e6f;
+    result.undoMs = (undoEnd - undoStart) / 1e6f;
+    result.undoRemeshed = undone.remeshed;
+    result.undoBytes = undo.bytes();
+
+    result.gpuPasses = m_gpuProfiler.getPassTimes();
+    result.gpuFragments = m_gpuProfiler.getPassFragments();
+    result.passFrames = std::vector<std::pair<std::string, int>>(passFrames.begin(), passFrames.end());
+    mp_headlessTarget->destroy();
+    mp_headlessTarget.reset();
 }
@@ -5,7 +5,11 @@
 #include "shaderprogram.h"
 #include "scene/worldaxes.h"
 #include "scene/terrain.h"
+#include "scene/horizon.h"
 #include "scene/player.h"
+#include "scene/entitysystem.h"
+#include "scene/cube.h"
+#include "scene/crossquad.h"
 #include "texture.h"
 #include "quad.h"
 
@@ -14,6 +18,18 @@
 #include <smartpointerhelp.h>
 
 #include "framebuffer.h"
+#include "rendertargetpool.h"
+#include "rendergraph.h"
+#include "instancerenderer.h"
+#include "dynamicresolution.h"
+#include "shadowmap.h"
+#include "skylut.h"
+#include "noisetextures.h"
+#include "sortworker.h"
+#include "profiler.h"
+#include "gpuprofiler.h"
+#include "inputtrace.h"
+#include "headless.h"
 
 class MyGL : public OpenGLContext
 {
@@ -23,49 +39,172 @@ private:
     ShaderProgram m_progLambert;// A shader program that uses lambertian reflection
     ShaderProgram m_progFlat;// A shader program that uses "flat" reflection (no shadowing at all)
     ShaderProgram m_progInstanced;// A shader program that is designed to be compatible with instanced rendering
+    ShaderProgram m_progDepth; // Depth only, lays down the depth of the solid Chunk meshes before they are shaded
+    // Whether the terrain passes draw the solid meshes' depth first and then shade
+    // them with GL_EQUAL, so lambert.frag.glsl runs about once per pixel. F7 toggles it.
+    bool m_depthPrepass;
 
     GLuint vao; // A handle for our vertex array object. This will store the VBOs created in our geometry classes.
                 // Don't worry too much about this. Just know it is necessary in order to render geometry.
 
     Terrain m_terrain; // All of the Chunks that currently comprise the world.
+    Horizon m_horizon; // A coarse heightfield of the world beyond the loaded Chunks.
+    ShaderProgram m_progHorizon; // A shader program for the horizon heightfield
     Player m_player; // The entity controlled by the user. Contains a camera to display what it sees as well.
     InputBundle m_inputs; // A collection of variables to be updated in keyPressEvent, mouseMoveEvent, mousePressEvent, etc.
 
-    QTimer m_timer; // Timer linked to tick(). Fires approximately 60 times per second.
 
     void moveMouseToCenter(); // Forces the mouse position to the screen's center. You should call this
                               // from within a mouse move event after reading the mouse movement so that
                               // your mouse stays within the screen bounds and is always read.
 
     void sendPlayerDataToGUI() const;
+    // Sends the frame time graph and stats to the secondary window every few ticks
+    void sendFrameStatsToGUI();
+    FrameHistory m_frameHistory; // Time between the starts of consecutive paintGL calls
+    int64_t m_lastFrameStart;
+    int m_ticksSinceStats;
+    int64_t m_tickStart; // When the tick that asked for this frame began
+    // The smoothed GPU time of the passes the last finished frame ran, 0 without timer queries
+    float gpuFrameMs() const;
+    GpuProfiler m_gpuProfiler; // Times the render passes on the GPU
+
+    // Recording and replaying the player's inputs. Input events only collect
+    // into m_inputs, m_pendingRotation and m_pendingActions, and tick turns
+    // them into one TraceFrame which is what actually moves the player.
+    enum TraceMode { LIVE, RECORDING, REPLAYING };
+    TraceMode m_traceMode;
+    InputTrace m_trace;
+    std::string m_tracePath; // Where recordings are saved and replays are loaded from
+    size_t m_replayFrame;
+    float m_replayDt; // Fixed timestep of replays in milliseconds, 0 to use the recorded ones
+    bool m_recordOnStart, m_replayOnStart, m_exitAfterReplay;
+    glm::vec2 m_pendingRotation; // Degrees about the up and right axes since the last tick
+    uint8_t m_pendingActions; // TraceAction flags since the last tick
+    // When expand asked for each Chunk that has not been drawable yet
+    std::unordered_map<Chunk*, int64_t> m_chunkRequests;
+    // Measured while replaying, reported when the replay ends
+    std::vector<float> m_replayFrameTimes, m_replayChunkLatencies;
+    int64_t m_replayStart;
+
+    void startRecording();
+    void stopRecording();
+    void startReplay();
+    void finishReplay();
+    // The live inputs since the last tick, or the next frame of the replay
+    TraceFrame nextTraceFrame(double deltaTime);
+    void applyTraceFrame(const TraceFrame &frame);
+    void breakBlock();
+    void placeBlock();
+    // X clears a ball of blocks where the player is looking, Z takes back the
+    // latest such edit. Both go through Terrain::applyEdits as one batch.
+    void blast();
+    void undoEdit();
+    std::vector<BlockEditRecord> m_editHistory; // Oldest first
+    const static int EDIT_HISTORY = 32;
+
+    // Everything tick does to the world once the player has moved
+    void updateWorld();
+    // Where renderPostProcess draws in headless mode instead of the screen
+    uPtr<FrameBuffer> mp_headlessTarget;
+    // Generates and meshes every Chunk within reach of center up front
+    size_t pregenerate(glm::vec2 center, float reach, unsigned int seed);
+    // FNV-1a hash of the pixels of mp_headlessTarget
+    uint64_t checksumHeadlessTarget();
     glm::vec3 prevPos;
     glm::vec2 m_mousePosPrev;
     double lastTime = 0;
 
+    // The simulation advances in fixed steps of m_simStepMs whatever the
+    // frame rate, eating the wall-clock time tick banks in m_simAccumulator.
+    // Frames are drawn with the camera between the last two steps.
+    const static int MAX_SIM_STEPS = 5; // Per tick, time beyond that is dropped
+    constexpr static double MAX_TICK_MS = 250.0; // A longer stall is not caught up on
+    float m_simStepMs = 1000.f / 60.f; // --sim-rate <Hz> sets it
+    double m_simAccumulator = 0.0;
+    double m_simTimeMs = 0.0; // Simulated time since start
+    float m_simAlpha = 1.f; // How far the drawn camera is from the previous step to the last
+    glm::vec3 m_prevEye = glm::vec3(0.f); // Where the camera was before the last step
+    bool replayFinished() const;
+
     // Multi-threading Terrain Generation
     void expand(glm::vec3 prevPos, glm::vec3 currPos);
     QMutex blockMutex;
-    // Chunks that need VBO data
+    // Chunks the BlockWorkers have filled and lit on their own, waiting for
+    // their light to be joined up with the neighbors' and to be meshed
     std::unordered_set<Chunk*> vboData;
     QMutex vboMutex;
     // Chunks that need VBO data binded to the GPU
     std::vector<Chunk*> needBinding;
 
+    // Re-sorts the transparent faces of the Chunks around the player
+    void sortTransparency(glm::vec3 viewPos);
+    QMutex sortMutex;
+    // Sorted index buffers waiting to be uploaded
+    std::vector<SortedFaces> sortedFaces;
+
     // Texturing and Animation
-    Texture m_texture;
-    int animateTime;
+    TextureArray m_texture;
+    int animateTime; // Sixtieths of a second of simulated time
 
     // Day and Night Cycle
     Quad quad;
     ShaderProgram m_progSky;
+    SkyLUT m_skyLUT;
+    ShaderProgram m_progSkyLUT; // Bakes m_skyLUT
+
+    // Noise baked into textures for the sky LUT and fluid shaders
+    NoiseTextures m_noise;
+    // Whether the shaders sample m_noise or work the noise out themselves. F8 toggles it.
+    bool m_bakedNoise;
+    // Uploads the noise once it is baked and tells the shaders which noise to use
+    void updateNoise();
 
     ShaderProgram m_progFluid; //A shader program for post process
 
-    FrameBuffer postProcessFrameBuffer;
+    // When the player is in a fluid or the resolution is scaled down, the 3D
+    // scene is drawn into a target from the pool and renderPostProcess applies
+    // the effects and upscales it to the screen in one pass. Otherwise the
+    // scene is drawn straight to the screen.
+    RenderTargetPool m_targetPool;
+    bool needsPostProcess();
+    // The default frame buffer, or mp_headlessTarget in headless mode
+    void bindScreen();
+    DynamicResolution m_dynamicResolution; // F9 toggles it
 
-    void render3dScene();
+    // The passes of the frame, declared by buildRenderGraph and run by paintGL
+    RenderGraph m_renderGraph;
+    void buildRenderGraph();
+    // The meshed chunks around the player, nearest first, gathered by buildRenderGraph
+    std::vector<Chunk*> m_drawnChunks;
 
-    void renderPostProcess();
+    // Mobs and falling blocks, stepped with the player and drawn as instanced boxes
+    EntitySystem m_entities;
+    Cube m_entityCubes;
+    // Drops count entities within radius of center, walkers and falling blocks mixed. F10 drops 1000.
+    void spawnEntities(int count, glm::vec2 center, float radius, unsigned int seed);
+
+    // The entities and the foliage of the nearby Chunks, one draw call per model
+    InstanceRenderer m_instances;
+    CrossQuad m_foliageQuads;
+    int m_entityType, m_foliageType; // Types of m_instances
+    // Hands m_instances this frame's entities and the foliage of the full detail
+    // Chunks among m_drawnChunks, only rebuilding a Chunk's after it was remeshed
+    void updateInstances();
+    void renderInstances();
+
+    // Sun shadows
+    ShadowMap m_shadowMap;
+    ShaderProgram m_progShadow; // Depth only, draws the Chunks into the shadow map
+    // Brings the shadow map up to date and hands it to the lambert shader
+    void renderShadows();
+
+    // The terrain passes, drawing m_drawnChunks
+    void renderDepthPrepass();
+    void renderOpaque();
+    void renderTransparent();
+
+    void renderPostProcess(FrameBuffer *scene);
 
 public:
     explicit MyGL(QWidget *parent = nullptr);
@@ -82,11 +221,13 @@ public:
     // In the base code, update() is called from tick().
     void paintGL() override;
 
-    // Called from paintGL().
-    // Calls Terrain::draw().
-    void renderTerrain();
     void addChunkToVBO(Chunk* c);
 
+    // Drives initializeGL, resizeGL and paintGL by hand with whichever
+    // context is current, rendering into an offscreen frame buffer.
+    // See runHeadless.
+    void renderHeadless(const HeadlessOptions &options, HeadlessResult &result);
+
 protected:
     // Automatically invoked when the user
     // presses a key on the keyboard
@@ -100,7 +241,7 @@ protected:
     void mousePressEvent(QMouseEvent *e) override;
 
 private slots:
-    void tick(); // Slot that gets called ~60 times per second by m_timer firing.
+    void tick(); // Slot that gets called once per frame, after every buffer swap.
 
 signals:
     void sig_sendPlayerPos(QString) const;
@@ -109,6 +250,10 @@ signals:
     void sig_sendPlayerLook(QString) const;
     void sig_sendPlayerChunk(QString) const;
     void sig_sendPlayerTerrainZone(QString) const;
+    void sig_sendFrameStats(QString);
+    void sig_sendSlowestRegions(QString);
+    void sig_sendGpuTimes(QString);
+    void sig_sendFrameTimes(QVector<float>);
 };
 
 
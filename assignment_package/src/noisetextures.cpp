@@ -0,0 +1,188 @@
+#include "noisetextures.h"
+#include "noiseworker.h"
+#include "noise.h"
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    unsigned char toByte(float v) {
+        return static_cast<unsigned char>(std::clamp(v, 0.f, 1.f) * 255.f + 0.5f);
+    }
+
+    // Cell coordinates wrapped into [0, cells)
+    int wrap(int i, int cells) {
+        return ((i % cells) + cells) % cells;
+    }
+
+    // Distance from p to the nearest Worley point of a grid that repeats every
+    // cells cells, the same as WorleyNoise3D. points holds the point of each
+    // cell, relative to the cell's corner.
+    float tileableWorley3D(glm::vec3 p, int cells, const std::vector<glm::vec3> &points) {
+        glm::ivec3 cell = glm::ivec3(glm::floor(p));
+        float minDist = 1.f;
+        for (int z = -1; z <= 1; ++z) {
+            for (int y = -1; y <= 1; ++y) {
+                for (int x = -1; x <= 1; ++x) {
+                    glm::ivec3 neighbor = cell + glm::ivec3(x, y, z);
+                    int i = wrap(neighbor.x, cells) + cells * (wrap(neighbor.y, cells) + cells * wrap(neighbor.z, cells));
+                    minDist = std::min(minDist, glm::length(glm::vec3(neighbor) + points[i] - p));
+                }
+            }
+        }
+        return minDist;
+    }
+
+    float tileableWorley2D(glm::vec2 p, int cells, const std::vector<glm::vec2> &points) {
+        glm::ivec2 cell = glm::ivec2(glm::floor(p));
+        float minDist = 1.f;
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                glm::ivec2 neighbor = cell + glm::ivec2(x, y);
+                int i = wrap(neighbor.x, cells) + cells * wrap(neighbor.y, cells);
+                minDist = std::min(minDist, glm::length(glm::vec2(neighbor) + points[i] - p));
+            }
+        }
+        return minDist;
+    }
+
+    // Bilinear value noise on a lattice that repeats every cells cells
+    float tileableValueNoise(glm::vec2 p, int cells, float seed) {
+        glm::ivec2 i = glm::ivec2(glm::floor(p));
+        glm::vec2 f = p - glm::floor(p);
+        auto value = [&](int x, int y) {
+            return random1D(glm::vec2(wrap(x, cells), wrap(y, cells) + seed));
+        };
+        float bottom = glm::mix(value(i.x, i.y), value(i.x + 1, i.y), f.x);
+        float top = glm::mix(value(i.x, i.y + 1), value(i.x + 1, i.y + 1), f.x);
+        return glm::mix(bottom, top, f.y);
+    }
+
+    // The fbm of fluid.frag.glsl, octaves from 2 to 32 cells across [0, 1]
+    float tileableFbm(glm::vec2 uv) {
+        float total = 0.f;
+        float amp = 0.5f;
+        int freq = 2;
+        for (int octave = 0; octave < 5; ++octave) {
+            total += tileableValueNoise(uv * float(freq), freq, 97.f * octave) * amp;
+            freq *= 2;
+            amp *= 0.5f;
+        }
+        return total;
+    }
+}
+
+NoiseTextures::NoiseTextures(OpenGLContext *context)
+    : mp_context(context), m_worleyTexture(-1), m_noiseTexture(-1), m_created(false), m_ready(false),
+      m_bakeMutex(), mp_baked(nullptr), m_baking(false), m_bakeDone()
+{}
+
+void NoiseTextures::bake(NoiseVolumes &volumes) {
+    // One random point per Worley cell
+    std::vector<glm::vec3> points3D(WORLEY_CELLS * WORLEY_CELLS * WORLEY_CELLS);
+    for (int z = 0; z < WORLEY_CELLS; ++z) {
+        for (int y = 0; y < WORLEY_CELLS; ++y) {
+            for (int x = 0; x < WORLEY_CELLS; ++x) {
+                points3D[x + WORLEY_CELLS * (y + WORLEY_CELLS * z)] = random3D(glm::vec3(x, y, z));
+            }
+        }
+    }
+    std::vector<glm::vec2> points2D(NOISE_CELLS * NOISE_CELLS);
+    for (int y = 0; y < NOISE_CELLS; ++y) {
+        for (int x = 0; x < NOISE_CELLS; ++x) {
+            points2D[x + NOISE_CELLS * y] = random2D(glm::vec2(x, y));
+        }
+    }
+
+    const float worleyScale = float(WORLEY_CELLS) / WORLEY_SIZE;
+    volumes.worley3D.resize(WORLEY_SIZE * WORLEY_SIZE * WORLEY_SIZE);
+    for (int z = 0; z < WORLEY_SIZE; ++z) {
+        for (int y = 0; y < WORLEY_SIZE; ++y) {
+            for (int x = 0; x < WORLEY_SIZE; ++x) {
+                glm::vec3 p = (glm::vec3(x, y, z) + 0.5f) * worleyScale;
+                volumes.worley3D[x + WORLEY_SIZE * (y + WORLEY_SIZE * z)] = toByte(tileableWorley3D(p, WORLEY_CELLS, points3D));
+            }
+        }
+    }
+
+    volumes.noise2D.resize(2 * NOISE_SIZE * NOISE_SIZE);
+    for (int y = 0; y < NOISE_SIZE; ++y) {
+        for (int x = 0; x < NOISE_SIZE; ++x) {
+            glm::vec2 uv = (glm::vec2(x, y) + 0.5f) / float(NOISE_SIZE);
+            int i = 2 * (x + NOISE_SIZE * y);
+            volumes.noise2D[i] = toByte(tileableFbm(uv));
+            volumes.noise2D[i + 1] = toByte(tileableWorley2D(uv * float(NOISE_CELLS), NOISE_CELLS, points2D));
+        }
+    }
+}
+
+void NoiseTextures::create() {
+    mp_context->glGenTextures(1, &m_worleyTexture);
+    mp_context->glGenTextures(1, &m_noiseTexture);
+    m_created = true;
+    m_ready = false;
+    m_baking = true;
+    QThreadPool::globalInstance()->start(new NoiseWorker(&m_bakeMutex, &mp_baked, &m_bakeDone));
+}
+
+void NoiseTextures::destroy() {
+    if (m_baking) {
+        m_bakeDone.acquire();
+        m_baking = false;
+        mp_baked = nullptr;
+    }
+    if (m_created) {
+        m_created = false;
+        m_ready = false;
+        mp_context->glDeleteTextures(1, &m_worleyTexture);
+        mp_context->glDeleteTextures(1, &m_noiseTexture);
+    }
+}
+
+bool NoiseTextures::update() {
+    if (!m_created || m_ready) {
+        return false;
+    }
+    uPtr<NoiseVolumes> volumes;
+    m_bakeMutex.lock();
+    volumes = std::move(mp_baked);
+    m_bakeMutex.unlock();
+    if (!volumes) {
+        return false;
+    }
+
+    mp_context->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    mp_context->glBindTexture(GL_TEXTURE_3D, m_worleyTexture);
+    mp_context->glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, WORLEY_SIZE, WORLEY_SIZE, WORLEY_SIZE,
+                             0, GL_RED, GL_UNSIGNED_BYTE, volumes->worley3D.data());
+    mp_context->glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    mp_context->glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    mp_context->glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    mp_context->glGenerateMipmap(GL_TEXTURE_3D);
+
+    mp_context->glBindTexture(GL_TEXTURE_2D, m_noiseTexture);
+    mp_context->glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, NOISE_SIZE, NOISE_SIZE,
+                             0, GL_RG, GL_UNSIGNED_BYTE, volumes->noise2D.data());
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    mp_context->glGenerateMipmap(GL_TEXTURE_2D);
+    mp_context->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    m_ready = true;
+    return true;
+}
+
+bool NoiseTextures::isReady() const {
+    return m_ready;
+}
+
+void NoiseTextures::bindToTextureSlots(unsigned int worleySlot, unsigned int noiseSlot) {
+    mp_context->glActiveTexture(GL_TEXTURE0 + worleySlot);
+    mp_context->glBindTexture(GL_TEXTURE_3D, m_worleyTexture);
+    mp_context->glActiveTexture(GL_TEXTURE0 + noiseSlot);
+    mp_context->glBindTexture(GL_TEXTURE_2D, m_noiseTexture);
+}
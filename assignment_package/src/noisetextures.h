@@ -0,0 +1,57 @@
+#pragma once
+#include "openglcontext.h"
+#include "smartpointerhelp.h"
+#include <QMutex>
+#include <QSemaphore>
+#include <vector>
+
+// The CPU side of the baked noise, filled in by a NoiseWorker
+struct NoiseVolumes {
+    std::vector<unsigned char> worley3D; // WORLEY_SIZE^3 distances to the nearest Worley point
+    std::vector<unsigned char> noise2D;  // NOISE_SIZE^2 pairs of fbm and 2D Worley distance
+};
+
+// Noise the sky and fluid shaders used to evaluate analytically for every
+// pixel, baked into tileable textures on a worker thread at startup. The
+// shaders sample them with animated offsets instead:
+//  - a 3D Worley volume for the clouds of skylut.frag.glsl, WORLEY_CELLS
+//    cells across that wrap around
+//  - a 2D texture for fluid.frag.glsl holding 5 octaves of value noise fbm
+//    that tiles over [0, 1] in red, and 2D Worley distance with NOISE_CELLS
+//    cells across in green
+// Until the worker is done the shaders keep to the analytic noise.
+class NoiseTextures {
+public:
+    const static int WORLEY_SIZE = 64;
+    const static int WORLEY_CELLS = 8;
+    const static int NOISE_SIZE = 256;
+    const static int NOISE_CELLS = 8;
+
+private:
+    OpenGLContext *mp_context;
+    GLuint m_worleyTexture;
+    GLuint m_noiseTexture;
+    bool m_created;
+    bool m_ready;
+    QMutex m_bakeMutex;
+    uPtr<NoiseVolumes> mp_baked; // Handed over by the worker under m_bakeMutex
+    // Whether a worker was started that destroy hasn't waited for yet. It
+    // writes to m_bakeMutex and mp_baked, so they must outlive it.
+    bool m_baking;
+    QSemaphore m_bakeDone;
+
+public:
+    NoiseTextures(OpenGLContext *context);
+
+    // Fills in both volumes, slow enough to belong on a worker thread
+    static void bake(NoiseVolumes &volumes);
+
+    // Creates the textures and starts baking them in the background
+    void create();
+    // Deletes the textures, first waiting for the worker if it is still baking
+    void destroy();
+    // Uploads the volumes once they are baked. Returns true on the call that does.
+    bool update();
+    bool isReady() const;
+    void bindToTextureSlots(unsigned int worleySlot, unsigned int noiseSlot);
+};
@@ -0,0 +1,16 @@
+#include "noiseworker.h"
+#include "profiler.h"
+
+NoiseWorker::NoiseWorker(QMutex *mutex, uPtr<NoiseVolumes> *baked, QSemaphore *done)
+    : bakeMutex(mutex), baked(baked), done(done)
+{}
+
+void NoiseWorker::run() {
+    PROFILE_SCOPE("bake noise");
+    uPtr<NoiseVolumes> volumes = mkU<NoiseVolumes>();
+    NoiseTextures::bake(*volumes);
+    bakeMutex->lock();
+    *baked = std::move(volumes);
+    bakeMutex->unlock();
+    done->release();
+}
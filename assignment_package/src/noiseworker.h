@@ -0,0 +1,15 @@
+#pragma once
+#include "noisetextures.h"
+#include <QRunnable>
+#include <QMutex>
+#include <QSemaphore>
+
+class NoiseWorker : public QRunnable {
+private:
+    QMutex *bakeMutex;
+    uPtr<NoiseVolumes> *baked;
+    QSemaphore *done; // Released once the volumes are handed over
+public:
+    NoiseWorker(QMutex *mutex, uPtr<NoiseVolumes> *baked, QSemaphore *done);
+    void run() override;
+};
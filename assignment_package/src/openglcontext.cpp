@@ -19,9 +19,10 @@ inline const char *glGS(GLenum e)
     return reinterpret_cast<const char *>(glGetString(e));
 }
 
-void OpenGLContext::debugContextVersion()
+void OpenGLContext::debugContextVersion(FILE *out)
 {
-    QOpenGLContext *ctx = context();
+    // The widget's own context, or the offscreen one in headless mode
+    QOpenGLContext *ctx = QOpenGLContext::currentContext();
     QSurfaceFormat form = format();
     QSurfaceFormat ctxform = ctx->format();
     QSurfaceFormat::OpenGLContextProfile prof = ctxform.profile();
@@ -40,28 +41,28 @@ void OpenGLContext::debugContextVersion()
     const char *version = glGS(GL_VERSION);
     const char* s_glsl = glGS(GL_SHADING_LANGUAGE_VERSION);
 
-    printf("Widget version: %d.%d\n", ctxmajor, ctxminor);
-    printf("Context valid: %s\n", valid ? "yes" : "NO");
-    printf("Format version: %d.%d\n", formmajor, formminor);
-    printf("Profile: %s\n", profile);
-    printf("  Vendor:   %s\n", vendor);
-    printf("  Renderer: %s\n", renderer);
-    printf("  Version:  %s\n", version);
-    printf("  GLSL:     %s\n", s_glsl);
+    fprintf(out, "Widget version: %d.%d\n", ctxmajor, ctxminor);
+    fprintf(out, "Context valid: %s\n", valid ? "yes" : "NO");
+    fprintf(out, "Format version: %d.%d\n", formmajor, formminor);
+    fprintf(out, "Profile: %s\n", profile);
+    fprintf(out, "  Vendor:   %s\n", vendor);
+    fprintf(out, "  Renderer: %s\n", renderer);
+    fprintf(out, "  Version:  %s\n", version);
+    fprintf(out, "  GLSL:     %s\n", s_glsl);
 
     QString glsl = s_glsl;
     if (ctxmajor < 3 || glsl.startsWith("1.10") || glsl.startsWith("1.20")) {
-        printf("ERROR: "
-               "Unable to get an OpenGL 3.x context with GLSL 1.30 or newer. "
-               "If your hardware should support it, update your drivers. "
-               "If you have switchable graphics, make sure that you are using the discrete GPU.\n");
+        fprintf(out, "ERROR: "
+                     "Unable to get an OpenGL 3.x context with GLSL 1.30 or newer. "
+                     "If your hardware should support it, update your drivers. "
+                     "If you have switchable graphics, make sure that you are using the discrete GPU.\n");
         QApplication::exit();
     } else if ((ctxmajor == 3 && ctxminor < 2) || glsl.startsWith("1.30") || glsl.startsWith("1.40")) {
-        printf("WARNING: "
-               "Enable to get an OpenGL 3.2 context with GLSL 1.50. "
-               "If your hardware should support it, update your drivers. "
-               "If you have switchable graphics, make sure that you are using the discrete GPU. "
-               "If you cannot get 3.2 support, it is possible to port this project....");
+        fprintf(out, "WARNING: "
+                     "Enable to get an OpenGL 3.2 context with GLSL 1.50. "
+                     "If your hardware should support it, update your drivers. "
+                     "If you have switchable graphics, make sure that you are using the discrete GPU. "
+                     "If you cannot get 3.2 support, it is possible to port this project....");
 
         // Note: doing this requires at least the following actions:
         // * Change the header and base class in glwidget277.h to 3.0/3.1 instead of 3.2 Core.
@@ -3,6 +3,7 @@
 #include <QOpenGLWidget>
 #include <QTimer>
 #include <QOpenGLExtraFunctions>
+#include <cstdio>
 
 
 class OpenGLContext
@@ -14,7 +15,8 @@ public:
     OpenGLContext(QWidget *parent);
     ~OpenGLContext();
 
-    void debugContextVersion();
+    // Prints the context's version and driver to out
+    void debugContextVersion(FILE *out);
     void printGLErrorLog();
     void printLinkInfoLog(int prog);
     void printShaderInfoLog(int shader);
@@ -36,3 +36,18 @@ void PlayerInfo::slot_setZoneText(QString s) {
     ui->zoneLabel->setText(s);
 }
 
+void PlayerInfo::slot_setFrameText(QString s) {
+    ui->frameLabel->setText(s);
+}
+
+void PlayerInfo::slot_setSlowestText(QString s) {
+    ui->slowestLabel->setText(s);
+}
+
+void PlayerInfo::slot_setGpuText(QString s) {
+    ui->gpuLabel->setText(s);
+}
+
+void PlayerInfo::slot_setFrameTimes(QVector<float> times) {
+    ui->frameGraph->setFrameTimes(times);
+}
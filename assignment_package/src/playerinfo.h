@@ -2,6 +2,7 @@
 #define PLAYERINFO_H
 
 #include <QWidget>
+#include <QVector>
 
 namespace Ui {
 class PlayerInfo;
@@ -20,6 +21,10 @@ public slots:
     void slot_setLookText(QString);
     void slot_setChunkText(QString);
     void slot_setZoneText(QString);
+    void slot_setFrameText(QString);
+    void slot_setSlowestText(QString);
+    void slot_setGpuText(QString);
+    void slot_setFrameTimes(QVector<float>);
 
 private:
     Ui::PlayerInfo *ui;
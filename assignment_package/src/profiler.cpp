@@ -0,0 +1,223 @@
+#include "profiler.h"
+#include "smartpointerhelp.h"
+#include <QMutex>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+ProfileRing::ProfileRing(int threadId)
+    : m_slots(), m_head(0), m_threadId(threadId)
+{}
+
+void ProfileRing::push(const char *name, int64_t start, int64_t duration) {
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[head % CAPACITY];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    // Publishes the slot to readers
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void ProfileRing::snapshot(std::vector<ProfileSample> &out) const {
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+    std::vector<ProfileSample> copied;
+    copied.reserve(head - first);
+    for (uint64_t i = first; i < head; ++i) {
+        const Slot &slot = m_slots[i % CAPACITY];
+        copied.push_back(ProfileSample{slot.name.load(std::memory_order_relaxed),
+                                       slot.start.load(std::memory_order_relaxed),
+                                       slot.duration.load(std::memory_order_relaxed)});
+    }
+    // Anything the writer got to after we read head may have been overwritten
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t newHead = m_head.load(std::memory_order_relaxed);
+    uint64_t valid = newHead > CAPACITY ? newHead - CAPACITY : 0;
+    for (uint64_t i = std::max(first, valid); i < head; ++i) {
+        out.push_back(copied[i - first]);
+    }
+}
+
+int ProfileRing::getThreadId() const {
+    return m_threadId;
+}
+
+// Nearest-rank percentile of already sorted values
+static float percentile(const std::vector<float> &sorted, float p) {
+    if (sorted.empty()) {
+        return 0.f;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+FrameHistory::FrameHistory()
+    : m_times(), m_next(0)
+{}
+
+void FrameHistory::push(float ms) {
+    if (m_times.size() < SIZE) {
+        m_times.push_back(ms);
+    } else {
+        m_times[m_next] = ms;
+    }
+    m_next = (m_next + 1) % SIZE;
+}
+
+std::vector<float> FrameHistory::getTimes() const {
+    if (m_times.size() < SIZE) {
+        return m_times;
+    }
+    std::vector<float> times(m_times.begin() + m_next, m_times.end());
+    times.insert(times.end(), m_times.begin(), m_times.begin() + m_next);
+    return times;
+}
+
+FrameStats summarize(std::vector<float> values) {
+    std::sort(values.begin(), values.end());
+    return FrameStats{percentile(values, 0.5f), percentile(values, 0.99f),
+                      values.empty() ? 0.f : values.back()};
+}
+
+FrameStats FrameHistory::getStats() const {
+    return summarize(m_times);
+}
+
+namespace {
+    // Rings are never freed, so samples survive their thread exiting
+    QMutex ringMutex;
+    std::vector<uPtr<ProfileRing>> rings;
+    int nextThreadId = 1;
+    thread_local ProfileRing *threadRing = nullptr;
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    ProfileRing *addRing(int threadId) {
+        ringMutex.lock();
+        rings.push_back(mkU<ProfileRing>(threadId));
+        ProfileRing *ring = rings.back().get();
+        ringMutex.unlock();
+        return ring;
+    }
+}
+
+int64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Profiler::registerMainThread() {
+    if (!threadRing) {
+        threadRing = addRing(0);
+    }
+}
+
+void Profiler::record(const char *name, int64_t start, int64_t end) {
+    if (!threadRing) {
+        ringMutex.lock();
+        int id = nextThreadId++;
+        ringMutex.unlock();
+        threadRing = addRing(id);
+    }
+    threadRing->push(name, start, end - start);
+}
+
+void Profiler::recordGpu(const char *name, int64_t start, int64_t duration) {
+    static ProfileRing *gpuRing = addRing(-1);
+    gpuRing->push(name, start, duration);
+}
+
+std::vector<std::pair<int, ProfileSample>> Profiler::collect() {
+    std::vector<std::pair<int, ProfileSample>> all;
+    std::vector<ProfileSample> samples;
+    ringMutex.lock();
+    for (const uPtr<ProfileRing> &ring : rings) {
+        samples.clear();
+        ring->snapshot(samples);
+        for (const ProfileSample &s : samples) {
+            all.push_back(std::make_pair(ring->getThreadId(), s));
+        }
+    }
+    ringMutex.unlock();
+    return all;
+}
+
+std::vector<std::pair<std::string, float>> Profiler::slowestRegions(int64_t window, size_t count) {
+    ProfileRing *mainRing = nullptr;
+    ringMutex.lock();
+    for (const uPtr<ProfileRing> &ring : rings) {
+        if (ring->getThreadId() == 0) {
+            mainRing = ring.get();
+        }
+    }
+    ringMutex.unlock();
+    if (!mainRing) {
+        return {};
+    }
+
+    std::vector<ProfileSample> samples;
+    mainRing->snapshot(samples);
+    int64_t since = now() - window;
+    std::map<std::string, std::vector<float>> durations;
+    for (const ProfileSample &s : samples) {
+        if (s.start >= since) {
+            durations[s.name].push_back(s.duration / 1e6f);
+        }
+    }
+
+    std::vector<std::pair<std::string, float>> regions;
+    for (auto &d : durations) {
+        std::sort(d.second.begin(), d.second.end());
+        regions.push_back(std::make_pair(d.first, percentile(d.second, 0.99f)));
+    }
+    std::sort(regions.begin(), regions.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    if (regions.size() > count) {
+        regions.resize(count);
+    }
+    return regions;
+}
+
+bool Profiler::exportChromeTrace(const std::string &path) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::vector<std::pair<int, ProfileSample>> samples = collect();
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    // Name the threads so the viewer can label the rows
+    std::vector<int> threads;
+    for (auto &s : samples) {
+        if (std::find(threads.begin(), threads.end(), s.first) == threads.end()) {
+            threads.push_back(s.first);
+        }
+    }
+    bool first = true;
+    for (int t : threads) {
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+             << ",\"args\":{\"name\":\"" << (t == 0 ? std::string("main") : t < 0 ? std::string("gpu") : "worker " + std::to_string(t)) << "\"}}";
+        first = false;
+    }
+    // Complete events, with times in microseconds
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    for (auto &s : samples) {
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"" << s.second.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << s.first
+             << ",\"ts\":" << s.second.start / 1e3 << ",\"dur\":" << s.second.duration / 1e3 << "}";
+        first = false;
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+ProfileScope::ProfileScope(const char *name)
+    : m_name(name), m_start(Profiler::now())
+{}
+
+ProfileScope::~ProfileScope() {
+    Profiler::record(m_name, m_start, Profiler::now());
+}
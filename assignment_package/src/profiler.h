@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One timed region of code. Names must be string literals since only the
+// pointer is stored.
+struct ProfileSample {
+    const char *name;
+    int64_t start;    // Nanoseconds since the profiler started
+    int64_t duration; // Nanoseconds
+};
+
+// A fixed-size ring of samples written by exactly one thread and read by
+// any other. Writing never locks or allocates; once full the oldest samples
+// are overwritten.
+class ProfileRing {
+public:
+    static const int CAPACITY = 4096;
+
+    explicit ProfileRing(int threadId);
+
+    void push(const char *name, int64_t start, int64_t duration);
+    // Appends the samples currently held to out, oldest first. Samples the
+    // writer overwrote while we were copying are dropped.
+    void snapshot(std::vector<ProfileSample> &out) const;
+    int getThreadId() const;
+
+private:
+    struct Slot {
+        std::atomic<const char*> name;
+        std::atomic<int64_t> start;
+        std::atomic<int64_t> duration;
+    };
+    std::array<Slot, CAPACITY> m_slots;
+    // Total number of samples ever pushed
+    std::atomic<uint64_t> m_head;
+    int m_threadId;
+};
+
+struct FrameStats {
+    float p50, p99, max;
+};
+
+// Nearest-rank percentiles of the given values
+FrameStats summarize(std::vector<float> values);
+
+// The durations of the most recent frames, in milliseconds
+class FrameHistory {
+private:
+    std::vector<float> m_times;
+    size_t m_next;
+public:
+    static const int SIZE = 240;
+
+    FrameHistory();
+    void push(float ms);
+    // Oldest first
+    std::vector<float> getTimes() const;
+    FrameStats getStats() const;
+};
+
+namespace Profiler {
+    // Nanoseconds since the profiler started, on a monotonic clock
+    int64_t now();
+    // Call once from the GUI thread before anything is recorded so that
+    // it gets thread id 0, which slowestRegions reports on
+    void registerMainThread();
+    // Adds a sample to the calling thread's ring, creating the ring on first use
+    void record(const char *name, int64_t start, int64_t end);
+    // Adds a GPU pass to its own track, which is thread id -1 in collect.
+    // Only call from the thread that owns the GL context.
+    void recordGpu(const char *name, int64_t start, int64_t duration);
+    // Every sample still held by every thread's ring, with its thread id
+    std::vector<std::pair<int, ProfileSample>> collect();
+    // The p99 duration in milliseconds of each region the main thread ran in
+    // the last window nanoseconds, slowest first
+    std::vector<std::pair<std::string, float>> slowestRegions(int64_t window, size_t count);
+    // Writes every held sample as a Chrome trace-event JSON file that can be
+    // opened in chrome://tracing or Perfetto. Returns false if the file
+    // could not be written.
+    bool exportChromeTrace(const std::string &path);
+}
+
+// Records the time between its construction and destruction
+class ProfileScope {
+private:
+    const char *m_name;
+    int64_t m_start;
+public:
+    explicit ProfileScope(const char *name);
+    ~ProfileScope();
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing block under the given name
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
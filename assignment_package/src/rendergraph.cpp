@@ -0,0 +1,121 @@
+#include "rendergraph.h"
+#include "profiler.h"
+
+RenderGraph::RenderGraph(OpenGLContext *context, RenderTargetPool *pool, GpuProfiler *profiler)
+    : mp_context(context), mp_pool(pool), mp_profiler(profiler), m_resources(), m_passes(), m_culled()
+{}
+
+RenderGraph::Resource RenderGraph::createTarget(const char *name, int width, int height, GLenum format) {
+    m_resources.push_back(ResourceInfo{name, true, width, height, format, nullptr, false, false, glm::vec4(), nullptr});
+    return m_resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::import(const char *name, std::function<void()> bind) {
+    m_resources.push_back(ResourceInfo{name, false, 0, 0, GL_NONE, bind, false, false, glm::vec4(), nullptr});
+    return m_resources.size() - 1;
+}
+
+void RenderGraph::markOutput(Resource r) {
+    m_resources[r].output = true;
+}
+
+void RenderGraph::setClear(Resource r, glm::vec4 color) {
+    m_resources[r].clear = true;
+    m_resources[r].clearColor = color;
+}
+
+void RenderGraph::addPass(const char *name, std::vector<Resource> reads, std::vector<Resource> writes,
+                          std::function<void()> execute) {
+    m_passes.push_back(Pass{name, reads, writes, execute});
+}
+
+FrameBuffer* RenderGraph::getTarget(Resource r) const {
+    return m_resources[r].buffer;
+}
+
+void RenderGraph::bindTarget(ResourceInfo &target) {
+    if (target.transient) {
+        target.buffer->bindFrameBuffer();
+        mp_context->glViewport(0, 0, target.width, target.height);
+    } else if (target.bind) {
+        target.bind();
+    } else {
+        return;
+    }
+    if (target.clear) {
+        target.clear = false;
+        mp_context->glClearColor(target.clearColor.x, target.clearColor.y, target.clearColor.z, target.clearColor.w);
+        mp_context->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+}
+
+void RenderGraph::execute() {
+    // Walk back from the outputs: a pass lives if something still needs what it writes
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t r = 0; r < m_resources.size(); ++r) {
+        needed[r] = m_resources[r].output;
+    }
+    std::vector<bool> live(m_passes.size(), false);
+    for (int i = m_passes.size() - 1; i >= 0; --i) {
+        for (Resource w : m_passes[i].writes) {
+            live[i] = live[i] || needed[w];
+        }
+        if (live[i]) {
+            for (Resource r : m_passes[i].reads) {
+                needed[r] = true;
+            }
+        }
+    }
+
+    // The last live pass that uses each transient target
+    std::vector<int> lastUse(m_resources.size(), -1);
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        if (!live[i]) {
+            continue;
+        }
+        for (Resource r : m_passes[i].reads) {
+            lastUse[r] = i;
+        }
+        for (Resource w : m_passes[i].writes) {
+            lastUse[w] = i;
+        }
+    }
+
+    m_culled.clear();
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        Pass &pass = m_passes[i];
+        if (!live[i]) {
+            m_culled.push_back(pass.name);
+            continue;
+        }
+        for (Resource w : pass.writes) {
+            ResourceInfo &target = m_resources[w];
+            if (target.transient && !target.buffer) {
+                target.buffer = mp_pool->acquire(target.width, target.height, target.format);
+            }
+        }
+        {
+            PROFILE_SCOPE(pass.name);
+            mp_profiler->beginPass(pass.name);
+            if (!pass.writes.empty()) {
+                bindTarget(m_resources[pass.writes[0]]);
+            }
+            pass.execute();
+            mp_profiler->endPass();
+        }
+        // Hand back the targets nothing later reads, for the next ones to reuse
+        for (size_t r = 0; r < m_resources.size(); ++r) {
+            if (lastUse[r] == static_cast<int>(i) && m_resources[r].buffer) {
+                mp_pool->release(m_resources[r].buffer);
+                m_resources[r].buffer = nullptr;
+            }
+        }
+    }
+
+    m_passes.clear();
+    m_resources.clear();
+}
+
+const std::vector<const char*>& RenderGraph::getCulledPasses() const {
+    return m_culled;
+}
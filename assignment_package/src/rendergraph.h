@@ -0,0 +1,68 @@
+#pragma once
+#include "rendertargetpool.h"
+#include "gpuprofiler.h"
+#include <glm_includes.h>
+#include <functional>
+#include <vector>
+
+// A frame's render passes, declared up front along with the resources each
+// one reads and writes, then run in order by execute. Passes that write
+// nothing a later live pass or an output needs are culled. Transient
+// targets are acquired from the pool just before their first live use and
+// released just after their last, so targets whose lifetimes don't overlap
+// share a FrameBuffer. Every pass is timed on the CPU and the GPU under its name.
+class RenderGraph {
+public:
+    typedef int Resource;
+
+private:
+    struct ResourceInfo {
+        const char *name;
+        bool transient;
+        int width, height; // Transient targets only, in pixels
+        GLenum format;
+        // Makes an imported resource the render target, empty if its passes bind it themselves
+        std::function<void()> bind;
+        bool output;
+        bool clear;
+        glm::vec4 clearColor;
+        FrameBuffer *buffer; // Transient targets only, while acquired
+    };
+
+    struct Pass {
+        const char *name;
+        std::vector<Resource> reads;
+        std::vector<Resource> writes; // The first is bound as the render target
+        std::function<void()> execute;
+    };
+
+    OpenGLContext *mp_context;
+    RenderTargetPool *mp_pool;
+    GpuProfiler *mp_profiler;
+    std::vector<ResourceInfo> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<const char*> m_culled; // By the last execute
+
+    void bindTarget(ResourceInfo &target);
+
+public:
+    RenderGraph(OpenGLContext *context, RenderTargetPool *pool, GpuProfiler *profiler);
+
+    // A target the graph owns for the frame, acquired from the pool
+    Resource createTarget(const char *name, int width, int height, GLenum format = GL_RGB8);
+    // Something that outlives the frame, like the screen or the shadow map
+    Resource import(const char *name, std::function<void()> bind = nullptr);
+    // Keeps the passes that write r, and the passes they read from, alive
+    void markOutput(Resource r);
+    // Clears the color and depth of r before the first pass that writes it
+    void setClear(Resource r, glm::vec4 color);
+    void addPass(const char *name, std::vector<Resource> reads, std::vector<Resource> writes,
+                 std::function<void()> execute);
+
+    // The FrameBuffer behind a transient target, valid while the passes that use it run
+    FrameBuffer* getTarget(Resource r) const;
+
+    // Culls and runs the passes, then forgets them and their resources
+    void execute();
+    const std::vector<const char*>& getCulledPasses() const;
+};
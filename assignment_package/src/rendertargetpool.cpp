@@ -0,0 +1,51 @@
+#include "rendertargetpool.h"
+
+RenderTargetPool::RenderTargetPool(OpenGLContext *context)
+    : mp_context(context), m_targets()
+{}
+
+FrameBuffer* RenderTargetPool::acquire(unsigned int width, unsigned int height, GLenum internalFormat) {
+    for (Target &t : m_targets) {
+        if (!t.inUse && t.buffer->getPixelWidth() == width && t.buffer->getPixelHeight() == height &&
+            t.buffer->getInternalFormat() == internalFormat) {
+            t.inUse = true;
+            t.idleFrames = 0;
+            return t.buffer.get();
+        }
+    }
+    Target t{mkU<FrameBuffer>(mp_context, width, height, 1, internalFormat), true, 0};
+    t.buffer->create();
+    m_targets.push_back(std::move(t));
+    return m_targets.back().buffer.get();
+}
+
+void RenderTargetPool::release(FrameBuffer *buffer) {
+    for (Target &t : m_targets) {
+        if (t.buffer.get() == buffer) {
+            t.inUse = false;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::endFrame() {
+    for (auto it = m_targets.begin(); it != m_targets.end();) {
+        if (!it->inUse && ++it->idleFrames > KEEP_FRAMES) {
+            it->buffer->destroy();
+            it = m_targets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RenderTargetPool::destroy() {
+    for (Target &t : m_targets) {
+        t.buffer->destroy();
+    }
+    m_targets.clear();
+}
+
+size_t RenderTargetPool::size() const {
+    return m_targets.size();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "framebuffer.h"
+#include "smartpointerhelp.h"
+#include <vector>
+
+// Hands out FrameBuffers by size and format and recycles them. A pass
+// acquires a target for the frame and releases it once it has been read.
+// Targets nobody has asked for in a while, such as the ones for an old
+// window size or render scale, are destroyed by endFrame.
+class RenderTargetPool {
+public:
+    // A released target is kept around for this many frames in case it is asked for again
+    const static int KEEP_FRAMES = 8;
+
+private:
+    struct Target {
+        uPtr<FrameBuffer> buffer;
+        bool inUse;
+        int idleFrames;
+    };
+
+    OpenGLContext *mp_context;
+    std::vector<Target> m_targets;
+
+public:
+    RenderTargetPool(OpenGLContext *context);
+
+    // A free target of the given size in pixels and format, created if there is none
+    FrameBuffer* acquire(unsigned int width, unsigned int height, GLenum internalFormat = GL_RGB8);
+    void release(FrameBuffer *buffer);
+    // Destroys the targets that have sat unused for more than KEEP_FRAMES frames
+    void endFrame();
+    // Destroys every target, in use or not
+    void destroy();
+
+    size_t size() const;
+};
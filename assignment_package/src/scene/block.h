@@ -0,0 +1,164 @@
+#pragma once
+#include <array>
+
+// C++ 11 allows us to define the size of an enum. This lets us use only one byte
+// of memory to store our different block types. By default, the size of a C++ enum
+// is that of an int (so, usually four bytes). This *does* limit us to only 256 different
+// block types, but in the scope of this project we'll never get anywhere near that many.
+enum BlockType : unsigned char
+{
+
+    EMPTY, GRASS, DIRT, STONE, WATER, SNOW, SAND, LAVA, BEDROCK, ICE, SNOW_DIRT, LEAF, WOOD,
+    SNOW_LEAF, SAP, CACTUS, SIDE_WOOD, GRAVEL, SNOW_GRASS_PATCH, DIRT_GRASS_PATCH, COAL, LAPIS,
+    COPPER, GOLD, SAND_CRACK
+
+};
+
+const static int BLOCK_TYPE_COUNT = SAND_CRACK + 1;
+
+// Light levels run from 0 to MAX_LIGHT. Sky light comes down from the open
+// sky, block light spreads out from emitting blocks such as lava.
+const static int MAX_LIGHT = 15;
+
+enum LightChannel : unsigned char
+{
+    SKY_LIGHT, BLOCK_LIGHT
+};
+
+// The six cardinal directions in 3D space
+enum Direction : unsigned char
+{
+    XPOS, XNEG, YPOS, YNEG, ZPOS, ZNEG, DIAG1, DIAG2
+};
+
+// Everything the mesher, physics and generation need to know about a block type.
+// Face arrays are indexed by Direction (XPOS through ZNEG).
+struct BlockInfo {
+    // Texture array layer of each face
+    std::array<unsigned char, 6> tiles = {};
+    // Per-face effect read by the shaders from uv.w: 1 for water waves,
+    // +-2/3/4 for the cactus inset, -7/-8/-9 for the ground patches
+    std::array<signed char, 6> faceEffects = {};
+    // Hides the faces of the blocks next to it
+    bool opaque = true;
+    // Drawn in the blended pass. Two neighboring blocks of the same type hide their shared faces.
+    bool transparent = false;
+    // Meshed into the fluid buffers instead of the solid or transparent ones
+    bool fluid = false;
+    // The texture scrolls over time (uv.z)
+    bool animated = false;
+    // Stops the player from moving through it
+    bool solid = true;
+    // Can be removed by the player
+    bool breakable = true;
+    // Block light level given off by the block itself
+    unsigned char emission = 0;
+};
+
+// The texture array layer of the atlas tile at (col, row), counting rows from the bottom
+constexpr unsigned char atlasTile(int col, int row) {
+    return static_cast<unsigned char>(col + 16 * row);
+}
+
+// A block with one tile on every face
+constexpr BlockInfo cubeBlock(unsigned char all) {
+    BlockInfo b;
+    b.tiles = {all, all, all, all, all, all};
+    return b;
+}
+
+// A block with its own tiles for the sides, top and bottom
+constexpr BlockInfo columnBlock(unsigned char side, unsigned char top, unsigned char bottom) {
+    BlockInfo b;
+    b.tiles = {side, side, top, bottom, side, side};
+    return b;
+}
+
+constexpr std::array<BlockInfo, BLOCK_TYPE_COUNT> makeBlockRegistry() {
+    std::array<BlockInfo, BLOCK_TYPE_COUNT> r = {};
+
+    r[EMPTY].opaque = false;
+    r[EMPTY].solid = false;
+    r[EMPTY].breakable = false;
+
+    r[GRASS] = columnBlock(atlasTile(3, 15), atlasTile(8, 13), atlasTile(2, 15));
+    r[DIRT] = cubeBlock(atlasTile(2, 15));
+    r[STONE] = cubeBlock(atlasTile(1, 15));
+    r[SNOW] = cubeBlock(atlasTile(2, 11));
+    r[SAND] = cubeBlock(atlasTile(2, 14));
+    r[ICE] = cubeBlock(atlasTile(3, 11));
+    r[SNOW_DIRT] = columnBlock(atlasTile(4, 11), atlasTile(2, 11), atlasTile(2, 15));
+    r[LEAF] = cubeBlock(atlasTile(5, 12));
+    r[WOOD] = columnBlock(atlasTile(4, 14), atlasTile(5, 14), atlasTile(5, 14));
+    r[SNOW_LEAF] = columnBlock(atlasTile(5, 12), atlasTile(2, 11), atlasTile(5, 12));
+    r[SAP] = r[WOOD];
+    r[CACTUS] = columnBlock(atlasTile(6, 11), atlasTile(5, 11), atlasTile(5, 11));
+    r[GRAVEL] = cubeBlock(atlasTile(0, 15));
+    r[SNOW_GRASS_PATCH] = columnBlock(atlasTile(3, 15), atlasTile(1, 6), atlasTile(2, 15));
+    r[DIRT_GRASS_PATCH] = columnBlock(atlasTile(3, 15), atlasTile(2, 5), atlasTile(2, 15));
+    r[COAL] = cubeBlock(atlasTile(2, 13));
+    r[LAPIS] = cubeBlock(atlasTile(0, 5));
+    r[COPPER] = cubeBlock(atlasTile(1, 13));
+    r[GOLD] = cubeBlock(atlasTile(0, 13));
+    r[SAND_CRACK] = columnBlock(atlasTile(2, 14), atlasTile(0, 2), atlasTile(2, 14));
+
+    // A log lying along z shows its rings on the z faces
+    r[SIDE_WOOD] = cubeBlock(atlasTile(4, 14));
+    r[SIDE_WOOD].tiles[ZPOS] = atlasTile(5, 14);
+    r[SIDE_WOOD].tiles[ZNEG] = atlasTile(5, 14);
+
+    r[WATER] = cubeBlock(atlasTile(13, 3));
+    r[WATER].faceEffects[YPOS] = 1;
+    r[WATER].opaque = false;
+    r[WATER].transparent = true;
+    r[WATER].fluid = true;
+    r[WATER].animated = true;
+    r[WATER].solid = false;
+    r[WATER].breakable = false;
+
+    r[LAVA] = cubeBlock(atlasTile(13, 1));
+    r[LAVA].animated = true;
+    r[LAVA].solid = false;
+    r[LAVA].breakable = false;
+    r[LAVA].emission = 15;
+
+    r[BEDROCK] = cubeBlock(atlasTile(1, 14));
+    r[BEDROCK].breakable = false;
+
+    r[ICE].opaque = false;
+    r[ICE].transparent = true;
+
+    r[CACTUS].faceEffects = {3, -3, 2, -2, 4, -4};
+    r[CACTUS].opaque = false;
+
+    r[SNOW_GRASS_PATCH].faceEffects[YPOS] = -7;
+    r[DIRT_GRASS_PATCH].faceEffects[YPOS] = -8;
+    r[SAND_CRACK].faceEffects[YPOS] = -9;
+
+    return r;
+}
+
+// Built at compile time so every property check is a single indexed load
+constexpr std::array<BlockInfo, BLOCK_TYPE_COUNT> BLOCK_REGISTRY = makeBlockRegistry();
+
+constexpr const BlockInfo& blockInfo(BlockType t) {
+    return BLOCK_REGISTRY[t];
+}
+
+// Whether a face of block a is covered by the neighboring block b
+constexpr bool isFaceHidden(BlockType a, BlockType b) {
+    return BLOCK_REGISTRY[b].opaque || (a == b && BLOCK_REGISTRY[b].transparent);
+}
+
+// The light level that spreads from a block lit at level into its neighbor of
+// type into, lying in direction dir. Light drops by one per block, except that
+// full sky light falls straight down through air without fading.
+constexpr int propagatedLight(int level, BlockType into, Direction dir, LightChannel channel) {
+    if (BLOCK_REGISTRY[into].opaque || level <= 0) {
+        return 0;
+    }
+    if (channel == SKY_LIGHT && level == MAX_LIGHT && dir == YNEG && into == EMPTY) {
+        return MAX_LIGHT;
+    }
+    return level - 1;
+}
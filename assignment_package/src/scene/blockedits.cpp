@@ -0,0 +1,98 @@
+#include "blockedits.h"
+
+BlockEditBuffer::BlockEditBuffer()
+    : m_edits()
+{}
+
+void BlockEditBuffer::set(glm::ivec3 pos, BlockType t) {
+    m_edits.push_back(Edit{pos, t});
+}
+
+void BlockEditBuffer::fillBox(glm::ivec3 min, glm::ivec3 max, BlockType t) {
+    for (int z = min.z; z <= max.z; ++z) {
+        for (int y = min.y; y <= max.y; ++y) {
+            for (int x = min.x; x <= max.x; ++x) {
+                m_edits.push_back(Edit{glm::ivec3(x, y, z), t});
+            }
+        }
+    }
+}
+
+void BlockEditBuffer::fillSphere(glm::vec3 center, float radius, BlockType t) {
+    glm::ivec3 min = glm::ivec3(glm::floor(center - radius));
+    glm::ivec3 max = glm::ivec3(glm::floor(center + radius));
+    for (int z = min.z; z <= max.z; ++z) {
+        for (int y = min.y; y <= max.y; ++y) {
+            for (int x = min.x; x <= max.x; ++x) {
+                if (glm::length(glm::vec3(x, y, z) + 0.5f - center) <= radius) {
+                    m_edits.push_back(Edit{glm::ivec3(x, y, z), t});
+                }
+            }
+        }
+    }
+}
+
+void BlockEditBuffer::clear() {
+    m_edits.clear();
+}
+
+bool BlockEditBuffer::empty() const {
+    return m_edits.empty();
+}
+
+size_t BlockEditBuffer::size() const {
+    return m_edits.size();
+}
+
+const std::vector<BlockEditBuffer::Edit>& BlockEditBuffer::getEdits() const {
+    return m_edits;
+}
+
+BlockEditRecord::BlockEditRecord()
+    : m_chunks(), m_blockCount(0)
+{}
+
+void BlockEditRecord::addBlock(glm::ivec2 chunk, int index, BlockType previous) {
+    ++m_blockCount;
+    if (m_chunks.empty() || m_chunks.back().chunk != chunk) {
+        m_chunks.push_back(ChunkRuns{chunk, {}});
+    }
+    std::vector<Run> &runs = m_chunks.back().runs;
+    if (!runs.empty()) {
+        Run &last = runs.back();
+        if (last.type == previous && last.first + last.count == index && last.count < UINT16_MAX) {
+            ++last.count;
+            return;
+        }
+    }
+    runs.push_back(Run{static_cast<uint16_t>(index), 1, previous});
+}
+
+bool BlockEditRecord::empty() const {
+    return m_blockCount == 0;
+}
+
+size_t BlockEditRecord::blockCount() const {
+    return m_blockCount;
+}
+
+size_t BlockEditRecord::bytes() const {
+    size_t bytes = 0;
+    for (const ChunkRuns &c : m_chunks) {
+        bytes += sizeof(ChunkRuns) + c.runs.size() * sizeof(Run);
+    }
+    return bytes;
+}
+
+BlockEditBuffer BlockEditRecord::toEdits() const {
+    BlockEditBuffer edits;
+    for (const ChunkRuns &c : m_chunks) {
+        for (const Run &run : c.runs) {
+            for (int i = run.first; i < run.first + run.count; ++i) {
+                // The inverse of the x + 16 * y + 16 * 256 * z the Chunk indexes blocks by
+                edits.set(glm::ivec3(c.chunk.x + (i & 15), (i >> 4) & 255, c.chunk.y + (i >> 12)), run.type);
+            }
+        }
+    }
+    return edits;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "block.h"
+#include <glm_includes.h>
+#include <cstdint>
+#include <vector>
+
+// Block writes collected up front and applied together by Terrain::applyEdits,
+// which relights once and remeshes each Chunk it touches once, rather than
+// once per block as setGlobalBlockAt does. Later writes to a block win.
+class BlockEditBuffer {
+public:
+    struct Edit {
+        glm::ivec3 pos;
+        BlockType type;
+    };
+
+private:
+    std::vector<Edit> m_edits;
+
+public:
+    BlockEditBuffer();
+
+    void set(glm::ivec3 pos, BlockType t);
+    // Every block from min to max, both included
+    void fillBox(glm::ivec3 min, glm::ivec3 max, BlockType t);
+    // Every block whose center lies within radius of center
+    void fillSphere(glm::vec3 center, float radius, BlockType t);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    const std::vector<Edit>& getEdits() const;
+};
+
+// The blocks Terrain::applyEdits overwrote, enough to put them back. Kept per
+// Chunk as runs of neighboring blocks along x that held the same type, which
+// is most of a box or sphere, so a run of any length costs six bytes.
+class BlockEditRecord {
+public:
+    struct Run {
+        uint16_t first; // Index of the first block in the Chunk, as Chunk stores them
+        uint16_t count;
+        BlockType type;
+    };
+
+private:
+    struct ChunkRuns {
+        glm::ivec2 chunk; // Lower-left corner of the Chunk
+        std::vector<Run> runs;
+    };
+    std::vector<ChunkRuns> m_chunks;
+    size_t m_blockCount;
+
+public:
+    BlockEditRecord();
+
+    // Called by applyEdits with each Chunk's blocks in ascending index order
+    void addBlock(glm::ivec2 chunk, int index, BlockType previous);
+    bool empty() const;
+    size_t blockCount() const;
+    // Memory taken by the runs
+    size_t bytes() const;
+    // Edits that put every recorded block back the way it was
+    BlockEditBuffer toEdits() const;
+};
@@ -1,9 +1,38 @@
 #include "chunk.h"
+#include "profiler.h"
+#include <algorithm>
 #include <iostream>
 
+const static std::unordered_map<Direction, Direction, EnumHash> oppositeDirection {
+    {XPOS, XNEG},
+    {XNEG, XPOS},
+    {YPOS, YNEG},
+    {YNEG, YPOS},
+    {ZPOS, ZNEG},
+    {ZNEG, ZPOS}
+};
+
+// Tiles of the foliage drawn by generateDecorations
+const static unsigned char tallGrassTile = atlasTile(7, 13);
+const static unsigned char roseTile = atlasTile(12, 15);
+const static unsigned char dandelionTile = atlasTile(13, 15);
+const static unsigned char deadBushTile = atlasTile(7, 12);
+
+// Scrambles a world column into 32 random bits, the same whichever thread meshes it
+static unsigned int hashColumn(int x, int z) {
+    unsigned int h = static_cast<unsigned int>(x) * 73856093u ^ static_cast<unsigned int>(z) * 19349663u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
 Chunk::Chunk(int x, int z, OpenGLContext *context)
-    : Drawable(context), m_blocks(), minX(x), minZ(z), m_neighbors{{XPOS, nullptr}, {XNEG, nullptr}, {ZPOS, nullptr}, {ZNEG, nullptr}},
-    vboData()
+    : Drawable(context), m_blocks(), m_light(), m_brickBits(), m_sectionBits(), m_lightReady(false), m_filled(false), minX(x), minZ(z), m_neighbors{{XPOS, nullptr}, {XNEG, nullptr}, {ZPOS, nullptr}, {ZNEG, nullptr}},
+    vboData(), m_lodOffsets(), m_meshLevels(MESH_ALL), m_solidHeights(0, -1), m_transCenters(), m_transIdx(), m_meshVersion(0), m_sortedVersion(-1), m_sortOrigin(),
+    m_decorationOffsets(), m_decorationShapes()
 {
     std::fill_n(m_blocks.begin(), 65536, EMPTY);
 }
@@ -22,17 +51,123 @@ BlockType Chunk::getLocalBlockAt(int x, int y, int z) const {
 // Does bounds checking with at()
 void Chunk::setLocalBlockAt(unsigned int x, unsigned int y, unsigned int z, BlockType t) {
     m_blocks.at(x + 16 * y + 16 * 256 * z) = t;
+    int brick = brickIndex(x, y, z);
+    uint64_t bit = uint64_t(1) << bitInBrick(x, y, z);
+    m_brickBits[brick] = t == EMPTY ? m_brickBits[brick] & ~bit : m_brickBits[brick] | bit;
+    uint64_t brickBit = uint64_t(1) << (brick & 63);
+    m_sectionBits[brick >> 6] = m_brickBits[brick] != 0 ? m_sectionBits[brick >> 6] | brickBit
+                                                        : m_sectionBits[brick >> 6] & ~brickBit;
 }
 
+int Chunk::brickIndex(int x, int y, int z) {
+    return 64 * (y >> 4) + (x >> 2) + 4 * ((y >> 2) & 3) + 16 * (z >> 2);
+}
 
-const static std::unordered_map<Direction, Direction, EnumHash> oppositeDirection {
-    {XPOS, XNEG},
-    {XNEG, XPOS},
-    {YPOS, YNEG},
-    {YNEG, YPOS},
-    {ZPOS, ZNEG},
-    {ZNEG, ZPOS}
-};
+int Chunk::bitInBrick(int x, int y, int z) {
+    return (x & 3) + 4 * (y & 3) + 16 * (z & 3);
+}
+
+uint64_t Chunk::getBrickBits(int brick) const {
+    return m_brickBits[brick];
+}
+
+uint64_t Chunk::getSectionBits(int section) const {
+    return m_sectionBits[section];
+}
+
+int Chunk::getLocalLightAt(int x, int y, int z, LightChannel channel) const {
+    unsigned char light = m_light.at(x + 16 * y + 16 * 256 * z);
+    return channel == SKY_LIGHT ? light >> 4 : light & 15;
+}
+
+void Chunk::setLocalLightAt(int x, int y, int z, LightChannel channel, int level) {
+    unsigned char &light = m_light.at(x + 16 * y + 16 * 256 * z);
+    light = channel == SKY_LIGHT ? packLight(level, light & 15) : packLight(light >> 4, level);
+}
+
+bool Chunk::isLightReady() const {
+    return m_lightReady.load(std::memory_order_acquire);
+}
+
+void Chunk::markLightReady() {
+    m_lightReady.store(true, std::memory_order_release);
+}
+
+bool Chunk::isFilled() const {
+    return m_filled.load(std::memory_order_acquire);
+}
+
+void Chunk::markFilled() {
+    m_filled.store(true, std::memory_order_release);
+}
+
+void Chunk::copyBlocks(int minY, int maxY, BlockType *out) const {
+    int height = maxY - minY + 1;
+    for (int z = 0; z < 16; ++z) {
+        std::copy_n(m_blocks.begin() + 16 * minY + 16 * 256 * z, 16 * height, out + 16 * height * z);
+    }
+}
+
+void Chunk::computeLight() {
+    PROFILE_SCOPE("light chunk");
+    std::fill(m_light.begin(), m_light.end(), 0);
+    std::vector<int> skyQueue, blockQueue;
+
+    // The open sky shines straight down each column until it meets a block
+    for (int z = 0; z < 16; ++z) {
+        for (int x = 0; x < 16; ++x) {
+            for (int y = 255; y >= 0 && getLocalBlockAt(x, y, z) == EMPTY; --y) {
+                setLocalLightAt(x, y, z, SKY_LIGHT, MAX_LIGHT);
+            }
+        }
+    }
+
+    // Only the edges of the sky lit space and the emitting blocks have to seed the fill
+    for (int z = 0; z < 16; ++z) {
+        for (int y = 0; y < 256; ++y) {
+            for (int x = 0; x < 16; ++x) {
+                int i = x + 16 * y + 16 * 256 * z;
+                int emission = blockInfo(m_blocks[i]).emission;
+                if (emission > 0) {
+                    setLocalLightAt(x, y, z, BLOCK_LIGHT, emission);
+                    blockQueue.push_back(i);
+                }
+                if (getLocalLightAt(x, y, z, SKY_LIGHT) != MAX_LIGHT) continue;
+                for (const BlockFace &face : faces) {
+                    glm::ivec3 n = glm::ivec3(x, y, z) + face.dirVector;
+                    if (n.x < 0 || n.x >= 16 || n.y < 0 || n.y >= 256 || n.z < 0 || n.z >= 16) continue;
+                    if (propagatedLight(MAX_LIGHT, getLocalBlockAt(n.x, n.y, n.z), face.dir, SKY_LIGHT) >
+                        getLocalLightAt(n.x, n.y, n.z, SKY_LIGHT)) {
+                        skyQueue.push_back(i);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    floodLight(skyQueue, SKY_LIGHT);
+    floodLight(blockQueue, BLOCK_LIGHT);
+}
+
+void Chunk::floodLight(std::vector<int>& queue, LightChannel channel) {
+    // Breadth first, so every block is reached first by its brightest path
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int i = queue[head];
+        glm::ivec3 p = glm::ivec3(i % 16, (i / 16) % 256, i / (16 * 256));
+        int level = getLocalLightAt(p.x, p.y, p.z, channel);
+        for (const BlockFace &face : faces) {
+            glm::ivec3 n = p + face.dirVector;
+            // Light crossing into the neighbors is spread by LightEngine::chunkLit
+            if (n.x < 0 || n.x >= 16 || n.y < 0 || n.y >= 256 || n.z < 0 || n.z >= 16) continue;
+            int spread = propagatedLight(level, getLocalBlockAt(n.x, n.y, n.z), face.dir, channel);
+            if (spread > getLocalLightAt(n.x, n.y, n.z, channel)) {
+                setLocalLightAt(n.x, n.y, n.z, channel, spread);
+                queue.push_back(n.x + 16 * n.y + 16 * 256 * n.z);
+            }
+        }
+    }
+}
 
 void Chunk::linkNeighbor(uPtr<Chunk> &neighbor, Direction dir) {
     if(neighbor != nullptr) {
@@ -56,10 +191,21 @@ void Chunk::createVBOdata() {
     std::vector<GLuint> solidIdx = vboData.solidIdx;
     std::vector<glm::vec4> transData = vboData.transData;
     std::vector<GLuint> transIdx = vboData.transIdx;
+    std::vector<glm::vec4> lodData = vboData.lodData;
+    std::vector<GLuint> lodIdx = vboData.lodIdx;
 
     // Set Buffer index counts
     indexCounts[INDEX] = solidIdx.size();
     indexCounts[TRANSPARENT_INDEX] = transIdx.size();
+    indexCounts[LOD_INDEX] = lodIdx.size();
+    m_lodOffsets = vboData.lodOffsets;
+    m_meshLevels = vboData.levels;
+    m_solidHeights = vboData.solidHeights;
+    m_transCenters = vboData.transCenters;
+    m_transIdx = transIdx;
+    m_decorationOffsets = vboData.decorationOffsets;
+    m_decorationShapes = vboData.decorationShapes;
+    ++m_meshVersion;
 
     // Create and bind interleaved buffer
     generateBuffer(INTERLEAVED);
@@ -89,111 +235,526 @@ void Chunk::createVBOdata() {
                              transIdx.data(),
                              GL_STATIC_DRAW);
 
+    // All LOD levels share one vertex and one index buffer
+    generateBuffer(LOD_INTERLEAVED);
+    bindBuffer(LOD_INTERLEAVED);
+    mp_context->glBufferData(GL_ARRAY_BUFFER,
+                             lodData.size() * sizeof(glm::vec4),
+                             lodData.data(),
+                             GL_STATIC_DRAW);
+    generateBuffer(LOD_INDEX);
+    bindBuffer(LOD_INDEX);
+    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                             lodIdx.size() * sizeof(GLuint),
+                             lodIdx.data(),
+                             GL_STATIC_DRAW);
+
+    createFluidVBOdata();
 }
 
-void Chunk::generateVBOdata() {
+void Chunk::createFluidVBOdata() {
+    // Free the old fluid buffers without touching the rest of the chunk
+    for (BufferType buf : {FLUID_INTERLEAVED, FLUID_INDEX}) {
+        if (bufGenerated[buf]) {
+            mp_context->glDeleteBuffers(1, &bufHandles[buf]);
+            bufGenerated[buf] = false;
+        }
+    }
+    indexCounts[FLUID_INDEX] = vboData.fluidIdx.size();
+
+    generateBuffer(FLUID_INTERLEAVED);
+    bindBuffer(FLUID_INTERLEAVED);
+    mp_context->glBufferData(GL_ARRAY_BUFFER,
+                             vboData.fluidData.size() * sizeof(glm::vec4),
+                             vboData.fluidData.data(),
+                             GL_STATIC_DRAW);
+    generateBuffer(FLUID_INDEX);
+    bindBuffer(FLUID_INDEX);
+    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                             vboData.fluidIdx.size() * sizeof(GLuint),
+                             vboData.fluidIdx.data(),
+                             GL_STATIC_DRAW);
+}
+
+void Chunk::generateVBOdata(int levels) {
     // Create vectors to store the VBO data
     std::vector<glm::vec4> solidData, transData;
     std::vector<GLuint> solidIdx, transIdx;
+    std::vector<glm::vec3> transCenters;
 
     int solidVertCount = 0;
     int transVertCount = 0;
 
-    // Iterate through each block in the chunk
-    for (int z = 0; z < 16; ++z) {
-        for (int y = 0; y < 256; ++y) {
-            for (int x = 0; x < 16; ++x) {
-                BlockType currBlock = getLocalBlockAt(x, y, z);
-                // if the current block is nothing, go to the next iteration
-                if (currBlock == EMPTY) continue;
+    glm::ivec2 solidHeights(256, -1);
 
-                glm::vec4 blockPos = glm::vec4(x, y, z, 0.f) + glm::vec4(minX, 0.f, minZ, 0.f);
-                // Get neighboring blocks
-                BlockType xPos = getLocalBlockAt(x + 1, y, z);
-                BlockType xNeg = getLocalBlockAt(x - 1, y, z);
-                BlockType yPos = getLocalBlockAt(x, y + 1, z);
-                BlockType yNeg = getLocalBlockAt(x, y - 1, z);
-                BlockType zPos = getLocalBlockAt(x, y, z + 1);
-                BlockType zNeg = getLocalBlockAt(x, y, z - 1);
-                // Check for neighboring blocks over the edges of this chunk and set accordingly
-                if (x == 0 && m_neighbors.find(XNEG) != m_neighbors.end() && m_neighbors[XNEG]) xNeg = m_neighbors[XNEG]->getLocalBlockAt(15, y, z);
-                if (x == 15 && m_neighbors.find(XPOS) != m_neighbors.end() && m_neighbors[XPOS]) xPos = m_neighbors[XPOS]->getLocalBlockAt(0, y, z);
-                if (y == 0) yNeg = EMPTY;
-                if (y == 255) yPos = EMPTY;
-                if (z == 0 && m_neighbors.find(ZNEG) != m_neighbors.end() && m_neighbors[ZNEG]) zNeg = m_neighbors[ZNEG]->getLocalBlockAt(x, y, 15);
-                if (z == 15 && m_neighbors.find(ZPOS) != m_neighbors.end() && m_neighbors[ZPOS]) zPos = m_neighbors[ZPOS]->getLocalBlockAt(x, y, 0);
-
-                // Create an array of the neighbors so we can loop over them
-                std::array<std::pair<Direction, BlockType>, 6> neighbors = {
-                    std::pair(XPOS, xPos), std::pair(XNEG, xNeg),
-                    std::pair(YPOS, yPos), std::pair(YNEG, yNeg),
-                    std::pair(ZPOS, zPos), std::pair(ZNEG, zNeg)
-                };
-                // Loop Over Neighbors
-                for (auto neighbor : neighbors) {
-                    BlockType neighborType = neighbor.second;
-                    // If the neighbor is empty or (the neighbor is transparent and the current block isn't the
-                    // same block as the neighbor), then add to VBO to be drawn
-                    if (neighborType == EMPTY ||(isTransparent(neighborType) && neighborType != currBlock) ||
-                        neighborType == CACTUS) {
-
-                        if (isTransparent(currBlock)) {
-                            updateVBOdata(transData, transIdx, transVertCount, blockPos, neighbor.first, currBlock);
-                        } else {
-                            // otherwise, add to the solid vectors
-                            updateVBOdata(solidData, solidIdx, solidVertCount, blockPos, neighbor.first, currBlock);
+    // Far chunks only need their LOD meshes
+    if (levels & MESH_FULL) {
+        std::vector<BlockType> padded;
+        copyPaddedBlocks(padded);
 
-                        }
+        // Iterate through each block in the chunk
+        for (int z = 0; z < 16; ++z) {
+            for (int y = 0; y < 256; ++y) {
+                for (int x = 0; x < 16; ++x) {
+                    BlockType currBlock = getLocalBlockAt(x, y, z);
+                    // if the current block is nothing, go to the next iteration.
+                    // Fluids get their own mesh in generateFluidData.
+                    if (currBlock == EMPTY || blockInfo(currBlock).fluid) continue;
+
+                    glm::vec4 blockPos = glm::vec4(x, y, z, 0.f) + glm::vec4(minX, 0.f, minZ, 0.f);
+                    // Get neighboring blocks, the padding holds the ones over the edges of this chunk
+                    BlockType xPos = padded[paddedIndex(x + 1, y, z)];
+                    BlockType xNeg = padded[paddedIndex(x - 1, y, z)];
+                    BlockType yPos = padded[paddedIndex(x, y + 1, z)];
+                    BlockType yNeg = padded[paddedIndex(x, y - 1, z)];
+                    BlockType zPos = padded[paddedIndex(x, y, z + 1)];
+                    BlockType zNeg = padded[paddedIndex(x, y, z - 1)];
+
+                    // Create an array of the neighbors so we can loop over them
+                    std::array<std::pair<Direction, BlockType>, 6> neighbors = {
+                        std::pair(XPOS, xPos), std::pair(XNEG, xNeg),
+                        std::pair(YPOS, yPos), std::pair(YNEG, yNeg),
+                        std::pair(ZPOS, zPos), std::pair(ZNEG, zNeg)
+                    };
+                    // Loop Over Neighbors
+                    for (auto neighbor : neighbors) {
+                        BlockType neighborType = neighbor.second;
+                        // If the neighbor doesn't cover this face (it is not opaque, and not the
+                        // same transparent block as the current one), then add to VBO to be drawn
+                        if (!isFaceHidden(currBlock, neighborType)) {
+
+                            unsigned char light = getFaceLight(x, y, z, neighbor.first, currBlock);
+                            std::array<unsigned char, 4> ao = getFaceAO(padded, x, y, z, neighbor.first);
+                            if (blockInfo(currBlock).transparent) {
+                                updateVBOdata(transData, transIdx, transVertCount, blockPos, neighbor.first, currBlock, light,
+                                              glm::vec4(1, 1, 1, 1), ao);
+                                transCenters.push_back(glm::vec3(blockPos) + glm::vec3(0.5f) + 0.5f * glm::vec3(faces[neighbor.first].dirVector));
+                            } else {
+                                // otherwise, add to the solid vectors
+                                solidHeights = glm::ivec2(glm::min(solidHeights.x, y), glm::max(solidHeights.y, y));
+                                updateVBOdata(solidData, solidIdx, solidVertCount, blockPos, neighbor.first, currBlock, light,
+                                              glm::vec4(1, 1, 1, 1), ao);
 
+                            }
+
+                        }
                     }
                 }
             }
         }
     }
 
+    std::vector<glm::vec4> lodData;
+    std::vector<GLuint> lodIdx;
+    std::array<int, LOD_LEVELS + 1> lodOffsets;
+    // Without the full mesh the LOD meshes are what casts shadows
+    glm::ivec2 lodHeights(256, -1);
+    generateLODdata(levels, lodData, lodIdx, lodOffsets, lodHeights);
+    if (!(levels & MESH_FULL)) {
+        solidHeights = lodHeights;
+    }
+
+    // Water and foliage only show up close, with the full mesh
+    std::vector<glm::vec4> fluidData;
+    std::vector<GLuint> fluidIdx;
+    std::vector<glm::vec3> decorationOffsets;
+    std::vector<glm::vec4> decorationShapes;
+    if (levels & MESH_FULL) {
+        generateFluidData(fluidData, fluidIdx);
+        generateDecorations(decorationOffsets, decorationShapes);
+    }
+
     // Set the VBO data to the vboData member
     vboData.solidData = solidData;
     vboData.solidIdx = solidIdx;
     vboData.transData = transData;
     vboData.transIdx = transIdx;
+    vboData.transCenters = transCenters;
+    vboData.solidHeights = solidHeights;
+    vboData.fluidData = fluidData;
+    vboData.fluidIdx = fluidIdx;
+    vboData.lodData = lodData;
+    vboData.lodIdx = lodIdx;
+    vboData.lodOffsets = lodOffsets;
+    vboData.levels = levels;
+    vboData.decorationOffsets = decorationOffsets;
+    vboData.decorationShapes = decorationShapes;
 }
 
-void Chunk::updateVBOdata(std::vector<glm::vec4>& vboData, std::vector<GLuint>& idx, int& vertCount, glm::vec4 blockPos, Direction dir, BlockType bType) {
-    BlockFace face = faces.at(dir);
-    glm::vec4 uv = blockUVs.at(bType).at(dir);
-    glm::vec4 nor = glm::vec4(face.dirVector, 1);
+void Chunk::generateDecorations(std::vector<glm::vec3>& offsets, std::vector<glm::vec4>& shapes) const {
+    for (int z = 0; z < 16; ++z) {
+        for (int x = 0; x < 16; ++x) {
+            int y = 254;
+            while (y >= 0 && getLocalBlockAt(x, y, z) == EMPTY) {
+                --y;
+            }
+            if (y < 0 || getLocalBlockAt(x, y + 1, z) != EMPTY) continue;
 
-    // If the block type is water or lava, set the third value of the uv vec4
-    // to 1 to represent that this block is animateable
-    if (bType == WATER || bType == LAVA) {
-        uv.z = 1;
+            BlockType ground = getLocalBlockAt(x, y, z);
+            float roll = (hashColumn(minX + x, minZ + z) & 0xffff) / 65536.f;
+            unsigned char tile;
+            if (ground == GRASS || ground == DIRT_GRASS_PATCH) {
+                if (roll < 0.01f) {
+                    tile = roseTile;
+                } else if (roll < 0.02f) {
+                    tile = dandelionTile;
+                } else if (roll < 0.15f) {
+                    tile = tallGrassTile;
+                } else {
+                    continue;
+                }
+            } else if ((ground == SAND || ground == SAND_CRACK) && roll < 0.01f) {
+                tile = deadBushTile;
+            } else {
+                continue;
+            }
+            offsets.push_back(glm::vec3(minX + x, y + 1, minZ + z));
+            shapes.push_back(glm::vec4(1.f, 1.f, 1.f, tile));
+        }
     }
+}
+
+int Chunk::paddedIndex(int x, int y, int z) {
+    return (x + 1) + 18 * ((y + 1) + 258 * (z + 1));
+}
 
+void Chunk::copyPaddedBlocks(std::vector<BlockType>& padded) const {
+    // Anything past an unloaded neighbor, or above and below the world, is air
+    padded.assign(18 * 258 * 18, EMPTY);
+    for (int z = 0; z < 16; ++z) {
+        for (int y = 0; y < 256; ++y) {
+            std::copy_n(&m_blocks[16 * y + 16 * 256 * z], 16, &padded[paddedIndex(0, y, z)]);
+        }
+    }
 
+    // Find the eight chunks around this one once, the corners through either side
+    auto neighbor = [](const Chunk *c, Direction dir) -> const Chunk* {
+        if (c == nullptr) return nullptr;
+        auto n = c->m_neighbors.find(dir);
+        return n == c->m_neighbors.end() ? nullptr : n->second;
+    };
+    auto corner = [&](Direction a, Direction b) -> const Chunk* {
+        const Chunk *c = neighbor(neighbor(this, a), b);
+        return c ? c : neighbor(neighbor(this, b), a);
+    };
+    std::array<std::pair<glm::ivec2, const Chunk*>, 8> around = {
+        std::pair(glm::ivec2(1, 0), neighbor(this, XPOS)), std::pair(glm::ivec2(-1, 0), neighbor(this, XNEG)),
+        std::pair(glm::ivec2(0, 1), neighbor(this, ZPOS)), std::pair(glm::ivec2(0, -1), neighbor(this, ZNEG)),
+        std::pair(glm::ivec2(1, 1), corner(XPOS, ZPOS)), std::pair(glm::ivec2(1, -1), corner(XPOS, ZNEG)),
+        std::pair(glm::ivec2(-1, 1), corner(XNEG, ZPOS)), std::pair(glm::ivec2(-1, -1), corner(XNEG, ZNEG))
+    };
+    for (auto &a : around) {
+        const Chunk *c = a.second;
+        if (c == nullptr) continue;
+        glm::ivec2 dir = a.first;
+        // The border column or row of the padding this neighbor covers
+        int x0 = dir.x > 0 ? 16 : dir.x < 0 ? -1 : 0, x1 = dir.x == 0 ? 15 : x0;
+        int z0 = dir.y > 0 ? 16 : dir.y < 0 ? -1 : 0, z1 = dir.y == 0 ? 15 : z0;
+        for (int z = z0; z <= z1; ++z) {
+            for (int x = x0; x <= x1; ++x) {
+                for (int y = 0; y < 256; ++y) {
+                    padded[paddedIndex(x, y, z)] = c->m_blocks[((x + 16) % 16) + 16 * y + 16 * 256 * ((z + 16) % 16)];
+                }
+            }
+        }
+    }
+}
 
+std::array<unsigned char, 4> Chunk::getFaceAO(const std::vector<BlockType>& padded, int x, int y, int z, Direction dir) {
+    const BlockFace &face = faces[dir];
+    // The layer of blocks the face looks out onto
+    glm::ivec3 front = glm::ivec3(x, y, z) + face.dirVector;
+    std::array<unsigned char, 4> ao;
     for (int i = 0; i < 4; ++i) {
-        // add position to VBO
-        vboData.push_back(face.vertices.at(i).pos + blockPos);
+        // Step from the front block towards the corner along each axis of the face
+        glm::ivec3 toCorner = glm::ivec3(glm::vec3(face.vertices[i].pos)) * 2 - 1;
+        glm::ivec3 u(0), v(0);
+        if (face.dirVector.x != 0) {
+            u.y = toCorner.y;
+            v.z = toCorner.z;
+        } else if (face.dirVector.y != 0) {
+            u.x = toCorner.x;
+            v.z = toCorner.z;
+        } else {
+            u.x = toCorner.x;
+            v.y = toCorner.y;
+        }
+        auto occludes = [&](glm::ivec3 p) {
+            return blockInfo(padded[paddedIndex(p.x, p.y, p.z)]).opaque ? 1 : 0;
+        };
+        int side1 = occludes(front + u), side2 = occludes(front + v), corner = occludes(front + u + v);
+        // Two sides already close off the corner whatever is in it
+        ao[i] = side1 && side2 ? 0 : 3 - (side1 + side2 + corner);
+    }
+    return ao;
+}
+
+void Chunk::generateFluidVBOdata() {
+    std::vector<glm::vec4> fluidData;
+    std::vector<GLuint> fluidIdx;
+    generateFluidData(fluidData, fluidIdx);
+    vboData.fluidData = fluidData;
+    vboData.fluidIdx = fluidIdx;
+}
+
+void Chunk::generateFluidData(std::vector<glm::vec4>& fluidData, std::vector<GLuint>& fluidIdx) {
+    int vertCount = 0;
+    for (int z = 0; z < 16; ++z) {
+        for (int y = 0; y < 256; ++y) {
+            for (int x = 0; x < 16; ++x) {
+                BlockType currBlock = getLocalBlockAt(x, y, z);
+                if (!blockInfo(currBlock).fluid) continue;
+
+                glm::vec4 blockPos = glm::vec4(x, y, z, 0.f) + glm::vec4(minX, 0.f, minZ, 0.f);
+                // Only faces open to the air can be seen. Faces against other water, solids
+                // or ice are hidden, and the underside of water is never drawn.
+                for (const BlockFace &face : faces) {
+                    if (face.dir == YNEG) continue;
+                    BlockType neighborType;
+                    glm::ivec3 n = glm::ivec3(x, y, z) + face.dirVector;
+                    // Skip faces on the border of an unloaded chunk, they would show up as walls
+                    if (!getAdjacentBlockAt(n.x, n.y, n.z, neighborType)) continue;
+                    if (neighborType == EMPTY) {
+                        updateVBOdata(fluidData, fluidIdx, vertCount, blockPos, face.dir, currBlock,
+                                      getFaceLight(x, y, z, face.dir, currBlock));
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool Chunk::getAdjacentBlockAt(int x, int y, int z, BlockType& out) const {
+    Direction dir;
+    if (y < 0 || y >= 256) {
+        out = EMPTY;
+        return true;
+    } else if (x < 0) {
+        dir = XNEG;
+        x += 16;
+    } else if (x >= 16) {
+        dir = XPOS;
+        x -= 16;
+    } else if (z < 0) {
+        dir = ZNEG;
+        z += 16;
+    } else if (z >= 16) {
+        dir = ZPOS;
+        z -= 16;
+    } else {
+        out = getLocalBlockAt(x, y, z);
+        return true;
+    }
+    auto neighbor = m_neighbors.find(dir);
+    if (neighbor == m_neighbors.end() || neighbor->second == nullptr) {
+        return false;
+    }
+    out = neighbor->second->getLocalBlockAt(x, y, z);
+    return true;
+}
+
+unsigned char Chunk::getAdjacentLightAt(int x, int y, int z) const {
+    const unsigned char openSky = packLight(MAX_LIGHT, 0);
+    if (y >= 256) return openSky;
+    if (y < 0) return 0;
+    const Chunk *c = this;
+    Direction dir = x < 0 ? XNEG : x >= 16 ? XPOS : z < 0 ? ZNEG : ZPOS;
+    if (x < 0 || x >= 16 || z < 0 || z >= 16) {
+        auto neighbor = m_neighbors.find(dir);
+        if (neighbor == m_neighbors.end() || neighbor->second == nullptr) return openSky;
+        c = neighbor->second;
+        x = (x + 16) % 16;
+        z = (z + 16) % 16;
+    }
+    if (!c->isLightReady()) return openSky;
+    return c->m_light[x + 16 * y + 16 * 256 * z];
+}
+
+unsigned char Chunk::getFaceLight(int x, int y, int z, Direction dir, BlockType bType) const {
+    // A face is lit by the block it looks out onto
+    glm::ivec3 n = glm::ivec3(x, y, z) + faces[dir].dirVector;
+    unsigned char light = getAdjacentLightAt(n.x, n.y, n.z);
+    // Emitting blocks glow at least as bright as their own light
+    int block = std::max<int>(light & 15, blockInfo(bType).emission);
+    return packLight(light >> 4, block);
+}
+
+// How far the skirts around the edge of a LOD mesh hang down. They
+// cover the cracks between chunks drawn at different LOD levels.
+const static float lodSkirtDepth = 16.f;
+
+void Chunk::generateLODdata(int levels, std::vector<glm::vec4>& lodData, std::vector<GLuint>& lodIdx,
+                            std::array<int, LOD_LEVELS + 1>& lodOffsets, glm::ivec2& heights) {
+    // Find the top block of every column once, each LOD level is built from this heightmap
+    std::array<int, 256> columnHeights;
+    std::array<BlockType, 256> tops;
+    for (int z = 0; z < 16; ++z) {
+        for (int x = 0; x < 16; ++x) {
+            columnHeights[x + 16 * z] = -1;
+            tops[x + 16 * z] = EMPTY;
+            if (!(levels & ~MESH_FULL)) continue;
+            for (int y = 255; y >= 0; --y) {
+                BlockType b = getLocalBlockAt(x, y, z);
+                if (b != EMPTY) {
+                    columnHeights[x + 16 * z] = y;
+                    tops[x + 16 * z] = b;
+                    break;
+                }
+            }
+        }
+    }
+
+    int vertCount = 0;
+    for (int level = 1; level <= LOD_LEVELS; ++level) {
+        lodOffsets[level - 1] = lodIdx.size();
+        if (!(levels & (1 << level))) continue;
+        int step = 1 << level;
+        int cells = 16 / step;
+
+        // Each cell of step x step columns becomes one column whose height is the
+        // mean of its columns and whose block is picked by majority vote
+        std::vector<int> cellHeights(cells * cells, -1);
+        std::vector<BlockType> cellTypes(cells * cells, EMPTY);
+        for (int cz = 0; cz < cells; ++cz) {
+            for (int cx = 0; cx < cells; ++cx) {
+                std::array<int, 256> votes{};
+                int heightSum = 0, columns = 0;
+                BlockType winner = EMPTY;
+                for (int z = cz * step; z < (cz + 1) * step; ++z) {
+                    for (int x = cx * step; x < (cx + 1) * step; ++x) {
+                        if (columnHeights[x + 16 * z] < 0) continue;
+                        heightSum += columnHeights[x + 16 * z];
+                        ++columns;
+                        BlockType b = tops[x + 16 * z];
+                        if (++votes[b] > votes[winner]) {
+                            winner = b;
+                        }
+                    }
+                }
+                if (columns > 0) {
+                    cellHeights[cx + cells * cz] = static_cast<int>(glm::round(heightSum / static_cast<float>(columns)));
+                    cellTypes[cx + cells * cz] = winner;
+                }
+            }
+        }
+
+        for (int cz = 0; cz < cells; ++cz) {
+            for (int cx = 0; cx < cells; ++cx) {
+                int h = cellHeights[cx + cells * cz];
+                if (h < 0) continue;
+                BlockType bType = cellTypes[cx + cells * cz];
+                float top = h + 1.f;
+                heights = glm::ivec2(glm::min(heights.x, glm::max(0, h - static_cast<int>(lodSkirtDepth))), glm::max(heights.y, h));
+                glm::vec4 cellPos = glm::vec4(cx * step + minX, 0.f, cz * step + minZ, 0.f);
+
+                // Top of the column
+                // Distant terrain is only seen from above, so it is drawn in full sky light
+                updateVBOdata(lodData, lodIdx, vertCount, cellPos + glm::vec4(0, h, 0, 0), YPOS, bType,
+                              packLight(MAX_LIGHT, 0), glm::vec4(step, 1, step, 1));
+
+                // Sides down to lower neighboring cells, or a skirt at the chunk's edge
+                for (Direction dir : {XPOS, XNEG, ZPOS, ZNEG}) {
+                    glm::ivec3 offset = faces[dir].dirVector;
+                    int nx = cx + offset.x, nz = cz + offset.z;
+                    float bottom;
+                    if (nx >= 0 && nx < cells && nz >= 0 && nz < cells) {
+                        bottom = cellHeights[nx + cells * nz] + 1.f;
+                        if (bottom >= top) continue;
+                    } else {
+                        bottom = glm::max(0.f, top - lodSkirtDepth);
+                    }
+                    updateVBOdata(lodData, lodIdx, vertCount, cellPos + glm::vec4(0, bottom, 0, 0), dir, bType,
+                                  packLight(MAX_LIGHT, 0), glm::vec4(step, top - bottom, step, 1));
+                }
+            }
+        }
+    }
+    lodOffsets[LOD_LEVELS] = lodIdx.size();
+}
+
+void Chunk::updateVBOdata(std::vector<glm::vec4>& vboData, std::vector<GLuint>& idx, int& vertCount, glm::vec4 blockPos, Direction dir, BlockType bType,
+                          unsigned char light, glm::vec4 scale, std::array<unsigned char, 4> ao) {
+    const BlockFace &face = faces[dir];
+    const BlockInfo &info = blockInfo(bType);
+    // The normal's w holds the texture array layer of the face's tile
+    glm::vec4 nor = glm::vec4(face.dirVector, info.tiles[dir]);
+    // The third value of the uv vec4 is 1 if this block is animateable,
+    // the fourth is the face's shader effect
+    glm::vec4 uv = glm::vec4(0, 0, info.animated ? 1 : 0, info.faceEffects[dir]);
+
+
+
+    for (int i = 0; i < 4; ++i) {
+        // add position to VBO, with the face's light and the corner's occlusion in place of w
+        glm::vec4 pos = face.vertices.at(i).pos * scale + blockPos;
+        pos.w = light + 256 * ao[i];
+        vboData.push_back(pos);
         // add normal to VBO
         vboData.push_back(nor);
         // add uv to VBO
         vboData.push_back(uv + face.vertices.at(i).uv);
     }
 
-    // add indices to idx vector
-    idx.push_back(vertCount);
-    idx.push_back(vertCount + 1);
-    idx.push_back(vertCount + 2);
-    idx.push_back(vertCount);
-    idx.push_back(vertCount + 2);
-    idx.push_back(vertCount + 3);
+    // add indices to idx vector. The quad is split along the diagonal
+    // between its brighter corners, so the occlusion of one dark corner
+    // fades out evenly instead of streaking along the split.
+    int first = ao[0] + ao[2] >= ao[1] + ao[3] ? 0 : 1;
+    idx.push_back(vertCount + first);
+    idx.push_back(vertCount + first + 1);
+    idx.push_back(vertCount + first + 2);
+    idx.push_back(vertCount + first);
+    idx.push_back(vertCount + first + 2);
+    idx.push_back(vertCount + (first + 3) % 4);
     vertCount += 4;
 }
 
-bool Chunk::isTransparent(BlockType bType) {
-    return bType == WATER || bType == ICE;
+bool Chunk::needsTransparentSort(glm::vec3 viewPos) {
+    if (elemCount(TRANSPARENT_INDEX) <= 0) return false;
+    if (m_sortedVersion == m_meshVersion && glm::distance(viewPos, m_sortOrigin) < 1.f) return false;
+    m_sortedVersion = m_meshVersion;
+    m_sortOrigin = viewPos;
+    return true;
+}
+
+const std::vector<glm::vec3>& Chunk::getTransparentCenters() const {
+    return m_transCenters;
+}
+
+const std::vector<GLuint>& Chunk::getTransparentIndices() const {
+    return m_transIdx;
+}
+
+int Chunk::getMeshVersion() const {
+    return m_meshVersion;
+}
+
+const std::vector<glm::vec3>& Chunk::getDecorationOffsets() const {
+    return m_decorationOffsets;
+}
+
+const std::vector<glm::vec4>& Chunk::getDecorationShapes() const {
+    return m_decorationShapes;
+}
+
+void Chunk::setTransparentOrder(const std::vector<GLuint>& idx, int version) {
+    // The chunk was remeshed while the faces were being sorted
+    if (version != m_meshVersion || static_cast<int>(idx.size()) != elemCount(TRANSPARENT_INDEX)) return;
+    bindBuffer(TRANSPARENT_INDEX);
+    mp_context->glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, idx.size() * sizeof(GLuint), idx.data());
 }
 
 glm::ivec2 Chunk::getMin() const {
     return glm::ivec2(minX, minZ);
 }
+
+glm::ivec2 Chunk::getSolidHeights() const {
+    return m_solidHeights;
+}
+
+glm::ivec2 Chunk::getLODRange(int level) const {
+    return glm::ivec2(m_lodOffsets[level - 1], m_lodOffsets[level] - m_lodOffsets[level - 1]);
+}
+
+int Chunk::getMeshLevels() const {
+    return m_meshLevels;
+}
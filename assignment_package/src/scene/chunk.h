@@ -3,33 +3,17 @@
 #include "smartpointerhelp.h"
 #include "glm_includes.h"
 #include "drawable.h"
+#include "block.h"
 #include <array>
+#include <atomic>
 #include <unordered_map>
 #include <cstddef>
+#include <cstdint>
 #include <unordered_set>
 
 
 //using namespace std;
 
-// C++ 11 allows us to define the size of an enum. This lets us use only one byte
-// of memory to store our different block types. By default, the size of a C++ enum
-// is that of an int (so, usually four bytes). This *does* limit us to only 256 different
-// block types, but in the scope of this project we'll never get anywhere near that many.
-enum BlockType : unsigned char
-{
-
-    EMPTY, GRASS, DIRT, STONE, WATER, SNOW, SAND, LAVA, BEDROCK, ICE, SNOW_DIRT, LEAF, WOOD,
-    SNOW_LEAF, SAP, CACTUS, SIDE_WOOD, GRAVEL, SNOW_GRASS_PATCH, DIRT_GRASS_PATCH, COAL, LAPIS,
-    COPPER, GOLD, SAND_CRACK
-
-};
-
-// The six cardinal directions in 3D space
-enum Direction : unsigned char
-{
-    XPOS, XNEG, YPOS, YNEG, ZPOS, ZNEG, DIAG1, DIAG2
-};
-
 // Lets us use any enum class as the key of a
 // std::unordered_map
 struct EnumHash {
@@ -40,10 +24,36 @@ struct EnumHash {
 };
 
 
+// Packs sky and block light levels into the byte stored per block
+inline unsigned char packLight(int sky, int block) {
+    return static_cast<unsigned char>((sky << 4) | block);
+}
+
+// Number of downsampled meshes a chunk can have (2x, 4x and 8x)
+const static int LOD_LEVELS = 3;
+// Which meshes Chunk::generateVBOdata builds, a bit per level: bit 0 for the
+// full detail mesh and bit i for LOD level i. Far chunks only get the levels
+// they can be drawn at, see Terrain::getWantedMeshLevels.
+const static int MESH_FULL = 1;
+const static int MESH_ALL = (1 << (LOD_LEVELS + 1)) - 1;
+
 // Store the VBO data of a chunk in an interleaved fashion
 struct VBOdata {
-    std::vector<glm::vec4> solidData, transData;
-    std::vector<GLuint> solidIdx, transIdx;
+    std::vector<glm::vec4> solidData, transData, lodData, fluidData;
+    std::vector<GLuint> solidIdx, transIdx, lodIdx, fluidIdx;
+    // Lowest and highest block with a solid face, y > x if there are any
+    glm::ivec2 solidHeights;
+    // The center of every quad in transData, used to sort them by depth
+    std::vector<glm::vec3> transCenters;
+    // Where each LOD level's indices start in lodIdx. The last
+    // entry is the total so that level i spans [i, i + 1).
+    std::array<int, LOD_LEVELS + 1> lodOffsets;
+    // The meshes that were built, a MESH_FULL mask
+    int levels;
+    // Foliage standing on the surface, drawn by InstanceRenderer rather than
+    // meshed: the corner of the block each one fills, and its size and layer
+    std::vector<glm::vec3> decorationOffsets;
+    std::vector<glm::vec4> decorationShapes;
 };
 
 struct Vertex {
@@ -76,6 +86,20 @@ class Chunk : public Drawable {
 private:
     // All of the blocks contained within this Chunk
     std::array<BlockType, 65536> m_blocks;
+    // The light of every block, sky light in the high nibble and block light in the low one
+    std::array<unsigned char, 65536> m_light;
+    // A bit per block that isn't EMPTY, kept up to date by setLocalBlockAt. Each
+    // word covers a 4 x 4 x 4 brick, and each 16 x 16 x 16 section has a word
+    // with a bit per brick holding any blocks, so rays cross empty space in big steps.
+    std::array<uint64_t, 1024> m_brickBits;
+    std::array<uint64_t, 16> m_sectionBits;
+    // Set on the main thread once the light has been joined up with the
+    // neighbors, see LightEngine::chunkLit. Until then the chunk counts as
+    // open sky. Meshing threads read it, so it is released after the light.
+    std::atomic<bool> m_lightReady;
+    // Set by Terrain::fillChunk once every block has been generated, released
+    // after the blocks so other threads can tell when they may copy them
+    std::atomic<bool> m_filled;
     // The coordinates of the chunk's lower-left corner in world space
     int minX, minZ;
     // This Chunk's four neighbors to the north, south, east, and west
@@ -85,24 +109,109 @@ private:
     std::unordered_map<Direction, Chunk*, EnumHash> m_neighbors;
 
     VBOdata vboData;
+    // Index ranges of the LOD levels that are currently buffered
+    std::array<int, LOD_LEVELS + 1> m_lodOffsets;
+    // The meshes that are currently buffered, MESH_ALL until the first mesh
+    int m_meshLevels;
+    // vboData.solidHeights of the buffered solid mesh
+    glm::ivec2 m_solidHeights;
+
+    // Builds the 2x, 4x and 8x heightmap meshes used for distant chunks, those
+    // of them in levels. Widens heights to the blocks the meshes span.
+    void generateLODdata(int levels, std::vector<glm::vec4>& lodData, std::vector<GLuint>& lodIdx,
+                         std::array<int, LOD_LEVELS + 1>& lodOffsets, glm::ivec2& heights);
+    // Builds the water surface: tops of water columns and sides facing air
+    void generateFluidData(std::vector<glm::vec4>& fluidData, std::vector<GLuint>& fluidIdx);
+    // Scatters tall grass, flowers and dead bushes over the open surface blocks
+    void generateDecorations(std::vector<glm::vec3>& offsets, std::vector<glm::vec4>& shapes) const;
+    // Looks up a block next to this chunk. Returns false if it lies in a neighbor that isn't loaded.
+    bool getAdjacentBlockAt(int x, int y, int z, BlockType& out) const;
+    // Looks up the packed light next to this chunk. Neighbors that aren't loaded or lit count as open sky.
+    unsigned char getAdjacentLightAt(int x, int y, int z) const;
+    // The packed light baked into the face of the block at x, y, z facing dir
+    unsigned char getFaceLight(int x, int y, int z, Direction dir, BlockType bType) const;
+    // Copies the blocks into an 18 x 258 x 18 grid, bordered by the blocks of the
+    // eight chunks around this one, so meshing never looks across chunks per block
+    void copyPaddedBlocks(std::vector<BlockType>& padded) const;
+    static int paddedIndex(int x, int y, int z);
+    // Ambient occlusion of the four corners of a face, from 0 (darkest) to 3,
+    // counted from the blocks around each corner in the layer the face looks onto
+    static std::array<unsigned char, 4> getFaceAO(const std::vector<BlockType>& padded, int x, int y, int z, Direction dir);
+    // Spreads the light of the queued blocks through the rest of the chunk
+    void floodLight(std::vector<int>& queue, LightChannel channel);
+
+    // Centers of the transparent quads that are currently buffered
+    std::vector<glm::vec3> m_transCenters;
+    // The transparent indices as meshed, six per quad, which keep each quad's chosen diagonal
+    std::vector<GLuint> m_transIdx;
+    // Bumped every time the buffers are replaced so stale sorts can be dropped
+    int m_meshVersion;
+    // The mesh version and view position of the last requested transparent sort
+    int m_sortedVersion;
+    glm::vec3 m_sortOrigin;
+    // vboData's decorations as of the buffered mesh
+    std::vector<glm::vec3> m_decorationOffsets;
+    std::vector<glm::vec4> m_decorationShapes;
 
 public:
     Chunk(int x, int z, OpenGLContext* context);
     BlockType getLocalBlockAt(unsigned int x, unsigned int y, unsigned int z) const;
     BlockType getLocalBlockAt(int x, int y, int z) const;
     void setLocalBlockAt(unsigned int x, unsigned int y, unsigned int z, BlockType t);
+    int getLocalLightAt(int x, int y, int z, LightChannel channel) const;
+    // Where local block x, y, z lies in the occupancy bits: the brick's word,
+    // whose upper bits are its section and lower six its bit in the section's
+    // word, and the block's bit within that word
+    static int brickIndex(int x, int y, int z);
+    static int bitInBrick(int x, int y, int z);
+    uint64_t getBrickBits(int brick) const;
+    uint64_t getSectionBits(int section) const;
+    void setLocalLightAt(int x, int y, int z, LightChannel channel, int level);
+    // Flood fills the sky and block light of the whole chunk from the open sky
+    // and emitting blocks. Only touches this chunk, so it is safe on a worker
+    // thread; the light crossing its borders is left to LightEngine::chunkLit.
+    void computeLight();
+    bool isLightReady() const;
+    void markLightReady();
+    bool isFilled() const;
+    void markFilled();
+    // Copies the blocks between heights minY and maxY into out, x fastest,
+    // then y, then z, as m_blocks stores them
+    void copyBlocks(int minY, int maxY, BlockType *out) const;
     void linkNeighbor(uPtr<Chunk>& neighbor, Direction dir);
     glm::ivec2 getMin() const;
     std::vector<Chunk*> getNeighbors() const;
 
     // Buffers the VBO data in an interleaved fashion
     void createVBOdata() override;
-    // Populates the vboData member of a chunk with the VBO data
-    void generateVBOdata();
-    // Updates the VBO with data of a face of a block
-    void updateVBOdata(std::vector<glm::vec4>& vboData, std::vector<GLuint>& idx, int& vertCount, glm::vec4 blockPos, Direction dir, BlockType bType);
-    // Checks if the block is a transparent block (ie. water)
-    bool isTransparent(BlockType bType);
+    // Populates the vboData member of a chunk with the VBO data of the
+    // meshes in levels, a MESH_FULL mask
+    void generateVBOdata(int levels);
+    // Rebuilds and buffers only the water mesh, leaving the solid and transparent buffers alone
+    void generateFluidVBOdata();
+    void createFluidVBOdata();
+    // Updates the VBO with data of a face of a block. The face can be
+    // stretched over several blocks with scale (used by the LOD meshes).
+    // The packed light and each corner's ambient occlusion are stored in the position's w.
+    void updateVBOdata(std::vector<glm::vec4>& vboData, std::vector<GLuint>& idx, int& vertCount, glm::vec4 blockPos, Direction dir, BlockType bType,
+                       unsigned char light, glm::vec4 scale = glm::vec4(1, 1, 1, 1),
+                       std::array<unsigned char, 4> ao = {3, 3, 3, 3});
+    // Returns the first index and index count of the given LOD level (1 = 2x, 2 = 4x, 3 = 8x)
+    glm::ivec2 getLODRange(int level) const;
+    // The meshes that are currently buffered, a MESH_FULL mask
+    int getMeshLevels() const;
+    // The range of heights the buffered solid mesh spans, used to cull it. Empty if y < x.
+    glm::ivec2 getSolidHeights() const;
+    // Transparent face sorting. needsTransparentSort marks the sort as requested.
+    bool needsTransparentSort(glm::vec3 viewPos);
+    const std::vector<glm::vec3>& getTransparentCenters() const;
+    const std::vector<GLuint>& getTransparentIndices() const;
+    int getMeshVersion() const;
+    // The foliage that goes with the buffered mesh, see VBOdata
+    const std::vector<glm::vec3>& getDecorationOffsets() const;
+    const std::vector<glm::vec4>& getDecorationShapes() const;
+    // Replaces the transparent index buffer with a reordered copy of the same faces
+    void setTransparentOrder(const std::vector<GLuint>& idx, int version);
 
     //0 for grass, 1 for desert, 2 mountain
     int currBiome = -1;
@@ -110,186 +219,38 @@ public:
 };
 
 
+// Vertex UVs are local to one tile of the texture array
 const static std::array<BlockFace, 6> faces = {
     BlockFace(XPOS, glm::ivec3(1, 0, 0),
               Vertex(glm::vec4(1, 0, 1, 1), glm::vec4(0, 0, 0, 0)),
-              Vertex(glm::vec4(1, 0, 0, 1), glm::vec4(0.0625, 0, 0, 0)),
-              Vertex(glm::vec4(1, 1, 0, 1), glm::vec4(0.0625, 0.0625, 0, 0)),
-              Vertex(glm::vec4(1, 1, 1, 1), glm::vec4(0, 0.0625, 0, 0))),
+              Vertex(glm::vec4(1, 0, 0, 1), glm::vec4(1, 0, 0, 0)),
+              Vertex(glm::vec4(1, 1, 0, 1), glm::vec4(1, 1, 0, 0)),
+              Vertex(glm::vec4(1, 1, 1, 1), glm::vec4(0, 1, 0, 0))),
     BlockFace(XNEG, glm::ivec3(-1, 0, 0),
               Vertex(glm::vec4(0, 0, 0, 1), glm::vec4(0, 0, 0, 0)),
-              Vertex(glm::vec4(0, 0, 1, 1), glm::vec4(0.0625, 0, 0, 0)),
-              Vertex(glm::vec4(0, 1, 1, 1), glm::vec4(0.0625, 0.0625, 0, 0)),
-              Vertex(glm::vec4(0, 1, 0, 1), glm::vec4(0, 0.0625, 0, 0))),
+              Vertex(glm::vec4(0, 0, 1, 1), glm::vec4(1, 0, 0, 0)),
+              Vertex(glm::vec4(0, 1, 1, 1), glm::vec4(1, 1, 0, 0)),
+              Vertex(glm::vec4(0, 1, 0, 1), glm::vec4(0, 1, 0, 0))),
     BlockFace(YPOS, glm::ivec3(0, 1, 0),
               Vertex(glm::vec4(0, 1, 1, 1), glm::vec4(0, 0, 0, 0)),
-              Vertex(glm::vec4(1, 1, 1, 1), glm::vec4(0.0625, 0, 0, 0)),
-              Vertex(glm::vec4(1, 1, 0, 1), glm::vec4(0.0625, 0.0625, 0, 0)),
-              Vertex(glm::vec4(0, 1, 0, 1), glm::vec4(0, 0.0625, 0, 0))),
+              Vertex(glm::vec4(1, 1, 1, 1), glm::vec4(1, 0, 0, 0)),
+              Vertex(glm::vec4(1, 1, 0, 1), glm::vec4(1, 1, 0, 0)),
+              Vertex(glm::vec4(0, 1, 0, 1), glm::vec4(0, 1, 0, 0))),
     BlockFace(YNEG, glm::ivec3(0, -1, 0),
               Vertex(glm::vec4(0, 0, 0, 1), glm::vec4(0, 0, 0, 0)),
-              Vertex(glm::vec4(1, 0, 0, 1), glm::vec4(0.0625, 0, 0, 0)),
-              Vertex(glm::vec4(1, 0, 1, 1), glm::vec4(0.0625, 0.0625, 0, 0)),
-              Vertex(glm::vec4(0, 0, 1, 1), glm::vec4(0, 0.0625, 0, 0))),
+              Vertex(glm::vec4(1, 0, 0, 1), glm::vec4(1, 0, 0, 0)),
+              Vertex(glm::vec4(1, 0, 1, 1), glm::vec4(1, 1, 0, 0)),
+              Vertex(glm::vec4(0, 0, 1, 1), glm::vec4(0, 1, 0, 0))),
     BlockFace(ZPOS, glm::ivec3(0, 0, 1),
               Vertex(glm::vec4(0, 0, 1, 1), glm::vec4(0, 0, 0, 0)),
-              Vertex(glm::vec4(1, 0, 1, 1), glm::vec4(0.0625, 0, 0, 0)),
-              Vertex(glm::vec4(1, 1, 1, 1), glm::vec4(0.0625, 0.0625, 0, 0)),
-              Vertex(glm::vec4(0, 1, 1, 1), glm::vec4(0, 0.0625, 0, 0))),
+              Vertex(glm::vec4(1, 0, 1, 1), glm::vec4(1, 0, 0, 0)),
+              Vertex(glm::vec4(1, 1, 1, 1), glm::vec4(1, 1, 0, 0)),
+              Vertex(glm::vec4(0, 1, 1, 1), glm::vec4(0, 1, 0, 0))),
     BlockFace(ZNEG, glm::ivec3(0, 0, -1),
               Vertex(glm::vec4(1, 0, 0, 1), glm::vec4(0, 0, 0, 0)),
-              Vertex(glm::vec4(0, 0, 0, 1), glm::vec4(0.0625, 0, 0, 0)),
-              Vertex(glm::vec4(0, 1, 0, 1), glm::vec4(0.0625, 0.0625, 0, 0)),
-              Vertex(glm::vec4(1, 1, 0, 1), glm::vec4(0, 0.0625, 0, 0)))
+              Vertex(glm::vec4(0, 0, 0, 1), glm::vec4(1, 0, 0, 0)),
+              Vertex(glm::vec4(0, 1, 0, 1), glm::vec4(1, 1, 0, 0)),
+              Vertex(glm::vec4(1, 1, 0, 1), glm::vec4(0, 1, 0, 0)))
 };
 
-const static std::unordered_map<BlockType, std::unordered_map<Direction, glm::vec4, EnumHash>, EnumHash> blockUVs {
-    {GRASS, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {XNEG, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(8.f/16.f, 13.f/16.f, 0, 0)},
-                                                               {YNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZPOS, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)}}},
-
-    {DIRT, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)}}},
-
-    {STONE, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(1.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {XNEG, glm::vec4(1.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(1.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {YNEG, glm::vec4(1.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZPOS, glm::vec4(1.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(1.f/16.f, 15.f/16.f, 0, 0)}}},
-
-    {WATER, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(13.f/16.f, 3.f/16.f, 0, 0)},
-                                                               {XNEG, glm::vec4(13.f/16.f, 3.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(13.f/16.f, 3.f/16.f, 0, 1)},
-                                                               {YNEG, glm::vec4(13.f/16.f, 3.f/16.f, 0, 0)},
-                                                               {ZPOS, glm::vec4(13.f/16.f, 3.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(13.f/16.f, 3.f/16.f, 0, 0)}}},
-
-    {SNOW, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)}}},
-
-    {SAND, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)}}},
-
-    {LAVA, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(13.f/16.f, 1.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(13.f/16.f, 1.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(13.f/16.f, 1.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(13.f/16.f, 1.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(13.f/16.f, 1.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(13.f/16.f, 1.f/16.f, 0, 0)}}},
-
-    {BEDROCK, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(1.f/16.f, 14.f/16.f, 0, 0)},
-                                                                 {XNEG, glm::vec4(1.f/16.f, 14.f/16.f, 0, 0)},
-                                                                 {YPOS, glm::vec4(1.f/16.f, 14.f/16.f, 0, 0)},
-                                                                 {YNEG, glm::vec4(1.f/16.f, 14.f/16.f, 0, 0)},
-                                                                 {ZPOS, glm::vec4(1.f/16.f, 14.f/16.f, 0, 0)},
-                                                                 {ZNEG, glm::vec4(1.f/16.f, 14.f/16.f, 0, 0)}}},
-    {ICE, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(3.f/16.f, 11.f/16.f, 0, 0)},
-                                                             {XNEG, glm::vec4(3.f/16.f, 11.f/16.f, 0, 0)},
-                                                             {YPOS, glm::vec4(3.f/16.f, 11.f/16.f, 0, 0)},
-                                                             {YNEG, glm::vec4(3.f/16.f, 11.f/16.f, 0, 0)},
-                                                             {ZPOS, glm::vec4(3.f/16.f, 11.f/16.f, 0, 0)},
-                                                             {ZNEG, glm::vec4(3.f/16.f, 11.f/16.f, 0, 0)}}},
-    {SNOW_DIRT, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(4.f/16.f, 11.f/16.f, 0, 0)},
-                                                                   {XNEG, glm::vec4(4.f/16.f, 11.f/16.f, 0, 0)},
-                                                                   {YPOS, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                                   {YNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                                   {ZPOS, glm::vec4(4.f/16.f, 11.f/16.f, 0, 0)},
-                                                                   {ZNEG, glm::vec4(4.f/16.f, 11.f/16.f, 0, 0)}}},
-    {LEAF, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)}}},
-
-    {WOOD, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(5.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(5.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)}}},
-    {SIDE_WOOD, std::unordered_map<Direction, glm::vec4, EnumHash>{  {XPOS, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(4.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(5.f/16.f, 14.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(5.f/16.f, 14.f/16.f, 0, 0)}}},
-    {SNOW_LEAF, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(2.f/16.f, 11.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(5.f/16.f, 12.f/16.f, 0, 0)}}},
-    {CACTUS, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(6.f/16.f, 11.f/16.f, 0, 3)},
-                                                              {XNEG, glm::vec4(6.f/16.f, 11.f/16.f, 0, -3)},
-                                                              {YPOS, glm::vec4(5.f/16.f, 11.f/16.f, 0, 2)},
-                                                              {YNEG, glm::vec4(5.f/16.f, 11.f/16.f, 0, -2)},
-                                                              {ZPOS, glm::vec4(6.f/16.f, 11.f/16.f, 0, 4)},
-                                                              {ZNEG, glm::vec4(6.f/16.f, 11.f/16.f, 0, -4)}}},
-    {GRAVEL, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(0.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {XNEG, glm::vec4(0.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(0.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {YNEG, glm::vec4(0.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZPOS, glm::vec4(0.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(0.f/16.f, 15.f/16.f, 0, 0)}}},
-    {SNOW_GRASS_PATCH, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {XNEG, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(1.f/16.f, 6.f/16.f, 0, -7)},
-                                                               {YNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZPOS, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)}}},
-    {DIRT_GRASS_PATCH, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                                          {XNEG, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                                          {YPOS, glm::vec4(2.f/16.f, 5.f/16.f, 0, -8)},
-                                                                          {YNEG, glm::vec4(2.f/16.f, 15.f/16.f, 0, 0)},
-                                                                          {ZPOS, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)},
-                                                                          {ZNEG, glm::vec4(3.f/16.f, 15.f/16.f, 0, 0)}}},
-    {COAL, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(2.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {XNEG, glm::vec4(2.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {YPOS, glm::vec4(2.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {YNEG, glm::vec4(2.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {ZPOS, glm::vec4(2.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {ZNEG, glm::vec4(2.f/16.f, 13.f/16.f, 0, 0)}}},
-    {LAPIS, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(0.f/16.f, 5.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(0.f/16.f, 5.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(0.f/16.f, 5.f/16.f, 0, 0)},
-                                                              {YNEG, glm::vec4(0.f/16.f, 5.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(0.f/16.f, 5.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(0.f/16.f, 5.f/16.f, 0, 0)}}},
-    {COPPER, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(1.f/16.f, 13.f/16.f, 0, 0)},
-                                                               {XNEG, glm::vec4(1.f/16.f, 13.f/16.f, 0, 0)},
-                                                               {YPOS, glm::vec4(1.f/16.f, 13.f/16.f, 0, 0)},
-                                                               {YNEG, glm::vec4(1.f/16.f, 13.f/16.f, 0, 0)},
-                                                               {ZPOS, glm::vec4(1.f/16.f, 13.f/16.f, 0, 0)},
-                                                               {ZNEG, glm::vec4(1.f/16.f, 13.f/16.f, 0, 0)}}},
-    {GOLD, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(0.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {XNEG, glm::vec4(0.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {YPOS, glm::vec4(0.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {YNEG, glm::vec4(0.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {ZPOS, glm::vec4(0.f/16.f, 13.f/16.f, 0, 0)},
-                                                                {ZNEG, glm::vec4(0.f/16.f, 13.f/16.f, 0, 0)}}},
-    {SAND_CRACK, std::unordered_map<Direction, glm::vec4, EnumHash>{{XPOS, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {XNEG, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {YPOS, glm::vec4(0.f/16.f, 2.f/16.f, 0, -9)},
-                                                              {YNEG, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZPOS, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)},
-                                                              {ZNEG, glm::vec4(2.f/16.f, 14.f/16.f, 0, 0)}}},
-
-    };
 
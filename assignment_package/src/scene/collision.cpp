@@ -0,0 +1,233 @@
+#include "collision.h"
+#include <vector>
+
+// A box stops this far short of the faces it runs into, so it never starts the next sweep inside one
+const static float skin = 0.001f;
+
+BlockSnapshot::BlockSnapshot()
+    : m_minY(0), m_maxY(-1), m_slabs(), m_blocks()
+{}
+
+void BlockSnapshot::reset(int minY, int maxY) {
+    m_minY = glm::max(0, minY);
+    m_maxY = glm::min(255, maxY);
+    m_slabs.clear();
+    m_blocks.clear();
+}
+
+void BlockSnapshot::addChunk(const Terrain &terrain, int x, int z) {
+    int chunkX = x & ~15, chunkZ = z & ~15;
+    int64_t key = toKey(chunkX, chunkZ);
+    if (m_maxY < m_minY || m_slabs.find(key) != m_slabs.end() || !terrain.hasChunkAt(x, z)) {
+        return;
+    }
+    const Chunk *chunk = terrain.getChunkAt(x, z).get();
+    if (!chunk->isFilled()) {
+        return;
+    }
+    size_t start = m_blocks.size();
+    m_blocks.resize(start + 16 * 16 * (m_maxY - m_minY + 1));
+    chunk->copyBlocks(m_minY, m_maxY, m_blocks.data() + start);
+    m_slabs[key] = start;
+}
+
+const BlockType* BlockSnapshot::getSlab(int x, int z) const {
+    auto slab = m_slabs.find(toKey(x & ~15, z & ~15));
+    return slab == m_slabs.end() ? nullptr : m_blocks.data() + slab->second;
+}
+
+int BlockSnapshot::getMinY() const {
+    return m_minY;
+}
+
+int BlockSnapshot::getMaxY() const {
+    return m_maxY;
+}
+
+size_t BlockSnapshot::getChunkCount() const {
+    return m_slabs.size();
+}
+
+ChunkView::ChunkView(const Terrain &terrain)
+    : mp_terrain(&terrain), mp_snapshot(nullptr), m_cached(false), m_chunkX(0), m_chunkZ(0),
+      mp_chunk(nullptr), mp_slab(nullptr)
+{}
+
+ChunkView::ChunkView(const BlockSnapshot &snapshot)
+    : mp_terrain(nullptr), mp_snapshot(&snapshot), m_cached(false), m_chunkX(0), m_chunkZ(0),
+      mp_chunk(nullptr), mp_slab(nullptr)
+{}
+
+const Chunk* ChunkView::getChunk(int x, int z) {
+    // Rounds down to a multiple of 16, negative coordinates included
+    int chunkX = x & ~15;
+    int chunkZ = z & ~15;
+    if (!m_cached || chunkX != m_chunkX || chunkZ != m_chunkZ) {
+        m_cached = true;
+        m_chunkX = chunkX;
+        m_chunkZ = chunkZ;
+        if (mp_snapshot) {
+            mp_slab = mp_snapshot->getSlab(x, z);
+        } else {
+            mp_chunk = mp_terrain->hasChunkAt(x, z) ? mp_terrain->getChunkAt(x, z).get() : nullptr;
+        }
+    }
+    return mp_chunk;
+}
+
+BlockType ChunkView::getBlockAt(int x, int y, int z) {
+    if (y < 0 || y >= 256) {
+        return EMPTY;
+    }
+    if (mp_snapshot) {
+        getChunk(x, z);
+        int minY = mp_snapshot->getMinY(), height = mp_snapshot->getMaxY() - minY + 1;
+        if (!mp_slab || y < minY || y >= minY + height) {
+            return EMPTY;
+        }
+        return mp_slab[(x - m_chunkX) + 16 * (y - minY) + 16 * height * (z - m_chunkZ)];
+    }
+    const Chunk *chunk = getChunk(x, z);
+    if (!chunk) {
+        return EMPTY;
+    }
+    return chunk->getLocalBlockAt(x - m_chunkX, y, z - m_chunkZ);
+}
+
+SweepResult sweepBox(ChunkView &view, const AABB &box, glm::vec3 displacement) {
+    // Every block the box overlaps anywhere along the movement
+    glm::ivec3 first = glm::ivec3(glm::floor(glm::min(box.min, box.min + displacement)));
+    glm::ivec3 last = glm::ivec3(glm::floor(glm::max(box.max, box.max + displacement)));
+    std::vector<glm::ivec3> solids, water, lava;
+    for (int x = first.x; x <= last.x; ++x) {
+        for (int z = first.z; z <= last.z; ++z) {
+            for (int y = first.y; y <= last.y; ++y) {
+                BlockType t = view.getBlockAt(x, y, z);
+                if (blockInfo(t).solid) {
+                    solids.push_back(glm::ivec3(x, y, z));
+                } else if (t == WATER) {
+                    water.push_back(glm::ivec3(x, y, z));
+                } else if (t == LAVA) {
+                    lava.push_back(glm::ivec3(x, y, z));
+                }
+            }
+        }
+    }
+
+    SweepResult result{glm::vec3(0.f), glm::bvec3(false), false, false};
+    AABB moved = box;
+    for (int axis : {1, 0, 2}) {
+        float d = displacement[axis];
+        if (d == 0.f) {
+            continue;
+        }
+        int a = (axis + 1) % 3, b = (axis + 2) % 3;
+        for (const glm::ivec3 &block : solids) {
+            // Only blocks the box overlaps on the other two axes are in the way
+            if (block[a] + 1 <= moved.min[a] || block[a] >= moved.max[a] ||
+                block[b] + 1 <= moved.min[b] || block[b] >= moved.max[b]) {
+                continue;
+            }
+            if (d > 0.f && block[axis] >= moved.max[axis] - skin) {
+                d = glm::min(d, glm::max(0.f, block[axis] - moved.max[axis] - skin));
+            } else if (d < 0.f && block[axis] + 1 <= moved.min[axis] + skin) {
+                d = glm::max(d, glm::min(0.f, block[axis] + 1 - moved.min[axis] + skin));
+            }
+        }
+        result.blocked[axis] = d != displacement[axis];
+        result.displacement[axis] = d;
+        moved.min[axis] += d;
+        moved.max[axis] += d;
+    }
+
+    auto overlaps = [&moved](const glm::ivec3 &block) {
+        return block.x + 1 > moved.min.x && block.x < moved.max.x &&
+               block.y + 1 > moved.min.y && block.y < moved.max.y &&
+               block.z + 1 > moved.min.z && block.z < moved.max.z;
+    };
+    for (const glm::ivec3 &block : water) {
+        result.inWater = result.inWater || overlaps(block);
+    }
+    for (const glm::ivec3 &block : lava) {
+        result.inLava = result.inLava || overlaps(block);
+    }
+    return result;
+}
+
+bool raycastBlocks(ChunkView &view, glm::vec3 origin, glm::vec3 direction, float maxDist, RayHit *hit) {
+    // Stands in for no bound at all on an axis, still within an int
+    const float unbounded = 1e9f;
+    glm::vec3 dir = glm::normalize(direction);
+    glm::ivec3 cell = glm::ivec3(glm::floor(origin));
+    float t = 0.f;
+    bool first = true;
+    while (t < maxDist) {
+        // The largest box around cell known to be empty: a Chunk that isn't
+        // loaded, the air above or below the world, an empty section or brick,
+        // or just cell if it isn't in any of those
+        glm::ivec3 corner(cell.x & ~15, 0, cell.z & ~15);
+        glm::vec3 boxMin, boxMax;
+        const Chunk *chunk = view.getChunk(cell.x, cell.z);
+        bool occupied = false;
+        if (!chunk || cell.y < 0 || cell.y >= 256) {
+            boxMin = glm::vec3(corner.x, -unbounded, corner.z);
+            boxMax = glm::vec3(corner.x + 16, unbounded, corner.z + 16);
+            if (chunk) {
+                boxMin.y = cell.y < 0 ? -unbounded : 256.f;
+                boxMax.y = cell.y < 0 ? 0.f : unbounded;
+            }
+        } else {
+            glm::ivec3 local = cell - corner;
+            int brick = Chunk::brickIndex(local.x, local.y, local.z);
+            uint64_t bits = chunk->getBrickBits(brick);
+            glm::ivec3 boxCorner = cell;
+            int size = 1;
+            if (chunk->getSectionBits(brick >> 6) == 0) {
+                boxCorner = corner + glm::ivec3(0, local.y & ~15, 0);
+                size = 16;
+            } else if (bits == 0) {
+                boxCorner = glm::ivec3(cell.x & ~3, cell.y & ~3, cell.z & ~3);
+                size = 4;
+            } else {
+                occupied = (bits >> Chunk::bitInBrick(local.x, local.y, local.z)) & 1;
+            }
+            boxMin = glm::vec3(boxCorner);
+            boxMax = glm::vec3(boxCorner + size);
+        }
+        if (occupied && !first) {
+            hit->block = cell;
+            hit->distance = t;
+            return true;
+        }
+        first = false;
+
+        // Leave the box through whichever face the ray reaches first
+        float exitT = unbounded;
+        int axis = -1;
+        for (int i = 0; i < 3; ++i) {
+            if (dir[i] != 0.f) {
+                float bound = dir[i] > 0.f ? boxMax[i] : boxMin[i];
+                float axisT = (bound - origin[i]) / dir[i];
+                if (axisT < exitT) {
+                    exitT = axisT;
+                    axis = i;
+                }
+            }
+        }
+        if (axis == -1) {
+            return false;
+        }
+        t = glm::max(t, exitT);
+        // The cell just past that face. The other axes are kept inside the box,
+        // which the position rounded from t can stray out of.
+        glm::vec3 p = origin + dir * t;
+        for (int i = 0; i < 3; ++i) {
+            if (i == axis) {
+                cell[i] = dir[i] > 0.f ? static_cast<int>(boxMax[i]) : static_cast<int>(boxMin[i]) - 1;
+            } else {
+                cell[i] = glm::clamp(static_cast<int>(glm::floor(p[i])), static_cast<int>(boxMin[i]), static_cast<int>(boxMax[i]) - 1);
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "terrain.h"
+
+// A copy of the blocks of some Chunks between two heights, so worker
+// threads can read them while the Terrain's Chunks go on changing.
+class BlockSnapshot {
+private:
+    int m_minY, m_maxY;
+    // Where the blocks of each copied Chunk start in m_blocks, by Chunk key
+    std::unordered_map<int64_t, size_t> m_slabs;
+    std::vector<BlockType> m_blocks;
+
+public:
+    BlockSnapshot();
+
+    // Drops every copied Chunk. Later ones are copied between minY and maxY.
+    void reset(int minY, int maxY);
+    // Copies the Chunk holding world column x, z unless it already is, isn't
+    // loaded or is still being filled. Main thread only.
+    void addChunk(const Terrain &terrain, int x, int z);
+    // The copied blocks of the Chunk holding world column x, z, laid out
+    // like Chunk::copyBlocks, or nullptr if it wasn't copied
+    const BlockType* getSlab(int x, int z) const;
+    int getMinY() const;
+    int getMaxY() const;
+    size_t getChunkCount() const;
+};
+
+// Reads blocks from the Terrain, or from a BlockSnapshot of it, by world
+// position, remembering the last Chunk it looked up so runs of nearby reads
+// skip the chunk map. Blocks in Chunks that aren't loaded or copied, and
+// above or below the world or the snapshot, read as EMPTY.
+class ChunkView {
+private:
+    const Terrain *mp_terrain;        // nullptr when reading a snapshot
+    const BlockSnapshot *mp_snapshot; // nullptr when reading the Terrain
+    bool m_cached;
+    int m_chunkX, m_chunkZ; // Corner of the cached Chunk
+    const Chunk *mp_chunk;  // nullptr if that Chunk isn't loaded
+    const BlockType *mp_slab; // The cached Chunk's blocks in the snapshot
+
+public:
+    ChunkView(const Terrain &terrain);
+    ChunkView(const BlockSnapshot &snapshot);
+
+    BlockType getBlockAt(int x, int y, int z);
+    // The Chunk holding world column x, z, nullptr if it isn't loaded.
+    // Always nullptr when reading a snapshot.
+    const Chunk* getChunk(int x, int z);
+};
+
+// An axis-aligned box in world space
+struct AABB {
+    glm::vec3 min, max;
+};
+
+// Where sweepBox let a box go
+struct SweepResult {
+    glm::vec3 displacement; // How far the box can move without entering a solid block
+    glm::bvec3 blocked;     // The axes on which a solid block cut the movement short
+    bool inWater, inLava;   // Whether the box overlaps water or lava once moved
+};
+
+// Moves box by displacement through the voxel grid one axis at a time, in
+// the order Y, X, Z, stopping each axis just short of the first solid block
+// in its way. The blocks the whole movement can touch are read once up front.
+SweepResult sweepBox(ChunkView &view, const AABB &box, glm::vec3 displacement);
+
+// The block a ray ran into
+struct RayHit {
+    glm::ivec3 block;
+    float distance; // Along the ray to where it enters the block
+};
+
+// Finds the first block other than EMPTY that a ray enters within maxDist
+// blocks of origin, not counting the one it starts in. Empty sections and
+// bricks of the Chunks' occupancy bits, and Chunks that aren't loaded, are
+// crossed in one step, so long rays cost little more than short ones.
+bool raycastBlocks(ChunkView &view, glm::vec3 origin, glm::vec3 direction, float maxDist, RayHit *hit);
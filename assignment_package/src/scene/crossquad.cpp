@@ -0,0 +1,60 @@
+#include "crossquad.h"
+
+static const int CROSS_IDX_COUNT = 12;
+static const int CROSS_VERT_COUNT = 8;
+
+void CrossQuad::createVBOdata()
+{
+    glm::vec4 pos[CROSS_VERT_COUNT] = {
+        // From the (0, 0) corner to the (1, 1) one
+        glm::vec4(0, 0, 0, 1), glm::vec4(1, 0, 1, 1), glm::vec4(1, 1, 1, 1), glm::vec4(0, 1, 0, 1),
+        // From the (1, 0) corner to the (0, 1) one
+        glm::vec4(1, 0, 0, 1), glm::vec4(0, 0, 1, 1), glm::vec4(0, 1, 1, 1), glm::vec4(1, 1, 0, 1)
+    };
+    glm::vec4 nor[CROSS_VERT_COUNT];
+    glm::vec4 uv[CROSS_VERT_COUNT];
+    GLuint idx[CROSS_IDX_COUNT];
+    for (int q = 0; q < 2; ++q) {
+        for (int i = 0; i < 4; ++i) {
+            nor[q * 4 + i] = glm::vec4(0, 1, 0, 0);
+        }
+        uv[q * 4] = glm::vec4(0, 0, 0, 0);
+        uv[q * 4 + 1] = glm::vec4(1, 0, 0, 0);
+        uv[q * 4 + 2] = glm::vec4(1, 1, 0, 0);
+        uv[q * 4 + 3] = glm::vec4(0, 1, 0, 0);
+        GLuint quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int i = 0; i < 6; ++i) {
+            idx[q * 6 + i] = q * 4 + quad[i];
+        }
+    }
+
+    indexCounts[INDEX] = CROSS_IDX_COUNT;
+
+    generateBuffer(INDEX);
+    bindBuffer(INDEX);
+    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, CROSS_IDX_COUNT * sizeof(GLuint), idx, GL_STATIC_DRAW);
+
+    generateBuffer(POSITION);
+    bindBuffer(POSITION);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, CROSS_VERT_COUNT * sizeof(glm::vec4), pos, GL_STATIC_DRAW);
+
+    generateBuffer(NORMAL);
+    bindBuffer(NORMAL);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, CROSS_VERT_COUNT * sizeof(glm::vec4), nor, GL_STATIC_DRAW);
+
+    generateBuffer(UV);
+    bindBuffer(UV);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, CROSS_VERT_COUNT * sizeof(glm::vec4), uv, GL_STATIC_DRAW);
+}
+
+void CrossQuad::createInstancedVBOdata(std::vector<glm::vec3> &offsets, std::vector<glm::vec3> &colors) {
+    m_numInstances = offsets.size();
+
+    generateBuffer(INSTANCED_OFFSET);
+    bindBuffer(INSTANCED_OFFSET);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(glm::vec3), offsets.data(), GL_STATIC_DRAW);
+
+    generateBuffer(COLOR);
+    bindBuffer(COLOR);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW);
+}
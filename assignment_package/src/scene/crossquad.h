@@ -0,0 +1,16 @@
+#pragma once
+
+#include "drawable.h"
+#include <glm_includes.h>
+
+// Two quads crossing along the diagonals of a unit block, the shape of tall
+// grass and flowers. Drawn double sided with the tile's transparent texels
+// discarded, and lit as if facing up so both sides match the ground.
+class CrossQuad : public InstancedDrawable
+{
+public:
+    CrossQuad(OpenGLContext* context) : InstancedDrawable(context){}
+    virtual ~CrossQuad(){}
+    void createVBOdata() override;
+    void createInstancedVBOdata(std::vector<glm::vec3> &offsets, std::vector<glm::vec3> &colors) override;
+};
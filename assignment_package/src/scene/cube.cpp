@@ -117,6 +117,18 @@ void createCubeVertexNormals(glm::vec4 (&cub_vert_nor)[CUB_VERT_COUNT])
     }
 }
 
+// Every face lists its corners UR, LR, LL, UL, so each shows its whole tile
+void createCubeVertexUVs(glm::vec4 (&cub_vert_uv)[CUB_VERT_COUNT])
+{
+    int idx = 0;
+    for(int i = 0; i < 6; i++){
+        cub_vert_uv[idx++] = glm::vec4(1,1,0,0);
+        cub_vert_uv[idx++] = glm::vec4(1,0,0,0);
+        cub_vert_uv[idx++] = glm::vec4(0,0,0,0);
+        cub_vert_uv[idx++] = glm::vec4(0,1,0,0);
+    }
+}
+
 void createCubeIndices(GLuint (&cub_idx)[CUB_IDX_COUNT])
 {
     int idx = 0;
@@ -135,9 +147,11 @@ void Cube::createVBOdata()
     GLuint sph_idx[CUB_IDX_COUNT];
     glm::vec4 sph_vert_pos[CUB_VERT_COUNT];
     glm::vec4 sph_vert_nor[CUB_VERT_COUNT];
+    glm::vec4 sph_vert_uv[CUB_VERT_COUNT];
 
     createCubeVertexPositions(sph_vert_pos);
     createCubeVertexNormals(sph_vert_nor);
+    createCubeVertexUVs(sph_vert_uv);
     createCubeIndices(sph_idx);
 
     indexCounts[INDEX] = CUB_IDX_COUNT;
@@ -159,6 +173,9 @@ void Cube::createVBOdata()
     bindBuffer(NORMAL);
     mp_context->glBufferData(GL_ARRAY_BUFFER, CUB_VERT_COUNT * sizeof(glm::vec4), sph_vert_nor, GL_STATIC_DRAW);
 
+    generateBuffer(UV);
+    bindBuffer(UV);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, CUB_VERT_COUNT * sizeof(glm::vec4), sph_vert_uv, GL_STATIC_DRAW);
 }
 
 
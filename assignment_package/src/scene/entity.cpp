@@ -26,6 +26,13 @@ glm::vec3 Entity::F() const {
     return m_forward;
 }
 
+void Entity::setPose(glm::vec3 pos, glm::vec3 forward, glm::vec3 right, glm::vec3 up) {
+    m_position = pos;
+    m_forward = forward;
+    m_right = right;
+    m_up = up;
+}
+
 void Entity::moveAlongVector(glm::vec3 dir) {
     m_position += dir;
 }
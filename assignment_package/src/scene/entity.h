@@ -34,6 +34,9 @@ public:
     glm::vec3 U() const;
     glm::vec3 F() const;
 
+    // Places the entity and its local axes directly
+    void setPose(glm::vec3 pos, glm::vec3 forward, glm::vec3 right, glm::vec3 up);
+
     // To be called by MyGL::tick()
     virtual void tick(float dT, InputBundle &input) = 0;
 
@@ -0,0 +1,191 @@
+#include "entitysystem.h"
+#include "collision.h"
+#include "entityworker.h"
+#include "profiler.h"
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+
+// Blocks per second squared
+const static float gravity = 25.f;
+// Upward speed of a hop, enough to clear one block
+const static float hopSpeed = 8.f;
+// Furthest the boxes an entity overlaps can push it in one step
+const static float maxPush = 0.5f;
+
+EntitySystem::EntitySystem()
+    : m_positions(), m_prevPositions(), m_velocities(), m_halfExtents(), m_layers(),
+      m_nextPositions(), m_nextVelocities(),
+      m_hash(CELL_SIZE), m_snapshot(), m_pool(), m_lastStepMs(0.f)
+{
+    // The thread calling step takes a share too
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+int EntitySystem::spawn(glm::vec3 position, glm::vec3 velocity, glm::vec3 halfExtents, float layer) {
+    m_positions.push_back(position);
+    m_prevPositions.push_back(position);
+    m_velocities.push_back(velocity);
+    m_halfExtents.push_back(halfExtents);
+    m_layers.push_back(layer);
+    return m_positions.size() - 1;
+}
+
+void EntitySystem::clear() {
+    m_positions.clear();
+    m_prevPositions.clear();
+    m_velocities.clear();
+    m_halfExtents.clear();
+    m_layers.clear();
+}
+
+size_t EntitySystem::size() const {
+    return m_positions.size();
+}
+
+void EntitySystem::step(float dt, const Terrain &terrain) {
+    PROFILE_SCOPE("entities");
+    int64_t start = Profiler::now();
+    int count = m_positions.size();
+    if (count == 0) {
+        m_lastStepMs = 0.f;
+        return;
+    }
+    m_hash.build(m_positions);
+    takeSnapshot(dt, terrain);
+    m_nextPositions.resize(count);
+    m_nextVelocities.resize(count);
+
+    int workers = std::max(1, std::min(count / MIN_PER_WORKER, m_pool.maxThreadCount() + 1));
+    int share = (count + workers - 1) / workers;
+    QSemaphore done;
+    for (int w = 1; w < workers; ++w) {
+        int begin = std::min(count, w * share);
+        m_pool.start(new EntityWorker(this, begin, std::min(count, begin + share), dt, &done));
+    }
+    stepRange(0, std::min(count, share), dt);
+    done.acquire(workers - 1);
+
+    m_prevPositions.swap(m_positions);
+    m_positions.swap(m_nextPositions);
+    m_velocities.swap(m_nextVelocities);
+    m_lastStepMs = (Profiler::now() - start) / 1e6f;
+}
+
+void EntitySystem::takeSnapshot(float dt, const Terrain &terrain) {
+    PROFILE_SCOPE("entity snapshot");
+    // A box can move by its speed plus maxPush, so a little over that covers
+    // the blocks its sweep reads
+    const float slack = maxPush + 1.f;
+    glm::vec3 lo(1e9f), hi(-1e9f);
+    for (size_t i = 0; i < m_positions.size(); ++i) {
+        glm::vec3 reach = glm::abs(m_velocities[i]) * dt + m_halfExtents[i] + slack;
+        lo = glm::min(lo, m_positions[i] - reach);
+        hi = glm::max(hi, m_positions[i] + reach + glm::vec3(0.f, m_halfExtents[i].y, 0.f));
+    }
+    m_snapshot.reset(static_cast<int>(glm::floor(lo.y)), static_cast<int>(glm::floor(hi.y)));
+    // Only the Chunks some entity can reach, not the whole box around them all
+    for (size_t i = 0; i < m_positions.size(); ++i) {
+        glm::vec3 reach = glm::abs(m_velocities[i]) * dt + m_halfExtents[i] + slack;
+        glm::ivec3 first = glm::ivec3(glm::floor(m_positions[i] - reach));
+        glm::ivec3 last = glm::ivec3(glm::floor(m_positions[i] + reach));
+        for (int x = first.x & ~15; x <= last.x; x += 16) {
+            for (int z = first.z & ~15; z <= last.z; z += 16) {
+                m_snapshot.addChunk(terrain, x, z);
+            }
+        }
+    }
+}
+
+bool EntitySystem::isInSnapshot(glm::vec3 pos, glm::vec3 half) const {
+    // A box is smaller than a Chunk, so its corners find every Chunk it is in
+    for (float dx : {-half.x, half.x}) {
+        for (float dz : {-half.z, half.z}) {
+            int x = static_cast<int>(glm::floor(pos.x + dx));
+            int z = static_cast<int>(glm::floor(pos.z + dz));
+            if (!m_snapshot.getSlab(x, z)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void EntitySystem::stepRange(int begin, int end, float dt) {
+    ChunkView view(m_snapshot);
+    for (int i = begin; i < end; ++i) {
+        glm::vec3 pos = m_positions[i];
+        glm::vec3 vel = m_velocities[i];
+        glm::vec3 half = m_halfExtents[i];
+        // The snapshot has no blocks where Chunks aren't loaded or filled yet, so
+        // an entity there would fall forever. It waits in place for them instead.
+        if (!isInSnapshot(pos, half)) {
+            m_nextPositions[i] = pos;
+            m_nextVelocities[i] = vel;
+            continue;
+        }
+        vel.y -= gravity * dt;
+
+        // Step out of the entities this one overlaps, half way since they step out too
+        glm::vec3 push(0.f);
+        m_hash.forNeighbors(pos, [&](int j) {
+            if (j == i) {
+                return;
+            }
+            glm::vec3 other = m_positions[j];
+            glm::vec3 reach = half + m_halfExtents[j];
+            glm::vec3 d = pos - other;
+            float overlapX = reach.x - std::abs(d.x);
+            float overlapZ = reach.z - std::abs(d.z);
+            float overlapY = std::min(pos.y + 2.f * half.y, other.y + 2.f * m_halfExtents[j].y) - std::max(pos.y, other.y);
+            if (overlapX <= 0.f || overlapZ <= 0.f || overlapY <= 0.f) {
+                return;
+            }
+            // Entities at the same spot are told apart by index
+            float side = i < j ? -1.f : 1.f;
+            if (overlapX < overlapZ) {
+                push.x += 0.5f * overlapX * (d.x != 0.f ? glm::sign(d.x) : side);
+            } else {
+                push.z += 0.5f * overlapZ * (d.z != 0.f ? glm::sign(d.z) : side);
+            }
+        });
+
+        // However crowded it gets, a box is pushed at most half a block a step,
+        // which keeps it inside the blocks takeSnapshot copied
+        push = glm::clamp(push, glm::vec3(-maxPush), glm::vec3(maxPush));
+        glm::vec3 displacement = vel * dt + push;
+        AABB box{pos - glm::vec3(half.x, 0.f, half.z), pos + glm::vec3(half.x, 2.f * half.y, half.z)};
+        SweepResult sweep = sweepBox(view, box, displacement);
+        bool onGround = sweep.blocked.y && displacement.y < 0.f;
+        if (sweep.blocked.y) {
+            vel.y = 0.f;
+        }
+        // Walkers hop onto a step in their way, and turn around if they hit a wall mid-air
+        if (sweep.blocked.x || sweep.blocked.z) {
+            if (onGround) {
+                vel.y = hopSpeed;
+            } else if (vel.y <= 0.f) {
+                vel.x = sweep.blocked.x ? -vel.x : vel.x;
+                vel.z = sweep.blocked.z ? -vel.z : vel.z;
+            }
+        }
+
+        m_nextPositions[i] = pos + sweep.displacement;
+        m_nextVelocities[i] = vel;
+    }
+}
+
+float EntitySystem::getLastStepMs() const {
+    return m_lastStepMs;
+}
+
+void EntitySystem::getInstances(float alpha, std::vector<glm::vec3> &offsets, std::vector<glm::vec4> &shapes) const {
+    offsets.resize(m_positions.size());
+    shapes.resize(m_positions.size());
+    for (size_t i = 0; i < m_positions.size(); ++i) {
+        glm::vec3 pos = glm::mix(m_prevPositions[i], m_positions[i], alpha);
+        glm::vec3 half = m_halfExtents[i];
+        offsets[i] = pos - glm::vec3(half.x, 0.f, half.z);
+        shapes[i] = glm::vec4(2.f * half, m_layers[i]);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "terrain.h"
+#include "collision.h"
+#include "spatialhash.h"
+#include <QThreadPool>
+#include <vector>
+
+// Mobs and falling blocks, simulated in bulk. Unlike Entity, which is one
+// object per thing with virtual movement, each property here is an array
+// indexed by entity, so the physics streams through memory. step splits
+// the entities between worker threads, which read the last step's arrays
+// and a snapshot of the blocks around the entities and write their own
+// share of the next step's, so the result doesn't depend on how the work
+// was split.
+class EntitySystem {
+public:
+    // Fewer entities than this per worker aren't worth a thread
+    const static int MIN_PER_WORKER = 256;
+    // Cells of the spatial hash, at least as large as the largest entity
+    constexpr static float CELL_SIZE = 2.f;
+
+private:
+    // The center of the bottom face of each entity's box
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_prevPositions; // Before the last step
+    std::vector<glm::vec3> m_velocities;    // Blocks per second
+    std::vector<glm::vec3> m_halfExtents;   // Half the size of the box
+    std::vector<float> m_layers;            // Texture array layer the box is drawn with
+    // Written by the workers and swapped in once they are all done
+    std::vector<glm::vec3> m_nextPositions, m_nextVelocities;
+
+    SpatialHash m_hash;
+    // The blocks the entities can reach this step, copied out of the Terrain
+    // before the workers start since BlockWorkers keep filling Chunks meanwhile
+    BlockSnapshot m_snapshot;
+    void takeSnapshot(float dt, const Terrain &terrain);
+    // Whether the snapshot holds every Chunk the box of an entity at pos stands in
+    bool isInSnapshot(glm::vec3 pos, glm::vec3 half) const;
+    // Separate from the global pool so terrain jobs can't hold up a step
+    QThreadPool m_pool;
+    float m_lastStepMs;
+
+public:
+    EntitySystem();
+
+    // A box walks along at the given velocity, hopping up one block steps.
+    // Returns the entity's index.
+    int spawn(glm::vec3 position, glm::vec3 velocity, glm::vec3 halfExtents, float layer);
+    void clear();
+    size_t size() const;
+
+    // Moves every entity on by dt seconds, waiting for the workers. Call on
+    // the main thread: the Terrain is only read there, to take the snapshot.
+    void step(float dt, const Terrain &terrain);
+    // The physics of the entities in [begin, end), run by step and its workers
+    // against the snapshot
+    void stepRange(int begin, int end, float dt);
+    float getLastStepMs() const;
+
+    // The per-instance data of InstancedDrawable::createInstancedVBOdata and
+    // setInstanceShapes, with the boxes alpha of the way through the last step
+    void getInstances(float alpha, std::vector<glm::vec3> &offsets, std::vector<glm::vec4> &shapes) const;
+};
@@ -0,0 +1,192 @@
+#include "horizon.h"
+#include "horizonworker.h"
+#include <QThreadPool>
+
+// The surface of water-filled columns, see Terrain::fillChunk
+const static float seaLevel = 139.f;
+// Rebuild the mesh at most this often (in calls to update)
+const static int rebuildInterval = 15;
+
+// Rough color of each biome's surface seen from far away
+glm::vec4 getHorizonColor(BiomeType b, float height) {
+    if (height < seaLevel) {
+        return b == SNOWY_PLAINS ? glm::vec4(0.62f, 0.75f, 0.95f, 1.f) : glm::vec4(0.2f, 0.36f, 0.8f, 1.f);
+    } else if (b == MOUNTAIN) {
+        return height >= 200.f ? glm::vec4(0.95f, 0.95f, 0.98f, 1.f) : glm::vec4(0.5f, 0.5f, 0.52f, 1.f);
+    } else if (b == DESERT) {
+        return glm::vec4(0.86f, 0.8f, 0.55f, 1.f);
+    } else if (b == SNOWY_PLAINS) {
+        return glm::vec4(0.9f, 0.92f, 0.95f, 1.f);
+    } else {
+        return glm::vec4(0.36f, 0.6f, 0.25f, 1.f);
+    }
+}
+
+void fillHorizonRegion(const Terrain &terrain, int x, int z, HorizonRegion &region) {
+    for (int j = 0; j < REGION_SAMPLES; ++j) {
+        for (int i = 0; i < REGION_SAMPLES; ++i) {
+            BiomeType b;
+            float top = glm::floor(terrain.getSurfaceHeight(x + i * REGION_SPACING, z + j * REGION_SPACING, &b)) + 1.f;
+            region.heights[i + REGION_SAMPLES * j] = glm::max(top, seaLevel);
+            region.colors[i + REGION_SAMPLES * j] = getHorizonColor(b, top);
+        }
+    }
+}
+
+Horizon::Horizon(OpenGLContext *context, const Terrain &terrain)
+    : Drawable(context), mcr_terrain(terrain),
+      m_regions(), m_pendingRegions(), m_finishedRegions(), m_regionMutex(), m_workersStarted(0), m_workersDone(),
+      m_meshChunk(0, 0), m_ticksSinceBuild(rebuildInterval), m_dirty(true)
+{}
+
+Horizon::~Horizon() {
+    // Workers may still hold pointers to our members
+    m_workersDone.acquire(m_workersStarted);
+    for (auto &r : m_finishedRegions) {
+        delete r.second;
+    }
+}
+
+void Horizon::markDirty() {
+    m_dirty = true;
+}
+
+bool Horizon::isKept(int64_t key, glm::ivec2 viewRegion) {
+    glm::ivec2 d = glm::abs(toCoords(key) - viewRegion) / REGION_SIZE;
+    return glm::max(d.x, d.y) <= HORIZON_KEEP_RADIUS;
+}
+
+void Horizon::update(glm::vec3 viewPos, int loadedRadius) {
+    glm::vec2 viewXZ = glm::vec2(viewPos.x, viewPos.z);
+    glm::ivec2 viewChunk = 16 * glm::ivec2(glm::floor(viewXZ / 16.f));
+    glm::ivec2 viewRegion = REGION_SIZE * glm::ivec2(glm::floor(viewXZ / static_cast<float>(REGION_SIZE)));
+
+    // Take ownership of the regions the workers have finished, unless they
+    // were evicted while in flight or the viewer has since moved away
+    m_regionMutex.lock();
+    for (auto &r : m_finishedRegions) {
+        uPtr<HorizonRegion> region(r.second);
+        if (m_pendingRegions.erase(r.first) == 0 || !isKept(r.first, viewRegion)) {
+            continue;
+        }
+        m_regions[r.first] = std::move(region);
+        m_dirty = true;
+    }
+    m_finishedRegions.clear();
+    m_regionMutex.unlock();
+
+    // Evict the regions the viewer has left behind
+    for (auto it = m_regions.begin(); it != m_regions.end();) {
+        if (isKept(it->first, viewRegion)) {
+            ++it;
+        } else {
+            it = m_regions.erase(it);
+        }
+    }
+    for (auto it = m_pendingRegions.begin(); it != m_pendingRegions.end();) {
+        if (isKept(*it, viewRegion)) {
+            ++it;
+        } else {
+            it = m_pendingRegions.erase(it);
+        }
+    }
+
+    // Request every region around the viewer that is neither cached nor in flight
+    for (int dx = -HORIZON_RADIUS; dx <= HORIZON_RADIUS; ++dx) {
+        for (int dz = -HORIZON_RADIUS; dz <= HORIZON_RADIUS; ++dz) {
+            glm::ivec2 r = viewRegion + glm::ivec2(dx, dz) * REGION_SIZE;
+            int64_t key = toKey(r.x, r.y);
+            if (m_regions.find(key) == m_regions.end() && m_pendingRegions.find(key) == m_pendingRegions.end()) {
+                m_pendingRegions.insert(key);
+                HorizonWorker *hw = new HorizonWorker(&mcr_terrain, &m_regionMutex, r.x, r.y, &m_finishedRegions, &m_workersDone);
+                QThreadPool::globalInstance()->start(hw);
+                ++m_workersStarted;
+            }
+        }
+    }
+
+    ++m_ticksSinceBuild;
+    if ((m_dirty || viewChunk != m_meshChunk) && m_ticksSinceBuild >= rebuildInterval) {
+        buildMesh(viewChunk, loadedRadius);
+        destroyVBOdata();
+        createVBOdata();
+        m_meshChunk = viewChunk;
+        m_ticksSinceBuild = 0;
+        m_dirty = false;
+    }
+}
+
+void Horizon::buildMesh(glm::ivec2 viewChunk, int loadedRadius) {
+    m_pos.clear();
+    m_nor.clear();
+    m_col.clear();
+    m_idx.clear();
+
+    glm::ivec2 viewRegion = REGION_SIZE * glm::ivec2(glm::floor(glm::vec2(viewChunk) / static_cast<float>(REGION_SIZE)));
+    for (int dx = -HORIZON_RADIUS; dx <= HORIZON_RADIUS; ++dx) {
+        for (int dz = -HORIZON_RADIUS; dz <= HORIZON_RADIUS; ++dz) {
+            glm::ivec2 r = viewRegion + glm::ivec2(dx, dz) * REGION_SIZE;
+            auto it = m_regions.find(toKey(r.x, r.y));
+            if (it == m_regions.end()) continue;
+            const HorizonRegion &region = *it->second;
+
+            // One vertex per sample, shared by the cells around it
+            GLuint base = m_pos.size();
+            for (int j = 0; j < REGION_SAMPLES; ++j) {
+                for (int i = 0; i < REGION_SAMPLES; ++i) {
+                    auto height = [&](int a, int b) {
+                        a = glm::clamp(a, 0, REGION_SAMPLES - 1);
+                        b = glm::clamp(b, 0, REGION_SAMPLES - 1);
+                        return region.heights[a + REGION_SAMPLES * b];
+                    };
+                    // Sit slightly below the real terrain so loaded Chunks win where they overlap
+                    m_pos.push_back(glm::vec4(r.x + i * REGION_SPACING, height(i, j) - 1.f, r.y + j * REGION_SPACING, 1.f));
+                    glm::vec3 nor = glm::vec3(height(i - 1, j) - height(i + 1, j),
+                                              2.f * REGION_SPACING,
+                                              height(i, j - 1) - height(i, j + 1));
+                    m_nor.push_back(glm::vec4(glm::normalize(nor), 0.f));
+                    m_col.push_back(region.colors[i + REGION_SAMPLES * j]);
+                }
+            }
+
+            // Skip the cells that Terrain::draw already covers with a Chunk
+            for (int j = 0; j < REGION_SAMPLES - 1; ++j) {
+                for (int i = 0; i < REGION_SAMPLES - 1; ++i) {
+                    int cx = r.x + i * REGION_SPACING, cz = r.y + j * REGION_SPACING;
+                    if (cx >= viewChunk.x - loadedRadius && cx < viewChunk.x + loadedRadius &&
+                        cz >= viewChunk.y - loadedRadius && cz < viewChunk.y + loadedRadius &&
+                        mcr_terrain.hasChunkAt(cx, cz) && mcr_terrain.getChunkAt(cx, cz)->elemCount(INDEX) >= 0) {
+                        continue;
+                    }
+                    GLuint v = base + i + REGION_SAMPLES * j;
+                    m_idx.push_back(v);
+                    m_idx.push_back(v + REGION_SAMPLES);
+                    m_idx.push_back(v + REGION_SAMPLES + 1);
+                    m_idx.push_back(v);
+                    m_idx.push_back(v + REGION_SAMPLES + 1);
+                    m_idx.push_back(v + 1);
+                }
+            }
+        }
+    }
+}
+
+void Horizon::createVBOdata() {
+    indexCounts[INDEX] = m_idx.size();
+
+    generateBuffer(INDEX);
+    bindBuffer(INDEX);
+    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_idx.size() * sizeof(GLuint), m_idx.data(), GL_STATIC_DRAW);
+
+    generateBuffer(POSITION);
+    bindBuffer(POSITION);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, m_pos.size() * sizeof(glm::vec4), m_pos.data(), GL_STATIC_DRAW);
+
+    generateBuffer(NORMAL);
+    bindBuffer(NORMAL);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, m_nor.size() * sizeof(glm::vec4), m_nor.data(), GL_STATIC_DRAW);
+
+    generateBuffer(COLOR);
+    bindBuffer(COLOR);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, m_col.size() * sizeof(glm::vec4), m_col.data(), GL_STATIC_DRAW);
+}
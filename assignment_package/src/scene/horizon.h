@@ -0,0 +1,77 @@
+#pragma once
+#include <QMutex>
+#include <QSemaphore>
+#include "smartpointerhelp.h"
+#include "drawable.h"
+#include "terrain.h"
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+
+// Each horizon region covers REGION_SIZE x REGION_SIZE blocks and is
+// sampled every REGION_SPACING blocks, so one sample cell is one Chunk.
+const static int REGION_SIZE = 256;
+const static int REGION_SPACING = 16;
+const static int REGION_SAMPLES = REGION_SIZE / REGION_SPACING + 1;
+// How many regions around the viewer's region are drawn in each direction
+const static int HORIZON_RADIUS = 3;
+// Regions further than this from the viewer's region are dropped, one more
+// than is drawn so walking back and forth over a border keeps them
+const static int HORIZON_KEEP_RADIUS = HORIZON_RADIUS + 1;
+
+// The coarse heightfield of one region of the world. This is all the
+// horizon stores, which is far smaller than the Chunks it stands in for.
+struct HorizonRegion {
+    std::array<float, REGION_SAMPLES * REGION_SAMPLES> heights;
+    std::array<glm::vec4, REGION_SAMPLES * REGION_SAMPLES> colors;
+};
+
+// Samples the heights and biome colors of the region whose
+// lower-left corner is at (x, z). Safe to call from any thread.
+void fillHorizonRegion(const Terrain &terrain, int x, int z, HorizonRegion &region);
+
+// A single low-poly heightfield mesh of the terrain beyond the loaded
+// Chunks. Regions are sampled from Terrain::getSurfaceHeight on worker
+// threads and cached; the mesh leaves a hole wherever a Chunk is loaded.
+class Horizon : public Drawable {
+private:
+    const Terrain &mcr_terrain;
+
+    // Finished regions, only touched by the main thread
+    std::unordered_map<int64_t, uPtr<HorizonRegion>> m_regions;
+    // Regions handed to a HorizonWorker that have not come back yet. A region
+    // evicted while in flight is dropped from here and deleted when it lands.
+    std::unordered_set<int64_t> m_pendingRegions;
+    // Regions the workers have finished since the last update
+    std::vector<std::pair<int64_t, HorizonRegion*>> m_finishedRegions;
+    QMutex m_regionMutex;
+    // Every HorizonWorker started releases m_workersDone once when it is done
+    // with our members, so the destructor waits for exactly these.
+    int m_workersStarted;
+    QSemaphore m_workersDone;
+
+    // The chunk the viewer was in when the mesh was last built
+    glm::ivec2 m_meshChunk;
+    int m_ticksSinceBuild;
+    bool m_dirty;
+
+    std::vector<glm::vec4> m_pos, m_nor, m_col;
+    std::vector<GLuint> m_idx;
+
+    void buildMesh(glm::ivec2 viewChunk, int loadedRadius);
+    // Whether the region with the given key is within HORIZON_KEEP_RADIUS of viewRegion
+    static bool isKept(int64_t key, glm::ivec2 viewRegion);
+
+public:
+    Horizon(OpenGLContext *context, const Terrain &terrain);
+    ~Horizon();
+
+    // Requests missing regions around the viewer and rebuilds the mesh if
+    // new regions arrived, the viewer changed chunks or markDirty was called.
+    // Chunks within loadedRadius blocks of the viewer are left to Terrain.
+    void update(glm::vec3 viewPos, int loadedRadius);
+    // Call when Chunks get their VBOs so the hole in the mesh follows them
+    void markDirty();
+
+    void createVBOdata() override;
+};
@@ -0,0 +1,188 @@
+#include "lightengine.h"
+#include "terrain.h"
+
+LightEngine::LightEngine(Terrain *terrain)
+    : mp_terrain(terrain)
+{}
+
+Chunk* LightEngine::getLitChunk(glm::ivec3 pos, glm::ivec3 &local) const {
+    if (pos.y < 0 || pos.y >= 256 || !mp_terrain->hasChunkAt(pos.x, pos.z)) {
+        return nullptr;
+    }
+    Chunk *c = mp_terrain->getChunkAt(pos.x, pos.z).get();
+    // Chunks that haven't been lit yet will see the edit when they are
+    if (!c->isLightReady()) {
+        return nullptr;
+    }
+    glm::ivec2 min = c->getMin();
+    local = glm::ivec3(pos.x - min.x, pos.y, pos.z - min.y);
+    return c;
+}
+
+int LightEngine::getLight(glm::ivec3 pos, LightChannel channel) const {
+    // Above the world is open sky
+    if (pos.y >= 256) {
+        return channel == SKY_LIGHT ? MAX_LIGHT : 0;
+    }
+    glm::ivec3 local;
+    Chunk *c = getLitChunk(pos, local);
+    return c ? c->getLocalLightAt(local.x, local.y, local.z, channel) : 0;
+}
+
+void LightEngine::setLight(glm::ivec3 pos, LightChannel channel, int level, std::unordered_set<Chunk*> &relit) {
+    glm::ivec3 local;
+    Chunk *c = getLitChunk(pos, local);
+    if (!c) {
+        return;
+    }
+    c->setLocalLightAt(local.x, local.y, local.z, channel, level);
+    relit.insert(c);
+    // Faces of the next Chunk over can look out onto blocks on the border
+    if (local.x == 0 || local.x == 15 || local.z == 0 || local.z == 15) {
+        for (int dx = -1; dx <= 1; dx += 2) {
+            if (mp_terrain->hasChunkAt(pos.x + dx, pos.z)) relit.insert(mp_terrain->getChunkAt(pos.x + dx, pos.z).get());
+        }
+        for (int dz = -1; dz <= 1; dz += 2) {
+            if (mp_terrain->hasChunkAt(pos.x, pos.z + dz)) relit.insert(mp_terrain->getChunkAt(pos.x, pos.z + dz).get());
+        }
+    }
+}
+
+void LightEngine::removeLight(std::vector<LightNode> &removals, std::vector<glm::ivec3> &additions,
+                              LightChannel channel, std::unordered_set<Chunk*> &relit) {
+    for (size_t head = 0; head < removals.size(); ++head) {
+        LightNode node = removals[head];
+        for (const BlockFace &face : faces) {
+            glm::ivec3 n = node.pos + face.dirVector;
+            int level = getLight(n, channel);
+            if (level == 0) continue;
+            // Dimmer neighbors, and sky columns below, were lit through this block
+            bool litByNode = level < node.level ||
+                             (channel == SKY_LIGHT && face.dir == YNEG && node.level == MAX_LIGHT);
+            if (litByNode) {
+                // Emitters keep their own light and shine back into the darkened area
+                int emission = channel == BLOCK_LIGHT ? blockInfo(mp_terrain->getGlobalBlockAt(n.x, n.y, n.z)).emission : 0;
+                setLight(n, channel, emission, relit);
+                removals.push_back({n, level});
+                if (emission > 0) {
+                    additions.push_back(n);
+                }
+            } else {
+                // A brighter neighbor has another source, let it refill the darkened area
+                additions.push_back(n);
+            }
+        }
+    }
+}
+
+void LightEngine::spreadLight(std::vector<glm::ivec3> &additions, LightChannel channel, std::unordered_set<Chunk*> &relit) {
+    for (size_t head = 0; head < additions.size(); ++head) {
+        glm::ivec3 p = additions[head];
+        int level = getLight(p, channel);
+        for (const BlockFace &face : faces) {
+            glm::ivec3 n = p + face.dirVector;
+            glm::ivec3 local;
+            Chunk *c = getLitChunk(n, local);
+            if (!c) continue;
+            int spread = propagatedLight(level, c->getLocalBlockAt(local.x, local.y, local.z), face.dir, channel);
+            if (spread > c->getLocalLightAt(local.x, local.y, local.z, channel)) {
+                setLight(n, channel, spread, relit);
+                additions.push_back(n);
+            }
+        }
+    }
+}
+
+void LightEngine::chunkLit(Chunk *c, std::unordered_set<Chunk*> &relit) {
+    c->markLightReady();
+    relit.insert(c);
+    glm::ivec2 min = c->getMin();
+    std::vector<std::pair<Chunk*, Direction>> neighbors;
+    for (Direction dir : {XPOS, XNEG, ZPOS, ZNEG}) {
+        glm::ivec3 offset = faces[dir].dirVector;
+        glm::ivec3 local;
+        Chunk *n = getLitChunk(glm::ivec3(min.x + 8 + 16 * offset.x, 0, min.y + 8 + 16 * offset.z), local);
+        if (n) {
+            neighbors.push_back(std::make_pair(n, dir));
+            relit.insert(n);
+        }
+    }
+
+    for (LightChannel channel : {SKY_LIGHT, BLOCK_LIGHT}) {
+        // Only the border blocks that can brighten the block across from them seed the spread
+        std::vector<glm::ivec3> additions;
+        for (const auto &neighbor : neighbors) {
+            Chunk *n = neighbor.first;
+            Direction dir = neighbor.second;
+            glm::ivec3 offset = faces[dir].dirVector;
+            Direction back = dir == XPOS ? XNEG : dir == XNEG ? XPOS : dir == ZPOS ? ZNEG : ZPOS;
+            for (int y = 0; y < 256; ++y) {
+                for (int i = 0; i < 16; ++i) {
+                    int x = offset.x > 0 ? 15 : offset.x < 0 ? 0 : i;
+                    int z = offset.z > 0 ? 15 : offset.z < 0 ? 0 : i;
+                    int nx = (x + offset.x + 16) % 16, nz = (z + offset.z + 16) % 16;
+                    int inside = c->getLocalLightAt(x, y, z, channel);
+                    int outside = n->getLocalLightAt(nx, y, nz, channel);
+                    if (propagatedLight(inside, n->getLocalBlockAt(nx, y, nz), dir, channel) > outside) {
+                        additions.push_back(glm::ivec3(min.x + x, y, min.y + z));
+                    } else if (propagatedLight(outside, c->getLocalBlockAt(x, y, z), back, channel) > inside) {
+                        additions.push_back(glm::ivec3(min.x + x, y, min.y + z) + offset);
+                    }
+                }
+            }
+        }
+        spreadLight(additions, channel, relit);
+    }
+}
+
+void LightEngine::blockChanged(int x, int y, int z, BlockType t, std::unordered_set<Chunk*> &relit) {
+    blocksChanged({std::make_pair(glm::ivec3(x, y, z), t)}, relit);
+}
+
+void LightEngine::blocksChanged(const std::vector<std::pair<glm::ivec3, BlockType>> &changes, std::unordered_set<Chunk*> &relit) {
+    // Blocks outside the lit Chunks are left to Chunk::computeLight
+    std::vector<std::pair<glm::ivec3, BlockType>> lit;
+    glm::ivec3 local;
+    for (const auto &change : changes) {
+        if (getLitChunk(change.first, local)) {
+            lit.push_back(change);
+        }
+    }
+    if (lit.empty()) {
+        return;
+    }
+    for (LightChannel channel : {SKY_LIGHT, BLOCK_LIGHT}) {
+        std::vector<LightNode> removals;
+        std::vector<glm::ivec3> additions;
+
+        // Take away whatever light the blocks had along with all the light that came through them
+        for (const auto &change : lit) {
+            glm::ivec3 p = change.first;
+            int level = getLight(p, channel);
+            if (level > 0) {
+                setLight(p, channel, 0, relit);
+                removals.push_back({p, level});
+            }
+        }
+        removeLight(removals, additions, channel, relit);
+
+        for (const auto &change : lit) {
+            glm::ivec3 p = change.first;
+            BlockType t = change.second;
+            int emission = channel == BLOCK_LIGHT ? blockInfo(t).emission : 0;
+            if (emission > 0) {
+                setLight(p, channel, emission, relit);
+                additions.push_back(p);
+            }
+            // Light can flow back in from the neighbors if the block lets it through
+            if (!blockInfo(t).opaque) {
+                for (const BlockFace &face : faces) {
+                    if (getLight(p + face.dirVector, channel) > 0) {
+                        additions.push_back(p + face.dirVector);
+                    }
+                }
+            }
+        }
+        spreadLight(additions, channel, relit);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "chunk.h"
+#include <unordered_set>
+#include <vector>
+
+class Terrain;
+
+// Keeps the light stored in the Chunks up to date as blocks are edited.
+// Chunks are lit on their own by Chunk::computeLight when they are generated,
+// then chunkLit joins their light up with the lit Chunks around them. After
+// that an edit only relights the blocks whose light depended on it, which
+// can reach into the neighboring Chunks.
+class LightEngine {
+private:
+    Terrain *mp_terrain;
+
+    // A block in world space, queued along with the light level it had
+    struct LightNode {
+        glm::ivec3 pos;
+        int level;
+    };
+
+    // The lit Chunk holding a world-space block, or nullptr, along with
+    // the block's coordinates local to it
+    Chunk* getLitChunk(glm::ivec3 pos, glm::ivec3 &local) const;
+    int getLight(glm::ivec3 pos, LightChannel channel) const;
+    // Sets the light of a block and marks the Chunks whose faces show it
+    void setLight(glm::ivec3 pos, LightChannel channel, int level, std::unordered_set<Chunk*> &relit);
+
+    // Darkens everything that was lit through the removed blocks, and queues
+    // the brighter blocks around that area to fill it back in
+    void removeLight(std::vector<LightNode> &removals, std::vector<glm::ivec3> &additions,
+                     LightChannel channel, std::unordered_set<Chunk*> &relit);
+    // Spreads the light of the queued blocks outwards
+    void spreadLight(std::vector<glm::ivec3> &additions, LightChannel channel, std::unordered_set<Chunk*> &relit);
+
+public:
+    LightEngine(Terrain *terrain);
+
+    // Call on the main thread once Chunk::computeLight has run for c. Marks it
+    // lit and spreads the light across its borders both ways, as far into the
+    // lit Chunks as it reaches. c, its neighbors, whose faces look onto its
+    // blocks, and every Chunk the light changed in are added to relit.
+    void chunkLit(Chunk *c, std::unordered_set<Chunk*> &relit);
+
+    // Relights the world around a block that has just been set to t. Every
+    // Chunk whose meshes have to be rebuilt for the new light is added to relit.
+    void blockChanged(int x, int y, int z, BlockType t, std::unordered_set<Chunk*> &relit);
+    // The same for many blocks at once, each given with the type it was set to.
+    // The light is taken away and spread again in one pass for all of them.
+    void blocksChanged(const std::vector<std::pair<glm::ivec3, BlockType>> &changes, std::unordered_set<Chunk*> &relit);
+};
@@ -1,4 +1,6 @@
 #include "player.h"
+#include "collision.h"
+#include "profiler.h"
 #include <QString>
 #include <iostream>
 #include <QDebug>
@@ -123,17 +125,8 @@ glm::vec3 Player::normalizeVelocity() {
     return (normalF * m_velocity.z) + (normalR * m_velocity.x);
 }
 
-const std::array<float, 2> player_bb_x {
-    -0.48, 0.48
-};
-const std::array<float, 3> player_bb_y {
-    0, 0.9, 1.9
-};
-const std::array<float, 2> player_bb_z {
-    -0.48, 0.48
-};
-
 void Player::computePhysics(float dT, const Terrain &terrain) {
+    PROFILE_SCOPE("physics");
     // TODO: Update the Player's position based on its acceleration
     // and velocity, and also perform collision detection.
     if (flightMode) {
@@ -145,156 +138,27 @@ void Player::computePhysics(float dT, const Terrain &terrain) {
 
 
         glm::vec3 normalVel = normalizeVelocity();
-        bool collisionX = false, collisionZ = false, collisionY = false;
-        float minDisX = 100000.f;
-        glm::ivec3 closeBlockX(0, 0, 0);
-        float minDisZ = 100000.f;
-        glm::ivec3 closeBlockZ(0, 0, 0);
-        float minDisY = 100000.f;
-        glm::ivec3 closeBlockY(0, 0, 0);
-
-        // Collision checking
-        for (float y : player_bb_y) {
-            for (float x : player_bb_x) {
-                for (float z : player_bb_z) {
-                    glm::vec3 rayPos = glm::vec3(m_position.x + x, m_position.y + y, m_position.z + z);
-                    float dis = 0;
-                    glm::ivec3 outBlock;
-
-                    //Will perform grid march on all axis
-                    glm::vec3 rayDirX = glm::vec3(normalVel.x,  0, 0) * dT * 16.5f;
-                    glm::vec3 rayDirY = glm::vec3(0,  m_velocity.y, 0) * dT * 15.f;
-                    glm::vec3 rayDirZ = glm::vec3(0,  0, normalVel.z) * dT * 16.5f;
-
-                    if (gridMarch(rayPos, rayDirX, terrain, &dis, &outBlock)) {
-                        collisionX = true;
-                        if (dis < minDisX) {
-                            minDisX = dis;
-                            closeBlockX = outBlock;
-                        }
-                    }
-
-                    //Could be cause bottom left corner
-                    if (gridMarch(rayPos, rayDirZ, terrain, &dis, &outBlock)) {
-                        collisionZ = true;
-                        if (dis < minDisZ) {
-                            minDisZ = dis;
-                            closeBlockZ = outBlock;
-                        }
-                    }
-
-                    if (gridMarch(rayPos, rayDirY, terrain, &dis, &outBlock)) {
-                        collisionY = true;
-                        if (dis < minDisY) {
-                            minDisY = dis;
-                            closeBlockY = outBlock;
-                        }
-                    }
-                }
-            }
-        }
-
-
-        float displacementX = normalVel.x * dT;
-
-        float displacementY = m_velocity.y * dT;
-
-        float displacementZ = normalVel.z * dT;
-
-        float offset = 0.01;
-        BlockType blockY = terrain.getGlobalBlockAt(closeBlockY.x,closeBlockY.y, closeBlockY.z);
-        BlockType blockX = terrain.getGlobalBlockAt(closeBlockX.x,closeBlockX.y, closeBlockX.z);
-        BlockType blockZ = terrain.getGlobalBlockAt(closeBlockZ.x,closeBlockZ.y, closeBlockZ.z);
-
-
-        if (playerMove && (collisionY && blockY == WATER) ||
-            (collisionX && blockX == WATER) ||
-            (collisionZ && blockZ == WATER)) {
-            // Update collisions only if the player moved
-            onWater = true;
-        } else if (playerMove && m_position.y >= 139 || (playerMove && m_position.y < 135)){
-            onWater = false;
-        }
-
-
-        if (playerMove && (collisionY && blockY == LAVA) ||
-            (collisionX && blockX == LAVA) ||
-            (collisionZ && blockZ == LAVA)) {
-            onLava = true;
-        } else if (playerMove && m_position.y >= 26){
-            onLava = false;
+        glm::vec3 displacement(normalVel.x * dT, m_velocity.y * dT, normalVel.z * dT);
+
+        // Collision checking. Only solid blocks stop the player, they can swim through water and lava.
+        ChunkView view(terrain);
+        AABB box{m_position + glm::vec3(-0.48f, 0.f, -0.48f), m_position + glm::vec3(0.48f, 1.9f, 0.48f)};
+        SweepResult sweep = sweepBox(view, box, displacement);
+        onGround = sweep.blocked.y && displacement.y < 0.f;
+        if (sweep.blocked.y) {
+            m_velocity.y = 0.f;
         }
-
-        if (onLava) {
-            caminLava = (m_position.y + 1.5 < 26);
-        } else {
-            caminLava = false;
-        }
-
-        if (onWater) {
-            caminWater = (m_position.y + 1.5 < 139);
-        } else {
-            caminWater = false;
-        }
-
-
-
-        if (displacementZ < 0 && blockZ != WATER && blockY != LAVA) {
-            if (minDisZ <= offset) {
-                displacementZ = 0;
-            } else if (std::abs(displacementZ) > minDisZ) {
-                displacementZ = -minDisZ * 0.8;
-            }
-        } else if (displacementZ > 0 && blockZ != WATER && blockY != LAVA) {
-            if (minDisZ <= offset) {
-                displacementZ = 0;
-            } else if (std::abs(displacementZ) > minDisZ) {
-                displacementZ = (minDisZ ) * 0.8;
-            }
-        }
-
-
-        if (displacementX < 0 && blockX != WATER && blockY != LAVA) {
-            if (minDisX <= offset) {
-                displacementX = 0;
-            } else if (std::abs(displacementX) > minDisX) {
-                displacementX = -minDisX * 0.8;
-            }
-        } else if (displacementX > 0 && blockX != WATER && blockY != LAVA) {
-            if (minDisX <= offset) {
-                displacementX = 0;
-            } else if (std::abs(displacementX) > minDisX) {
-                displacementX = (minDisX) * 0.8;;
-            }
-        }
-
-
-        if (displacementY < 0 && blockY != WATER && blockY != LAVA) {
-            if (minDisY <= offset) {
-                displacementY = 0;
-                if (!onWater || !onLava) {
-                    onGround = true;
-                }
-            } else if (std::abs(displacementY) > minDisY) {
-                displacementY = -minDisY * 0.8;
-                if (!onWater || !onLava) {
-                    onGround = true;
-                }
-            }
-        } else if (displacementY > 0 && blockY != WATER) {
-            // displacementZ = (minDisZ * 0.8);
-            if (minDisY <= offset) {
-                displacementY = 0;
-            } else if (std::abs(displacementY) > minDisY) {
-                displacementY = (minDisY ) * 0.8;;
-            }           
-        }
-
-
-        glm::vec3 adjustedDis = glm::vec3(displacementX, displacementY, displacementZ);
+        onWater = sweep.inWater;
+        onLava = sweep.inLava;
 
         // Apply movement
-        moveAlongVector(adjustedDis);
+        moveAlongVector(sweep.displacement);
+
+        // Whether the camera itself is under the surface
+        glm::ivec3 eye = glm::ivec3(glm::floor(m_camera.mcr_position));
+        BlockType eyeBlock = view.getBlockAt(eye.x, eye.y, eye.z);
+        caminWater = eyeBlock == WATER;
+        caminLava = eyeBlock == LAVA;
 
     }
 
@@ -318,58 +182,6 @@ void Player::computePhysics(float dT, const Terrain &terrain) {
 
 }
 
-//From Lecture
-bool Player::gridMarch(glm::vec3 rayOrigin, glm::vec3 rayDirection, const Terrain &terrain, float *out_dist, glm::ivec3 *out_blockHit) {
-    float maxLen = glm::length(rayDirection); // Farthest we search
-    glm::ivec3 currCell = glm::ivec3(glm::floor(rayOrigin));
-    rayDirection = glm::normalize(rayDirection); // Now all t values represent world dist.
-
-    float curr_t = 0.f;
-    while(curr_t < maxLen) {
-        float min_t = glm::sqrt(3.f);
-        float interfaceAxis = -1; // Track axis for which t is smallest
-        for(int i = 0; i < 3; ++i) { // Iterate over the three axes
-            if(rayDirection[i] != 0) { // Is ray parallel to axis i?
-                float offset = glm::max(0.f, glm::sign(rayDirection[i])); // See slide 5
-                // If the player is *exactly* on an interface then
-                // they'll never move if they're looking in a negative direction
-                if(currCell[i] == rayOrigin[i] && offset == 0.f) {
-                    offset = -1.f;
-                }
-                int nextIntercept = currCell[i] + offset;
-                float axis_t = (nextIntercept - rayOrigin[i]) / rayDirection[i];
-                axis_t = glm::min(axis_t, maxLen); // Clamp to max len to avoid super out of bounds errors
-                if(axis_t < min_t) {
-                    min_t = axis_t;
-                    interfaceAxis = i;
-                }
-            }
-        }
-        if(interfaceAxis == -1) {
-            throw std::out_of_range("interfaceAxis was -1 after the for loop in gridMarch!");
-        }
-        curr_t += min_t; // min_t is declared in slide 7 algorithm
-        rayOrigin += rayDirection * min_t;
-        glm::ivec3 offset = glm::ivec3(0,0,0);
-        // Sets it to 0 if sign is +, -1 if sign is -
-        offset[interfaceAxis] = glm::min(0.f, glm::sign(rayDirection[interfaceAxis]));
-        currCell = glm::ivec3(glm::floor(rayOrigin)) + offset;
-        // If currCell contains something other than EMPTY, return
-        // curr_t
-        BlockType cellType = terrain.getGlobalBlockAt(currCell.x, currCell.y, currCell.z);
-        if (maxLen > curr_t) {
-            if(cellType != EMPTY) {
-                *out_blockHit = currCell;
-                *out_dist = glm::min(maxLen, curr_t);
-                return true;
-            }
-        }
-
-    }
-    *out_dist = glm::min(maxLen, curr_t);
-    return false;
-}
-
 glm::vec3 Player::getBlock(const Terrain &terrain) {
 
     float minDisF = 100000.f;
@@ -377,20 +189,19 @@ glm::vec3 Player::getBlock(const Terrain &terrain) {
     bool collision = false;
 
     glm::vec3 rayPos = glm::vec3(m_position.x, m_position.y + 1.5, m_position.z);
-    glm::vec3 rayDir = glm::normalize(m_forward) * 3.0f;
-    float dis = 0;
-    glm::ivec3 outBlock;
+    ChunkView view(terrain);
+    RayHit hit;
 
 
-    if (gridMarch(rayPos, rayDir, terrain, &dis, &outBlock)) {
+    if (raycastBlocks(view, rayPos, m_forward, 3.0f, &hit)) {
         collision= true;
-        minDisF = dis;
-        closeBlockF = outBlock;
+        minDisF = hit.distance;
+        closeBlockF = hit.block;
     }
 
-    BlockType block = terrain.getGlobalBlockAt(closeBlockF.x,closeBlockF.y, closeBlockF.z);
     if (collision) {
-        if (block == EMPTY || block == WATER || block == LAVA || block == BEDROCK) {
+        BlockType block = view.getBlockAt(closeBlockF.x, closeBlockF.y, closeBlockF.z);
+        if (!blockInfo(block).breakable) {
             breakBlock = false;
             return glm::vec3(-1, -1, -1);
         }
@@ -424,15 +235,14 @@ glm::vec3 Player::placeBlock(const Terrain &terrain) {
     bool collision = false;
 
     glm::vec3 rayPos = glm::vec3(m_position.x, m_position.y + 1.5, m_position.z);
-    glm::vec3 rayDir = glm::normalize(m_forward) * 3.0f;
-    float dis = 0;
-    glm::ivec3 outBlock;
+    ChunkView view(terrain);
+    RayHit hit;
 
 
-    if (gridMarch(rayPos, rayDir, terrain, &dis, &outBlock)) {
+    if (raycastBlocks(view, rayPos, m_forward, 3.0f, &hit)) {
         collision= true;
-        minDisF = dis;
-        closeBlockF = outBlock;
+        minDisF = hit.distance;
+        closeBlockF = hit.block;
     }
 
     if (collision) {
@@ -441,7 +251,7 @@ glm::vec3 Player::placeBlock(const Terrain &terrain) {
         glm::vec3 fnorm = -1.f * (GetCubeNormal((glm::normalize(look) * 3.f)));
 
         glm::vec3 placement = glm::vec3(closeBlockF.x, closeBlockF.y, closeBlockF.z) + (fnorm);
-        BlockType block = terrain.getGlobalBlockAt(placement.x, placement.y, placement.z);
+        BlockType block = view.getBlockAt(placement.x, placement.y, placement.z);
         if (block != EMPTY || block == WATER || block == LAVA || block == BEDROCK) {
             return glm::vec3(-1, -1, -1);
         } else {
@@ -454,6 +264,24 @@ glm::vec3 Player::placeBlock(const Terrain &terrain) {
 }
 
 
+PlayerState Player::getState() const {
+    return PlayerState{m_position, m_forward, m_right, m_up, m_velocity, flightMode};
+}
+
+void Player::setState(const PlayerState &state) {
+    setPose(state.position, state.forward, state.right, state.up);
+    m_camera.setPose(state.position + glm::vec3(0, 1.5f, 0), state.forward, state.right, state.up);
+    m_velocity = state.velocity;
+    m_acceleration = glm::vec3(0);
+    flightMode = state.flightMode;
+    prevCollisionZ = false;
+    onGround = false;
+    onLava = false;
+    onWater = false;
+    caminLava = false;
+    caminWater = false;
+}
+
 void Player::setCameraWidthHeight(unsigned int w, unsigned int h) {
     m_camera.setWidthHeight(w, h);
 }
@@ -3,6 +3,14 @@
 #include "camera.h"
 #include "terrain.h"
 #include "QSoundEffect"
+
+// Everything needed to put the Player back where it was, so a recorded
+// input trace replays from the same starting point
+struct PlayerState {
+    glm::vec3 position, forward, right, up, velocity;
+    bool flightMode;
+};
+
 class Player : public Entity {
 private:
     glm::vec3 m_velocity, m_acceleration;
@@ -23,7 +31,6 @@ private:
     bool playerMove = false;
 
     //Private helper
-    bool gridMarch(glm::vec3 rayOrigin, glm::vec3 rayDirection, const Terrain &terrain, float *out_dist, glm::ivec3 *out_blockHit);
     glm::vec3 normalizeVelocity();
 
 public:
@@ -57,6 +64,10 @@ public:
     void rotateOnRightGlobal(float degrees) override;
     void rotateOnUpGlobal(float degrees) override;
 
+    PlayerState getState() const;
+    // Also resets the ground and fluid contact flags
+    void setState(const PlayerState &state);
+
     void toggleFlightMode() {
         this->flightMode = !this->flightMode;
     }
@@ -0,0 +1,39 @@
+#include "spatialhash.h"
+
+SpatialHash::SpatialHash(float cellSize)
+    : m_cellSize(cellSize), m_tableMask(0), m_bucketStart(), m_entries(), m_buckets()
+{}
+
+int SpatialHash::bucketOf(glm::ivec3 cell) const {
+    // The usual large primes, see Teschner et al. 2003
+    unsigned int h = (cell.x * 73856093u) ^ (cell.y * 19349663u) ^ (cell.z * 83492791u);
+    return h & m_tableMask;
+}
+
+void SpatialHash::build(const std::vector<glm::vec3> &points) {
+    // About two buckets per point keeps the chains short
+    int tableSize = 1;
+    while (tableSize < 2 * static_cast<int>(points.size())) {
+        tableSize *= 2;
+    }
+    m_tableMask = tableSize - 1;
+    m_bucketStart.assign(tableSize + 1, 0);
+    m_buckets.resize(points.size());
+    m_entries.resize(points.size());
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        m_buckets[i] = bucketOf(glm::ivec3(glm::floor(points[i] / m_cellSize)));
+        ++m_bucketStart[m_buckets[i] + 1];
+    }
+    for (int b = 0; b < tableSize; ++b) {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+    // Fill each bucket from its start, then shift the starts back
+    for (size_t i = 0; i < points.size(); ++i) {
+        m_entries[m_bucketStart[m_buckets[i]]++] = i;
+    }
+    for (int b = tableSize; b > 0; --b) {
+        m_bucketStart[b] = m_bucketStart[b - 1];
+    }
+    m_bucketStart[0] = 0;
+}
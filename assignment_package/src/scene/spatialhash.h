@@ -0,0 +1,56 @@
+#pragma once
+#include <glm_includes.h>
+#include <vector>
+
+// A uniform grid over world space for finding the points near another one
+// without testing every pair. Cells are hashed into a table sized to the
+// number of points and filled by counting sort, so a build is two passes
+// over the points. Each point is filed under the cell it lies in, so to
+// find every box overlapping a box, cells must be at least as large as the
+// distance between the points of two overlapping boxes.
+class SpatialHash {
+private:
+    float m_cellSize;
+    int m_tableMask;
+    std::vector<int> m_bucketStart; // Where each bucket's entries begin, plus one past the last
+    std::vector<int> m_entries;     // Point indices grouped by bucket
+    std::vector<int> m_buckets;     // The bucket of each point, kept between builds
+
+    int bucketOf(glm::ivec3 cell) const;
+
+public:
+    SpatialHash(float cellSize);
+
+    void build(const std::vector<glm::vec3> &points);
+
+    // Calls visit(i) once for every point in the 27 cells around p. Points
+    // from other cells can share a bucket, so callers still test for overlap.
+    template <typename F>
+    void forNeighbors(glm::vec3 p, F visit) const {
+        if (m_entries.empty()) {
+            return;
+        }
+        glm::ivec3 center = glm::ivec3(glm::floor(p / m_cellSize));
+        int seen[27];
+        int seenCount = 0;
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dz = -1; dz <= 1; ++dz) {
+                    int bucket = bucketOf(center + glm::ivec3(dx, dy, dz));
+                    // Two of the cells can hash to the same bucket
+                    bool repeat = false;
+                    for (int i = 0; i < seenCount && !repeat; ++i) {
+                        repeat = seen[i] == bucket;
+                    }
+                    if (repeat) {
+                        continue;
+                    }
+                    seen[seenCount++] = bucket;
+                    for (int e = m_bucketStart[bucket]; e < m_bucketStart[bucket + 1]; ++e) {
+                        visit(m_entries[e]);
+                    }
+                }
+            }
+        }
+    }
+};
@@ -3,6 +3,7 @@
 #include <iostream>
 #include "noise.h"
 #include <stdexcept>
+#include <algorithm>
 #include "chunk.h"
 #include "asset.h"
 
@@ -12,7 +13,7 @@
 
 Terrain::Terrain(OpenGLContext *context)
     : m_chunks(), m_generatedTerrain(), m_geomCube(context),
-    mp_context(context)
+    mp_context(context), m_lightEngine(this)
 {}
 
 Terrain::~Terrain() {
@@ -120,10 +121,18 @@ void Terrain::setGlobalBlockAt(int x, int y, int z, BlockType t)
                            static_cast<unsigned int>(y),
                            static_cast<unsigned int>(z - chunkOrigin.y),
                            t);
-        // Reset VBO data
-        c->destroyVBOdata();
-        c->generateVBOdata();
-        c->createVBOdata();
+        std::unordered_set<Chunk*> relit;
+        m_lightEngine.blockChanged(x, y, z, t, relit);
+        // Reset VBO data of this Chunk, of the Chunks its border shows in and of every Chunk the new light reached
+        relit.insert(c.get());
+        addBorderNeighbors(glm::ivec3(x, y, z), relit);
+        for (Chunk *r : relit) {
+            // Chunks that haven't been meshed yet will pick up the edit and light when they are
+            if (r != c.get() && r->elemCount(INDEX) < 0) continue;
+            r->destroyVBOdata();
+            r->generateVBOdata(r->getMeshLevels());
+            r->createVBOdata();
+        }
 
     } else {
         throw std::out_of_range("Coordinates " + std::to_string(x) +
@@ -132,6 +141,88 @@ void Terrain::setGlobalBlockAt(int x, int y, int z, BlockType t)
     }
 }
 
+void Terrain::addBorderNeighbors(glm::ivec3 world, std::unordered_set<Chunk*> &dirty) const {
+    int x = world.x & 15, z = world.z & 15;
+    if (x != 0 && x != 15 && z != 0 && z != 15) {
+        return;
+    }
+    int cornerX = world.x & ~15, cornerZ = world.z & ~15;
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            int nx = world.x + dx, nz = world.z + dz;
+            if (((nx & ~15) != cornerX || (nz & ~15) != cornerZ) && hasChunkAt(nx, nz)) {
+                dirty.insert(getChunkAt(nx, nz).get());
+            }
+        }
+    }
+}
+
+EditResult Terrain::applyEdits(const BlockEditBuffer &edits, BlockEditRecord *undo) {
+    EditResult result;
+    // Bucket the writes by Chunk as indices into it, in the order the Chunks were first written
+    std::unordered_map<int64_t, std::vector<std::pair<int, BlockType>>> byChunk;
+    std::vector<int64_t> order;
+    for (const BlockEditBuffer::Edit &e : edits.getEdits()) {
+        // A BlockWorker may still be filling the Chunk, and would write over the edit
+        if (e.pos.y < 0 || e.pos.y >= 256 || !hasChunkAt(e.pos.x, e.pos.z) || !getChunkAt(e.pos.x, e.pos.z)->isFilled()) {
+            ++result.skipped;
+            continue;
+        }
+        int chunkX = e.pos.x & ~15, chunkZ = e.pos.z & ~15;
+        int64_t key = toKey(chunkX, chunkZ);
+        std::vector<std::pair<int, BlockType>> &writes = byChunk[key];
+        if (writes.empty()) {
+            order.push_back(key);
+        }
+        writes.push_back(std::make_pair((e.pos.x - chunkX) + 16 * e.pos.y + 16 * 256 * (e.pos.z - chunkZ), e.type));
+    }
+
+    std::vector<std::pair<glm::ivec3, BlockType>> changes;
+    std::unordered_set<Chunk*> dirty;
+    for (int64_t key : order) {
+        std::vector<std::pair<int, BlockType>> &writes = byChunk[key];
+        // Stable, so the last write to a block comes last among the writes to it
+        std::stable_sort(writes.begin(), writes.end(),
+                         [](const std::pair<int, BlockType> &a, const std::pair<int, BlockType> &b) {
+                             return a.first < b.first;
+                         });
+        glm::ivec2 corner = toCoords(key);
+        Chunk *c = getChunkAt(corner.x, corner.y).get();
+        for (size_t i = 0; i < writes.size(); ++i) {
+            if (i + 1 < writes.size() && writes[i + 1].first == writes[i].first) continue;
+            int index = writes[i].first;
+            int x = index & 15, y = (index >> 4) & 255, z = index >> 12;
+            BlockType prev = c->getLocalBlockAt(x, y, z);
+            BlockType t = writes[i].second;
+            if (prev == t) continue;
+            c->setLocalBlockAt(x, y, z, t);
+            if (undo) {
+                undo->addBlock(corner, index, prev);
+            }
+            glm::ivec3 world(corner.x + x, y, corner.y + z);
+            changes.push_back(std::make_pair(world, t));
+            dirty.insert(c);
+            addBorderNeighbors(world, dirty);
+        }
+    }
+    result.changed = changes.size();
+
+    m_lightEngine.blocksChanged(changes, dirty);
+    for (Chunk *c : dirty) {
+        // Chunks that haven't been meshed yet will pick up the edits when they are
+        if (c->elemCount(INDEX) < 0) continue;
+        c->destroyVBOdata();
+        c->generateVBOdata(c->getMeshLevels());
+        c->createVBOdata();
+        ++result.remeshed;
+    }
+    return result;
+}
+
+void Terrain::chunkLit(Chunk *c, std::unordered_set<Chunk*> &relit) {
+    m_lightEngine.chunkLit(c, relit);
+}
+
 Chunk* Terrain::instantiateChunkAt(int x, int z) {
     uPtr<Chunk> chunk = mkU<Chunk>(x, z, mp_context);
     Chunk *cPtr = chunk.get();
@@ -160,29 +251,137 @@ Chunk* Terrain::instantiateChunkAt(int x, int z) {
 }
 
 
-void Terrain::draw(int minX, int maxX, int minZ, int maxZ, ShaderProgram *shaderProgram) {
+// Distance from the viewer to a chunk's center beyond which the
+// chunk is drawn with its 2x, 4x and 8x LOD mesh respectively. Each
+// ring is as wide as the full detail disc but has a quarter of the
+// vertices per chunk of the one inside it, so the 8x ring out to
+// VIEW_RADIUS costs less than the full detail chunks.
+const static std::array<float, LOD_LEVELS> lodDistances {
+    96.f, 192.f, 288.f
+};
+
+static int getLODLevelAt(float dist) {
+    int level = 0;
+    while (level < LOD_LEVELS && dist > lodDistances[level]) {
+        ++level;
+    }
+    return level;
+}
+
+int Terrain::getLODLevel(const Chunk &chunk, glm::vec3 viewPos) const {
+    glm::vec2 center = glm::vec2(chunk.getMin()) + glm::vec2(8.f, 8.f);
+    return getLODLevelAt(glm::length(center - glm::vec2(viewPos.x, viewPos.z)));
+}
+
+int Terrain::getWantedMeshLevels(glm::ivec2 chunkMin, glm::vec2 center, float margin) const {
+    float dist = glm::length(glm::vec2(chunkMin) + glm::vec2(8.f, 8.f) - center);
+    int levels = 0;
+    for (int level = getLODLevelAt(dist - margin); level <= getLODLevelAt(dist + margin); ++level) {
+        levels |= 1 << level;
+    }
+    return levels;
+}
+
+int Terrain::getDrawLevel(const Chunk &chunk, glm::vec3 viewPos) const {
+    int level = getLODLevel(chunk, viewPos);
+    int built = chunk.getMeshLevels();
+    // Prefer the finer of two levels equally far away
+    for (int d = 0; d <= LOD_LEVELS; ++d) {
+        if (level - d >= 0 && (built & (1 << (level - d)))) {
+            return level - d;
+        }
+        if (level + d <= LOD_LEVELS && (built & (1 << (level + d)))) {
+            return level + d;
+        }
+    }
+    return -1;
+}
+
+void Terrain::draw(int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, ShaderProgram *shaderProgram) {
     // Draw Solid Blocks First
+    drawOpaque(minX, maxX, minZ, maxZ, viewPos, shaderProgram);
+    drawTransparent(minX, maxX, minZ, maxZ, viewPos, shaderProgram);
+}
+
+void Terrain::drawOpaque(int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, ShaderProgram *shaderProgram) {
+    std::vector<Chunk*> chunks = getMeshedChunks(minX, maxX, minZ, maxZ);
+    sortFrontToBack(chunks, viewPos);
+    drawSolid(chunks, viewPos, shaderProgram);
+}
+
+void Terrain::sortFrontToBack(std::vector<Chunk*> &chunks, glm::vec3 viewPos) {
+    std::vector<std::pair<float, Chunk*>> sorted;
+    sorted.reserve(chunks.size());
+    for (Chunk *chunk : chunks) {
+        glm::vec2 offset = glm::vec2(chunk->getMin()) + glm::vec2(8.f) - glm::vec2(viewPos.x, viewPos.z);
+        sorted.push_back(std::pair(glm::dot(offset, offset), chunk));
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<float, Chunk*> &a, const std::pair<float, Chunk*> &b) { return a.first < b.first; });
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        chunks[i] = sorted[i].second;
+    }
+}
+
+std::vector<Chunk*> Terrain::getMeshedChunks(int minX, int maxX, int minZ, int maxZ) const {
+    std::vector<Chunk*> chunks;
     for(int x = minX; x < maxX; x += 16) {
         for(int z = minZ; z < maxZ; z += 16) {
             if (hasChunkAt(x, z)) {
                 const uPtr<Chunk> &chunk = getChunkAt(x, z);
-                if (chunk->elemCount(INDEX) > 0) {
-                    shaderProgram->drawInterleaved(*chunk, false);
+                if (chunk->elemCount(INDEX) > 0 || chunk->elemCount(LOD_INDEX) > 0) {
+                    chunks.push_back(chunk.get());
                 }
             }
         }
     }
-    // Draw Transparent Blocks After
+    return chunks;
+}
+
+void Terrain::drawSolid(const std::vector<Chunk*> &chunks, glm::vec3 viewPos, ShaderProgram *shaderProgram) {
+    for (Chunk *chunk : chunks) {
+        int level = getDrawLevel(*chunk, viewPos);
+        if (level < 0) {
+            continue;
+        } else if (level == 0) {
+            if (chunk->elemCount(INDEX) > 0) {
+                shaderProgram->drawInterleaved(*chunk, false);
+            }
+        } else if (chunk->elemCount(LOD_INDEX) > 0) {
+            glm::ivec2 range = chunk->getLODRange(level);
+            shaderProgram->drawInterleavedRange(*chunk, LOD_INTERLEAVED, LOD_INDEX, range.x, range.y);
+        }
+    }
+}
+
+void Terrain::drawTransparent(int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, ShaderProgram *shaderProgram) {
+    // Draw Transparent Blocks After, farthest chunk first so they blend
+    // over each other correctly. LOD meshes have no transparent part.
+    std::vector<std::pair<float, Chunk*>> transparentChunks;
     for(int x = minX; x < maxX; x += 16) {
         for(int z = minZ; z < maxZ; z += 16) {
             if (hasChunkAt(x, z)) {
                 const uPtr<Chunk> &chunk = getChunkAt(x, z);
-                if (chunk->elemCount(TRANSPARENT_INDEX) > 0) {
-                    shaderProgram->drawInterleaved(*chunk, true);
+                if (getDrawLevel(*chunk, viewPos) == 0 &&
+                    (chunk->elemCount(TRANSPARENT_INDEX) > 0 || chunk->elemCount(FLUID_INDEX) > 0)) {
+                    glm::vec2 offset = glm::vec2(chunk->getMin()) + glm::vec2(8.f) - glm::vec2(viewPos.x, viewPos.z);
+                    transparentChunks.push_back(std::pair(glm::dot(offset, offset), chunk.get()));
                 }
             }
         }
     }
+    std::sort(transparentChunks.begin(), transparentChunks.end(),
+              [](const std::pair<float, Chunk*> &a, const std::pair<float, Chunk*> &b) { return a.first > b.first; });
+    for (auto &entry : transparentChunks) {
+        Chunk *chunk = entry.second;
+        // Water sits below any ice, so it goes first
+        if (chunk->elemCount(FLUID_INDEX) > 0) {
+            shaderProgram->drawInterleavedRange(*chunk, FLUID_INTERLEAVED, FLUID_INDEX, 0, chunk->elemCount(FLUID_INDEX));
+        }
+        if (chunk->elemCount(TRANSPARENT_INDEX) > 0) {
+            shaderProgram->drawInterleaved(*chunk, true);
+        }
+    }
 }
 
 float Terrain::mapToUnitInterval(float x, float min, float max) const {
@@ -290,6 +489,13 @@ BlockType Terrain::getBlockType(BiomeType b, int y, int top) const {
     }
 }
 
+float Terrain::getSurfaceHeight(float x, float z, BiomeType *biome) const {
+    float moisture = getMoisture(x, z);
+    float temperature = getTemperature(x, z);
+    *biome = getBiomeType(moisture, temperature);
+    return getTerrainHeight(x, z, moisture, temperature);
+}
+
 BiomeType Terrain::getBiomeType(float moisture, float temp) const {
     if (moisture < 0.5) {
         return (temp < 0.5) ? MOUNTAIN : DESERT;
@@ -403,6 +609,7 @@ void Terrain::fillChunk(Chunk* c, int x, int z) const {
             }
         }
     }
+    c->markFilled();
 }
 
 bool Terrain::makeGrass(int x, int y, int z) const {
@@ -6,6 +6,8 @@
 #include <unordered_set>
 #include "shaderprogram.h"
 #include "cube.h"
+#include "lightengine.h"
+#include "blockedits.h"
 #include <unordered_set>
 
 
@@ -14,6 +16,17 @@ enum BiomeType : unsigned char
     MOUNTAIN, GRASSLAND, DESERT, SNOWY_PLAINS
 };
 
+// What Terrain::applyEdits did
+struct EditResult {
+    size_t changed = 0;  // Blocks that ended up a different type
+    size_t skipped = 0;  // Writes outside the world or the loaded and filled Chunks
+    size_t remeshed = 0; // Chunks whose meshes were rebuilt
+};
+
+// Chunks are loaded and drawn out to this many blocks from the viewer, the
+// last LOD level's ring ending there. Beyond it the Horizon takes over.
+const static int VIEW_RADIUS = 384;
+
 // Helper functions to convert (x, z) to and from hash map key
 int64_t toKey(int x, int z);
 glm::ivec2 toCoords(int64_t k);
@@ -51,6 +64,11 @@ private:
 
     OpenGLContext* mp_context;
 
+    // Relights the world around edited blocks
+    LightEngine m_lightEngine;
+    // Blocks on the border of a Chunk also show in the faces and ambient
+    // occlusion of the Chunks around. Adds those Chunks of a block at world to dirty.
+    void addBorderNeighbors(glm::ivec3 world, std::unordered_set<Chunk*> &dirty) const;
 
     // Helper Methods
     float mapToUnitInterval(float x, float min, float max) const;
@@ -105,15 +123,46 @@ public:
     // values) return the block stored at that point in space.
     BlockType getGlobalBlockAt(int x, int y, int z) const;
     BlockType getGlobalBlockAt(glm::vec3 p) const;
+    // Evaluates the generated surface height and biome of a world-space
+    // column without needing a Chunk there (used by the far-field horizon)
+    float getSurfaceHeight(float x, float z, BiomeType *biome) const;
     // Given a world-space coordinate (which may have negative
     // values) set the block at that point in space to the
     // given type.
     void setGlobalBlockAt(int x, int y, int z, BlockType t);
+    // Applies a batch of writes Chunk by Chunk, then relights around all of
+    // them at once and remeshes every Chunk they or the new light reached a
+    // single time. Writes to Chunks that aren't loaded, or are still being
+    // filled, are skipped rather than thrown on. If undo is given, what was
+    // overwritten is added to it.
+    EditResult applyEdits(const BlockEditBuffer &edits, BlockEditRecord *undo = nullptr);
+    // Joins the light of a freshly generated Chunk up with its neighbors', see
+    // LightEngine::chunkLit. Main thread only.
+    void chunkLit(Chunk *c, std::unordered_set<Chunk*> &relit);
 
     // Draws every Chunk that falls within the bounding box
     // described by the min and max coords, using the provided
-    // ShaderProgram
-    void draw(int minX, int maxX, int minZ, int maxZ, ShaderProgram *shaderProgram);
+    // ShaderProgram. Chunks far from viewPos use their LOD meshes.
+    void draw(int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, ShaderProgram *shaderProgram);
+    // The two halves of draw: the solid and LOD meshes sorted front to
+    // back, then the water and transparent meshes sorted back to front
+    void drawOpaque(int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, ShaderProgram *shaderProgram);
+    void drawTransparent(int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, ShaderProgram *shaderProgram);
+    // Every Chunk within the bounds that has a solid or LOD mesh, for
+    // passes such as the shadow maps that cull the Chunks their own way
+    std::vector<Chunk*> getMeshedChunks(int minX, int maxX, int minZ, int maxZ) const;
+    // Draws the solid meshes of the given Chunks, or their LOD meshes if they are far from viewPos
+    void drawSolid(const std::vector<Chunk*> &chunks, glm::vec3 viewPos, ShaderProgram *shaderProgram);
+    // Nearest Chunk first, so the depth test throws away more of what lies behind
+    static void sortFrontToBack(std::vector<Chunk*> &chunks, glm::vec3 viewPos);
+    // Which mesh a chunk should be drawn with, 0 being full detail
+    int getLODLevel(const Chunk &chunk, glm::vec3 viewPos) const;
+    // The meshes, as a MESH_FULL mask, the chunk with the given corner can be
+    // drawn with while the viewer stays within margin blocks of center
+    int getWantedMeshLevels(glm::ivec2 chunkMin, glm::vec2 center, float margin) const;
+    // getLODLevel, or the nearest level the chunk has buffered while the one it
+    // wants is still being meshed. -1 if it has none.
+    int getDrawLevel(const Chunk &chunk, glm::vec3 viewPos) const;
 
     //0 for grass, 1 for desert, 2 mountain
     int currBiome = -1;
@@ -69,6 +69,12 @@ void ShaderProgram::create(const char *vertfile, const char *fragfile)
 
 }
 
+// The name of a uniform declared as token, without its ';' or array size
+static QString uniformName(const QString &token) {
+    QString name = token.left(token.indexOf(";"));
+    return name.left(name.indexOf("["));
+}
+
 // This function examines each line of the vertex and fragment shader source
 // code for lines that begin with "uniform" or "in", then creates a CPU-side
 // handle for that uniform or attribute variable.
@@ -76,12 +82,13 @@ void ShaderProgram::parseShaderSourceForVariables(char *vertSource, char *fragSo
     QString vs(vertSource);
     QString fs(fragSource);
 
-    // Parse the uniforms and ins of the vertex shader
+    // Parse the uniforms and ins of the vertex shader. Arrays are
+    // looked up by their name alone, which finds their first element.
     QStringList vs_list = vs.split("\n", Qt::SkipEmptyParts);
     for(QString &line : vs_list) {
         QStringList sub = line.split(" ", Qt::SkipEmptyParts);
         if(sub[0] == "uniform") {
-            this->addUniform(sub[2].left(sub[2].indexOf(";")).toStdString().c_str());
+            this->addUniform(uniformName(sub[2]).toStdString().c_str());
         }
         if(sub[0] == "in") {
             this->addAttrib(sub[2].left(sub[2].indexOf(";")).toStdString().c_str());
@@ -92,7 +99,7 @@ void ShaderProgram::parseShaderSourceForVariables(char *vertSource, char *fragSo
     for(QString &line : fs_list) {
         QStringList sub = line.split(" ", Qt::SkipEmptyParts);
         if(sub[0] == "uniform") {
-            this->addUniform(sub[2].left(sub[2].indexOf(";")).toStdString().c_str());
+            this->addUniform(uniformName(sub[2]).toStdString().c_str());
         }
     }
 }
@@ -113,6 +120,19 @@ void ShaderProgram::setUnifMat4(std::string name, const glm::mat4 &m) {
         std::cout << "Error: could not find shader variable with name " << name << std::endl;
     }
 }
+void ShaderProgram::setUnifMat4Array(std::string name, const glm::mat4 *m, int count) {
+    useMe();
+    try {
+        int handle = m_unifs.at(name);
+        if(handle != -1) {
+            context->glUniformMatrix4fv(handle, count, GL_FALSE, &m[0][0][0]);
+        }
+    }
+    catch(std::out_of_range &e) {
+        std::cout << "Error: could not find shader variable with name " << name << std::endl;
+    }
+}
+
 void ShaderProgram::setUnifVec2(std::string name, const glm::vec2 &v) {
     useMe();
     try {
@@ -219,11 +239,20 @@ void ShaderProgram::draw(Drawable &d) {
 }
 
 void ShaderProgram::drawInterleaved(Drawable &d, bool isTransparent) {
-    useMe();
-
     BufferType buffer = isTransparent ? TRANSPARENT_INTERLEAVED : INTERLEAVED;
     BufferType index = isTransparent ? TRANSPARENT_INDEX : INDEX;
 
+    if(d.elemCount(index) < 0) {
+        throw std::invalid_argument(
+            "Attempting to draw a Drawable that has not initialized its count variable! Remember to set it to the length of your index array in create()."
+            );
+    }
+    drawInterleavedRange(d, buffer, index, 0, d.elemCount(index));
+}
+
+void ShaderProgram::drawInterleavedRange(Drawable &d, BufferType buffer, BufferType index, int first, int count) {
+    useMe();
+
     if(d.elemCount(index) < 0) {
         throw std::invalid_argument(
             "Attempting to draw a Drawable that has not initialized its count variable! Remember to set it to the length of your index array in create()."
@@ -249,7 +278,7 @@ void ShaderProgram::drawInterleaved(Drawable &d, bool isTransparent) {
     // Bind the index buffer and then draw shapes from it.
     // This invokes the shader program, which accesses the vertex buffers.
     d.bindBuffer(index);
-    context->glDrawElements(d.drawMode(), d.elemCount(index), GL_UNSIGNED_INT, 0);
+    context->glDrawElements(d.drawMode(), count, GL_UNSIGNED_INT, (void*)(first * sizeof(GLuint)));
 
     if (m_attribs["vs_Pos"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_Pos"]);
     if (m_attribs["vs_Nor"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_Nor"]);
@@ -279,6 +308,12 @@ void ShaderProgram::drawInstanced(InstancedDrawable &d) {
         context->glVertexAttribDivisor(handle, 0);
     }
 
+    if ((handle = m_attribs["vs_UV"]) != -1 && d.bindBuffer(UV)) {
+        context->glEnableVertexAttribArray(handle);
+        context->glVertexAttribPointer(handle, 4, GL_FLOAT, false, 0, nullptr);
+        context->glVertexAttribDivisor(handle, 0);
+    }
+
     if ((handle = m_attribs["vs_ColInstanced"]) != -1 && d.bindBuffer(COLOR)) {
         context->glEnableVertexAttribArray(handle);
         context->glVertexAttribPointer(handle, 3, GL_FLOAT, false, 0, nullptr);
@@ -291,6 +326,17 @@ void ShaderProgram::drawInstanced(InstancedDrawable &d) {
         context->glVertexAttribDivisor(handle, 1);
     }
 
+    if ((handle = m_attribs["vs_ShapeInstanced"]) != -1) {
+        if (d.bindBuffer(INSTANCED_SHAPE)) {
+            context->glEnableVertexAttribArray(handle);
+            context->glVertexAttribPointer(handle, 4, GL_FLOAT, false, 0, nullptr);
+            context->glVertexAttribDivisor(handle, 1);
+        } else {
+            // A unit cube with layer 0 for every instance
+            context->glVertexAttrib4f(handle, 1.f, 1.f, 1.f, 0.f);
+        }
+    }
+
     // Bind the index buffer and then draw shapes from it.
     // This invokes the shader program, which accesses the vertex buffers.
     d.bindBuffer(INDEX);
@@ -298,8 +344,10 @@ void ShaderProgram::drawInstanced(InstancedDrawable &d) {
 
     if (m_attribs["vs_Pos"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_Pos"]);
     if (m_attribs["vs_Nor"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_Nor"]);
+    if (m_attribs["vs_UV"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_UV"]);
     if (m_attribs["vs_ColInstanced"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_ColInstanced"]);
     if (m_attribs["vs_OffsetInstanced"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_OffsetInstanced"]);
+    if (m_attribs["vs_ShapeInstanced"] != -1) context->glDisableVertexAttribArray(m_attribs["vs_ShapeInstanced"]);
 
     context->printGLErrorLog();
 }
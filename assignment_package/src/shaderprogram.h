@@ -39,6 +39,8 @@ public:
     void parseShaderSourceForVariables(char *vertSource, char *fragSource);
 
     void setUnifMat4(std::string name, const glm::mat4 &m);
+    // Sets count matrices of a mat4 array, starting from its first element
+    void setUnifMat4Array(std::string name, const glm::mat4 *m, int count);
     void setUnifVec2(std::string name, const glm::vec2 &v);
     void setUnifVec3(std::string name, const glm::vec3 &v);
     void setUnifFloat(std::string name, float f);
@@ -48,6 +50,8 @@ public:
     // Draw the given object to our screen using this ShaderProgram's shaders
     void draw(Drawable &d);
     void drawInterleaved(Drawable &d, bool isTransparent);
+    // Draw count indices of the given index buffer, starting at index first
+    void drawInterleavedRange(Drawable &d, BufferType buffer, BufferType index, int first, int count);
     void drawInstanced(InstancedDrawable &d);
     // Utility function used in create()
     char* textFileRead(const char*);
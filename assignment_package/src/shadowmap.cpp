@@ -0,0 +1,182 @@
+#include "shadowmap.h"
+#include <cmath>
+#include <iostream>
+
+// How far towards the sun the light's eye sits from a cascade's center. It
+// has to reach past the tallest blocks that could cast into the cascade.
+const static float sunDistance = 400.f;
+// A cached cascade is drawn again once the sun has moved this far (0.25 degrees)
+const static float sunMoveThreshold = 0.99999f;
+
+ShadowMap::ShadowMap(OpenGLContext *context)
+    : mp_context(context), m_frameBuffer(-1), m_depthTexture(-1), m_created(false),
+      m_cascades(), m_sunUp(false), m_redraws(0)
+{
+    // Near cascade follows the camera, the far ones move in steps of a quarter of their size
+    m_cascades[0] = {24.f, 0.f, glm::mat4(), glm::vec3(), glm::vec3(), 0, false};
+    m_cascades[1] = {64.f, 16.f, glm::mat4(), glm::vec3(), glm::vec3(), 0, false};
+    m_cascades[2] = {160.f, 32.f, glm::mat4(), glm::vec3(), glm::vec3(), 0, false};
+}
+
+void ShadowMap::create() {
+    mp_context->glGenFramebuffers(1, &m_frameBuffer);
+    mp_context->glGenTextures(1, &m_depthTexture);
+
+    mp_context->glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+    mp_context->glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, SIZE, SIZE, CASCADES,
+                             0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    // Linear filtering with comparison gives 2x2 percentage closer filtering for free
+    mp_context->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    mp_context->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    mp_context->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    mp_context->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    mp_context->glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    mp_context->glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, 0);
+    // Depth only, there is no color to write
+    GLenum none = GL_NONE;
+    mp_context->glDrawBuffers(1, &none);
+    mp_context->glReadBuffer(GL_NONE);
+
+    m_created = true;
+    if (mp_context->glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        m_created = false;
+        std::cout << "Shadow map frame buffer did not initialize correctly..." << std::endl;
+        mp_context->printGLErrorLog();
+    }
+    for (Cascade &c : m_cascades) {
+        c.valid = false;
+    }
+}
+
+void ShadowMap::destroy() {
+    if (m_created) {
+        m_created = false;
+        mp_context->glDeleteFramebuffers(1, &m_frameBuffer);
+        mp_context->glDeleteTextures(1, &m_depthTexture);
+    }
+}
+
+glm::vec3 ShadowMap::sunDirection(int time) {
+    // A full day takes 60 * 60 * 24 ticks and starts with the sun overhead
+    double angle = std::fmod(time * (2.0 * M_PI / (60 * 60 * 24)) + M_PI / 2.0, 2.0 * M_PI);
+    return glm::vec3(std::cos(angle), std::sin(angle), 0.f);
+}
+
+glm::mat4 ShadowMap::computeViewProj(glm::vec3 center, glm::vec3 sunDir, float radius) const {
+    // The sun moves in the xy plane, so z is never parallel to it
+    glm::mat4 view = glm::lookAt(sunDir * sunDistance, glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+    glm::vec4 c = view * glm::vec4(center, 1.f);
+    float texel = 2.f * radius / SIZE;
+    c.x = glm::floor(c.x / texel) * texel;
+    c.y = glm::floor(c.y / texel) * texel;
+    return glm::ortho(c.x - radius, c.x + radius, c.y - radius, c.y + radius,
+                      -c.z - sunDistance, -c.z + sunDistance) * view;
+}
+
+std::vector<Chunk*> ShadowMap::cullChunks(const std::vector<Chunk*> &chunks, const glm::mat4 &viewProj, uint64_t &signature) const {
+    std::vector<Chunk*> casters;
+    signature = 1469598103934665603ull;
+    for (Chunk *chunk : chunks) {
+        glm::ivec2 min = chunk->getMin();
+        glm::ivec2 heights = chunk->getSolidHeights();
+        if (heights.y < heights.x) continue;
+        // Project the Chunk's bounding box and test it against the cascade's square.
+        // Anything between the square and the sun casts into it, so depth is not tested.
+        glm::vec2 lo(1e9f), hi(-1e9f);
+        for (int i = 0; i < 8; ++i) {
+            glm::vec4 corner(min.x + (i & 1 ? 16 : 0), i & 2 ? heights.y + 1 : heights.x, min.y + (i & 4 ? 16 : 0), 1.f);
+            glm::vec4 p = viewProj * corner;
+            lo = glm::min(lo, glm::vec2(p));
+            hi = glm::max(hi, glm::vec2(p));
+        }
+        if (hi.x < -1.f || lo.x > 1.f || hi.y < -1.f || lo.y > 1.f) continue;
+        casters.push_back(chunk);
+        signature = (signature ^ reinterpret_cast<uintptr_t>(chunk)) * 1099511628211ull;
+        signature = (signature ^ static_cast<uint64_t>(chunk->getMeshVersion())) * 1099511628211ull;
+    }
+    return casters;
+}
+
+void ShadowMap::drawCascade(int cascade, const std::vector<Chunk*> &casters, Terrain &terrain, glm::vec3 viewPos, ShaderProgram &depthProgram) {
+    mp_context->glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, cascade);
+    mp_context->glClear(GL_DEPTH_BUFFER_BIT);
+    depthProgram.setUnifMat4("u_ViewProj", m_cascades[cascade].viewProj);
+    terrain.drawSolid(casters, viewPos, &depthProgram);
+    ++m_redraws;
+}
+
+void ShadowMap::render(Terrain &terrain, int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, int time,
+                       ShaderProgram &depthProgram) {
+    m_redraws = 0;
+    glm::vec3 sunDir = sunDirection(time);
+    // Nothing casts a shadow once the sun is below the horizon
+    m_sunUp = m_created && sunDir.y > 0.05f;
+    if (!m_sunUp) {
+        for (Cascade &c : m_cascades) {
+            c.valid = false;
+        }
+        return;
+    }
+
+    std::vector<Chunk*> chunks = terrain.getMeshedChunks(minX, maxX, minZ, maxZ);
+    mp_context->glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    mp_context->glViewport(0, 0, SIZE, SIZE);
+    // Push the depths back a little so lit faces don't shadow themselves
+    mp_context->glEnable(GL_POLYGON_OFFSET_FILL);
+    mp_context->glPolygonOffset(2.f, 4.f);
+
+    // Only one cached cascade may be drawn per frame. One that is out of
+    // date still shows the right shadows for the area it was drawn over.
+    bool cachedDrawn = false;
+    for (int i = 0; i < CASCADES; ++i) {
+        Cascade &c = m_cascades[i];
+        glm::vec3 center = viewPos;
+        if (c.snap > 0.f) {
+            center = glm::floor(viewPos / c.snap) * c.snap + glm::vec3(c.snap / 2.f);
+        }
+        uint64_t signature;
+        if (c.snap > 0.f && c.valid) {
+            if (cachedDrawn) continue;
+            if (center == c.center && glm::dot(sunDir, c.sunDir) > sunMoveThreshold) {
+                // Same cell under the same sun, only a remeshed Chunk can change it
+                std::vector<Chunk*> casters = cullChunks(chunks, c.viewProj, signature);
+                if (signature != c.signature) {
+                    drawCascade(i, casters, terrain, viewPos, depthProgram);
+                    c.signature = signature;
+                    cachedDrawn = true;
+                }
+                continue;
+            }
+            cachedDrawn = true;
+        }
+        c.viewProj = computeViewProj(center, sunDir, c.radius);
+        c.center = center;
+        c.sunDir = sunDir;
+        std::vector<Chunk*> casters = cullChunks(chunks, c.viewProj, signature);
+        drawCascade(i, casters, terrain, viewPos, depthProgram);
+        c.signature = signature;
+        c.valid = true;
+    }
+
+    mp_context->glDisable(GL_POLYGON_OFFSET_FILL);
+}
+
+void ShadowMap::bindToTextureSlot(unsigned int slot) {
+    mp_context->glActiveTexture(GL_TEXTURE0 + slot);
+    mp_context->glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+}
+
+bool ShadowMap::isSunUp() const {
+    return m_sunUp;
+}
+
+const glm::mat4& ShadowMap::getViewProj(int cascade) const {
+    return m_cascades[cascade].viewProj;
+}
+
+int ShadowMap::getRedrawCount() const {
+    return m_redraws;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "openglcontext.h"
+#include "glm_includes.h"
+#include "shaderprogram.h"
+#include "scene/terrain.h"
+#include <array>
+
+// Cascaded shadow maps for the sun, stored as the layers of one depth
+// texture array. Every cascade is a square, seen from the sun, centered on
+// the camera and covering a wider area at the same resolution than the one
+// before it. The nearest cascade is drawn every frame. The farther ones are
+// kept from frame to frame and only drawn again once the camera has left
+// their grid cell, the sun has moved by more than a small angle, or one of
+// the Chunks they cover has been remeshed, and at most one of them per frame.
+class ShadowMap {
+public:
+    const static int CASCADES = 3;
+    const static int SIZE = 2048;
+
+private:
+    struct Cascade {
+        float radius;       // Half the width of the square the cascade covers
+        float snap;         // Grid the center of a cached cascade moves on, 0 to follow the camera
+        glm::mat4 viewProj;
+        glm::vec3 center;
+        glm::vec3 sunDir;   // The sun direction the cascade was last drawn with
+        uint64_t signature; // Hash of the Chunks and mesh versions it was last drawn with
+        bool valid;
+    };
+
+    OpenGLContext *mp_context;
+    GLuint m_frameBuffer;
+    GLuint m_depthTexture;
+    bool m_created;
+    std::array<Cascade, CASCADES> m_cascades;
+    bool m_sunUp;
+    int m_redraws; // Cascades drawn during the last render
+
+    // The sun's view and an orthographic box around center, moved by whole
+    // texels so the shadows of still geometry don't shimmer as the camera moves
+    glm::mat4 computeViewProj(glm::vec3 center, glm::vec3 sunDir, float radius) const;
+    // The Chunks whose solid meshes fall inside a cascade seen from the sun
+    std::vector<Chunk*> cullChunks(const std::vector<Chunk*> &chunks, const glm::mat4 &viewProj, uint64_t &signature) const;
+    void drawCascade(int cascade, const std::vector<Chunk*> &casters, Terrain &terrain, glm::vec3 viewPos, ShaderProgram &depthProgram);
+
+public:
+    ShadowMap(OpenGLContext *context);
+
+    void create();
+    void destroy();
+
+    // The direction towards the sun at the given time, the same as
+    // computeSunDirection in lambert.vert.glsl
+    static glm::vec3 sunDirection(int time);
+
+    // Brings the cascades up to date for the camera at viewPos, drawing
+    // the Chunks within the given bounds with depthProgram
+    void render(Terrain &terrain, int minX, int maxX, int minZ, int maxZ, glm::vec3 viewPos, int time,
+                ShaderProgram &depthProgram);
+    // Binds the depth texture array with depth comparison turned on
+    void bindToTextureSlot(unsigned int slot);
+
+    // False at night, when nothing has been drawn and nothing should be shadowed
+    bool isSunUp() const;
+    const glm::mat4& getViewProj(int cascade) const;
+    int getRedrawCount() const;
+};
@@ -0,0 +1,71 @@
+#include "skylut.h"
+#include <cstdlib>
+#include <iostream>
+
+SkyLUT::SkyLUT(OpenGLContext *context)
+    : mp_context(context), m_frameBuffer(-1), m_texture(-1), m_created(false),
+      m_bakedTime(0), m_valid(false)
+{}
+
+void SkyLUT::create() {
+    mp_context->glGenFramebuffers(1, &m_frameBuffer);
+    mp_context->glGenTextures(1, &m_texture);
+
+    mp_context->glBindTexture(GL_TEXTURE_2D, m_texture);
+    mp_context->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, WIDTH, HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    // The sky is smooth, so blend between texels. The azimuth wraps around.
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    mp_context->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    mp_context->glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    mp_context->glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_texture, 0);
+    GLenum drawBuffers[1] = {GL_COLOR_ATTACHMENT0};
+    mp_context->glDrawBuffers(1, drawBuffers);
+
+    m_created = true;
+    if (mp_context->glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        m_created = false;
+        std::cout << "Sky LUT frame buffer did not initialize correctly..." << std::endl;
+        mp_context->printGLErrorLog();
+    }
+    m_valid = false;
+}
+
+void SkyLUT::destroy() {
+    if (m_created) {
+        m_created = false;
+        mp_context->glDeleteFramebuffers(1, &m_frameBuffer);
+        mp_context->glDeleteTextures(1, &m_texture);
+    }
+}
+
+bool SkyLUT::isStale(int time) const {
+    return m_created && (!m_valid || std::abs(time - m_bakedTime) >= REFRESH_TICKS);
+}
+
+bool SkyLUT::update(int time, ShaderProgram &bakeProgram, Quad &quad) {
+    if (!isStale(time)) {
+        return false;
+    }
+    mp_context->glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    mp_context->glViewport(0, 0, WIDTH, HEIGHT);
+    // There is no depth buffer to test against, and every texel is written
+    mp_context->glDisable(GL_BLEND);
+    bakeProgram.setUnifInt("u_Time", time);
+    bakeProgram.draw(quad);
+    mp_context->glEnable(GL_BLEND);
+    m_bakedTime = time;
+    m_valid = true;
+    return true;
+}
+
+void SkyLUT::invalidate() {
+    m_valid = false;
+}
+
+void SkyLUT::bindToTextureSlot(unsigned int slot) {
+    mp_context->glActiveTexture(GL_TEXTURE0 + slot);
+    mp_context->glBindTexture(GL_TEXTURE_2D, m_texture);
+}
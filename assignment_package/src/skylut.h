@@ -0,0 +1,42 @@
+#pragma once
+#include "openglcontext.h"
+#include "shaderprogram.h"
+#include "quad.h"
+
+// The sky's color in every direction, baked into a small 2D texture by
+// skylut.frag.glsl. Columns go around the horizon starting at -x, rows go
+// from straight down to straight up; see skyLUTCoord in sky.frag.glsl.
+// The sun always moves in the xy plane, so the azimuth is also the angle
+// from the sun's path. The sky pass and the fog of the terrain and horizon
+// shaders read it instead of working out the sky per pixel.
+class SkyLUT {
+public:
+    const static int WIDTH = 256;  // Azimuth
+    const static int HEIGHT = 128; // Elevation
+    // The sky is baked again once time has moved on by this many ticks
+    const static int REFRESH_TICKS = 4;
+
+private:
+    OpenGLContext *mp_context;
+    GLuint m_frameBuffer;
+    GLuint m_texture;
+    bool m_created;
+    int m_bakedTime;
+    bool m_valid;
+
+public:
+    SkyLUT(OpenGLContext *context);
+
+    void create();
+    void destroy();
+
+    // Bakes the sky at the given time with bakeProgram if it is out of date.
+    // Leaves the LUT's frame buffer bound and the viewport at its size.
+    // Returns whether it baked.
+    bool update(int time, ShaderProgram &bakeProgram, Quad &quad);
+    // Whether update would bake at this time
+    bool isStale(int time) const;
+    // Bakes again on the next update, for when the bake shader's inputs change
+    void invalidate();
+    void bindToTextureSlot(unsigned int slot);
+};
@@ -0,0 +1,33 @@
+#include "sortworker.h"
+#include "profiler.h"
+#include <algorithm>
+#include <numeric>
+
+SortWorker::SortWorker(Chunk *chunk, glm::vec3 viewPos, QMutex *mutex, std::vector<SortedFaces> *sorted)
+    : chunk(chunk), centers(chunk->getTransparentCenters()), quads(chunk->getTransparentIndices()), version(chunk->getMeshVersion()),
+      viewPos(viewPos), sortMutex(mutex), sorted(sorted)
+{}
+
+void SortWorker::run() {
+    PROFILE_SCOPE("sort chunk");
+    std::vector<float> dist(centers.size());
+    for (size_t i = 0; i < centers.size(); ++i) {
+        glm::vec3 offset = centers[i] - viewPos;
+        dist[i] = glm::dot(offset, offset);
+    }
+    std::vector<GLuint> order(centers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](GLuint a, GLuint b) { return dist[a] > dist[b]; });
+
+    // Every quad was written as 6 indices by Chunk::updateVBOdata, copy them
+    // whole so each quad keeps the diagonal it was split along
+    SortedFaces result{chunk, version, std::vector<GLuint>()};
+    result.idx.reserve(order.size() * 6);
+    for (GLuint quad : order) {
+        result.idx.insert(result.idx.end(), quads.begin() + quad * 6, quads.begin() + quad * 6 + 6);
+    }
+
+    sortMutex->lock();
+    sorted->push_back(std::move(result));
+    sortMutex->unlock();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "scene/chunk.h"
+#include <QRunnable>
+#include <QMutex>
+
+// A back-to-front ordering of one Chunk's transparent faces
+struct SortedFaces {
+    Chunk *chunk;
+    int version;
+    std::vector<GLuint> idx;
+};
+
+class SortWorker : public QRunnable {
+private:
+    Chunk *chunk;
+    // Copied on the main thread so the Chunk can be remeshed while we sort
+    std::vector<glm::vec3> centers;
+    std::vector<GLuint> quads;
+    int version;
+    glm::vec3 viewPos;
+    QMutex *sortMutex;
+    std::vector<SortedFaces> *sorted;
+public:
+    SortWorker(Chunk *chunk, glm::vec3 viewPos, QMutex *mutex, std::vector<SortedFaces> *sorted);
+    void run() override;
+};
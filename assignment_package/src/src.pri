@@ -4,16 +4,32 @@ DEPENDPATH += $$PWD
 SOURCES += \
     $$PWD/blockworker.cpp \
     $$PWD/framebuffer.cpp \
+    $$PWD/rendertargetpool.cpp \
+    $$PWD/rendergraph.cpp \
+    $$PWD/instancerenderer.cpp \
+    $$PWD/dynamicresolution.cpp \
+    $$PWD/headless.cpp \
+    $$PWD/horizonworker.cpp \
+    $$PWD/inputtrace.cpp \
     $$PWD/main.cpp \
     $$PWD/mainwindow.cpp \
     $$PWD/mygl.cpp \
     $$PWD/noise.cpp \
+    $$PWD/noisetextures.cpp \
+    $$PWD/noiseworker.cpp \
     $$PWD/quad.cpp \
     $$PWD/scene/asset.cpp \
+    $$PWD/scene/horizon.cpp \
+    $$PWD/scene/lightengine.cpp \
     $$PWD/shaderprogram.cpp \
+    $$PWD/shadowmap.cpp \
+    $$PWD/skylut.cpp \
     $$PWD/drawable.cpp \
+    $$PWD/framegraph.cpp \
+    $$PWD/gpuprofiler.cpp \
     $$PWD/cameracontrolshelp.cpp \
     $$PWD/scene/cube.cpp \
+    $$PWD/scene/crossquad.cpp \
     $$PWD/openglcontext.cpp \
     $$PWD/scene/terrain.cpp \
     $$PWD/scene/worldaxes.cpp \
@@ -21,22 +37,46 @@ SOURCES += \
     $$PWD/scene/player.cpp \
     $$PWD/scene/camera.cpp \
     $$PWD/playerinfo.cpp \
+    $$PWD/profiler.cpp \
     $$PWD/scene/chunk.cpp \
+    $$PWD/scene/collision.cpp \
+    $$PWD/scene/blockedits.cpp \
+    $$PWD/scene/spatialhash.cpp \
+    $$PWD/scene/entitysystem.cpp \
+    $$PWD/entityworker.cpp \
+    $$PWD/sortworker.cpp \
     $$PWD/texture.cpp \
     $$PWD/vboworker.cpp
 
 HEADERS += \
     $$PWD/blockworker.h \
     $$PWD/framebuffer.h \
+    $$PWD/rendertargetpool.h \
+    $$PWD/rendergraph.h \
+    $$PWD/instancerenderer.h \
+    $$PWD/dynamicresolution.h \
+    $$PWD/headless.h \
+    $$PWD/horizonworker.h \
+    $$PWD/inputtrace.h \
     $$PWD/mainwindow.h \
     $$PWD/mygl.h \
     $$PWD/noise.h \
+    $$PWD/noisetextures.h \
+    $$PWD/noiseworker.h \
     $$PWD/quad.h \
     $$PWD/scene/asset.h \
+    $$PWD/scene/block.h \
+    $$PWD/scene/horizon.h \
+    $$PWD/scene/lightengine.h \
     $$PWD/shaderprogram.h \
+    $$PWD/shadowmap.h \
+    $$PWD/skylut.h \
     $$PWD/drawable.h \
+    $$PWD/framegraph.h \
+    $$PWD/gpuprofiler.h \
     $$PWD/cameracontrolshelp.h \
     $$PWD/scene/cube.h \
+    $$PWD/scene/crossquad.h \
     $$PWD/openglcontext.h \
     $$PWD/scene/terrain.h \
     $$PWD/scene/worldaxes.h \
@@ -46,7 +86,14 @@ HEADERS += \
     $$PWD/scene/player.h \
     $$PWD/scene/camera.h \
     $$PWD/playerinfo.h \
+    $$PWD/profiler.h \
     $$PWD/scene/chunk.h \
+    $$PWD/scene/collision.h \
+    $$PWD/scene/blockedits.h \
+    $$PWD/scene/spatialhash.h \
+    $$PWD/scene/entitysystem.h \
+    $$PWD/entityworker.h \
+    $$PWD/sortworker.h \
     $$PWD/texture.h \
     $$PWD/vboworker.h
 
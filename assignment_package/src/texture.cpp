@@ -1,6 +1,14 @@
 #include "texture.h"
 #include <QImage>
+#include <QOpenGLContext>
 #include <iostream>
+#include <algorithm>
+
+// From GL_EXT_texture_filter_anisotropic, which Qt's headers don't always define
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
 
 Texture::Texture(OpenGLContext *context)
     : glContext(context), m_textureHandle(-1), textureImage(nullptr)
@@ -62,3 +70,81 @@ GLuint Texture::getHandle() const {
 void Texture::destroy() {
     glContext->glDeleteTextures(1, &m_textureHandle);
 }
+
+TextureArray::TextureArray(OpenGLContext *context)
+    : glContext(context), m_textureHandle(-1), textureImage(nullptr), m_tilesPerRow(1)
+{}
+
+TextureArray::~TextureArray()
+{
+    destroy();
+}
+
+void TextureArray::create(const char *texturePath, int tilesPerRow) {
+    glContext->printGLErrorLog();
+
+    QImage img(texturePath);
+    if (img.isNull()) std::cerr << "Failed to load texture at path: " << texturePath << std::endl;
+    img.convertTo(QImage::Format_ARGB32);
+    img = img.mirrored();
+    textureImage = std::make_unique<QImage>(img);
+    m_tilesPerRow = tilesPerRow;
+    glContext->glGenTextures(1, &m_textureHandle);
+
+    glContext->printGLErrorLog();
+}
+
+void TextureArray::load(int texSlot, float maxAnisotropy) {
+    glContext->printGLErrorLog();
+
+    glContext->glActiveTexture(GL_TEXTURE0 + texSlot);
+    glContext->glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureHandle);
+
+    // Keep the blocky look up close but blend between mip levels at a distance.
+    // Tiles repeat so animated textures can scroll off the edge of a layer.
+    glContext->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glContext->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glContext->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glContext->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    int tileSize = textureImage->width() / m_tilesPerRow;
+    int layers = m_tilesPerRow * m_tilesPerRow;
+    glContext->glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8,
+                            tileSize, tileSize, layers,
+                            0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    for (int row = 0; row < m_tilesPerRow; ++row) {
+        for (int col = 0; col < m_tilesPerRow; ++col) {
+            QImage tile = textureImage->copy(col * tileSize, row * tileSize, tileSize, tileSize);
+            glContext->glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, col + m_tilesPerRow * row,
+                                       tileSize, tileSize, 1,
+                                       GL_BGRA, GL_UNSIGNED_BYTE, tile.constBits());
+        }
+    }
+    glContext->glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (maxAnisotropy > 0.f && ctx && ctx->hasExtension("GL_EXT_texture_filter_anisotropic")) {
+        GLfloat supported = 1.f;
+        glContext->glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &supported);
+        glContext->glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(maxAnisotropy, supported));
+    }
+
+    glContext->printGLErrorLog();
+}
+
+void TextureArray::bind(int texSlot)
+{
+    glContext->printGLErrorLog();
+    glContext->glActiveTexture(GL_TEXTURE0 + texSlot);
+    glContext->glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureHandle);
+
+    glContext->printGLErrorLog();
+}
+
+GLuint TextureArray::getHandle() const {
+    return m_textureHandle;
+}
+
+void TextureArray::destroy() {
+    glContext->glDeleteTextures(1, &m_textureHandle);
+}
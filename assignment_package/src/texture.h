@@ -22,3 +22,30 @@ public:
     GLuint getHandle() const;
 
 };
+
+// A texture atlas split into a GL_TEXTURE_2D_ARRAY with one layer per tile.
+// Every tile gets its own mipmap chain, so distant faces are filtered
+// without bleeding into the neighboring tiles of the atlas.
+class TextureArray
+{
+private:
+    OpenGLContext* glContext;
+    GLuint m_textureHandle;
+    std::unique_ptr<QImage> textureImage;
+    // Number of tiles along each side of the atlas
+    int m_tilesPerRow;
+
+public:
+    TextureArray(OpenGLContext* context);
+    ~TextureArray();
+
+    void create(const char *texturePath, int tilesPerRow);
+    // Uploads the tiles as layers (column + tilesPerRow * row, counting rows
+    // from the bottom) and builds their mipmaps. Anisotropic filtering up to
+    // maxAnisotropy is used when the driver supports it, 0 turns it off.
+    void load(int texSlot, float maxAnisotropy = 8.f);
+    void bind(int texSlot);
+    void destroy();
+
+    GLuint getHandle() const;
+};
@@ -1,12 +1,14 @@
 #include "vboworker.h"
+#include "profiler.h"
 
-VBOWorker::VBOWorker(Chunk* chunk, QMutex * mutex, std::vector<Chunk*> *bindToGPU)
-    : chunk(chunk), vboMutex(mutex), bindToGPU(bindToGPU)
+VBOWorker::VBOWorker(Chunk* chunk, int levels, QMutex * mutex, std::vector<Chunk*> *bindToGPU)
+    : chunk(chunk), levels(levels), vboMutex(mutex), bindToGPU(bindToGPU)
 {}
 
 void VBOWorker::run() {
+    PROFILE_SCOPE("mesh chunk");
     try {
-        chunk->generateVBOdata();
+        chunk->generateVBOdata(levels);
         vboMutex->lock();
         bindToGPU->push_back(chunk);
         vboMutex->unlock();
@@ -6,10 +6,11 @@
 class VBOWorker : public QRunnable {
 private:
     Chunk *chunk;
+    int levels; // The meshes to build, see MESH_FULL
     QMutex *vboMutex;
     std::vector<Chunk*> *bindToGPU;
 public:
-    VBOWorker(Chunk *chunk, QMutex *mutex, std::vector<Chunk*> *bindToGPU);
+    VBOWorker(Chunk *chunk, int levels, QMutex *mutex, std::vector<Chunk*> *bindToGPU);
     void run() override;
 };
 